@@ -0,0 +1,148 @@
+// Micro-benchmark: case-insensitive substring search on DN- and username-sized
+// inputs. Compares the original byte-at-a-time ci_contains loop with the
+// scalar and dispatched (SSE2/AVX2) ci_search paths, and cross-checks results.
+#include "ci_search.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SAMPLE_COUNT 4096
+#define REPETITIONS 5
+
+// Original ldap_insights.c implementation
+static int naive_ci_contains(const char *haystack, const char *needle) {
+    if (!haystack || !needle) return 0;
+    size_t hlen = strlen(haystack);
+    size_t nlen = strlen(needle);
+    if (nlen == 0 || hlen < nlen) return 0;
+    for (size_t i = 0; i <= hlen - nlen; i++) {
+        size_t j = 0;
+        while (j < nlen && tolower((unsigned char)haystack[i + j]) == tolower((unsigned char)needle[j])) {
+            j++;
+        }
+        if (j == nlen) return 1;
+    }
+    return 0;
+}
+
+static int scalar_ci_contains(const char *haystack, const char *needle) {
+    size_t nlen = strlen(needle);
+    if (nlen == 0) return 0;
+    return ci_search_scalar(haystack, strlen(haystack), needle, nlen) != NULL;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static const char *ous[] = { "Users", "Service Accounts", "IT", "Finance", "Tier0", "Workstations" };
+static const char *words[] = { "alice", "Bob", "svc", "SQL", "backup", "HelpDesk", "jsmith", "Exchange" };
+
+static void make_dn(char *buf, size_t len, unsigned seed) {
+    snprintf(buf, len, "CN=%s.%s%u,OU=%s,OU=%s,DC=corp,DC=example,DC=local",
+             words[seed % 8], words[(seed / 8) % 8], seed,
+             ous[seed % 6], ous[(seed / 6) % 6]);
+}
+
+static void make_username(char *buf, size_t len, unsigned seed) {
+    snprintf(buf, len, "%s_%s%u", words[seed % 8], words[(seed / 8) % 8], seed % 1000);
+}
+
+typedef int (*ContainsFn)(const char *, const char *);
+
+static double run(ContainsFn fn, char **inputs, const char *needle, int rounds, long *hits) {
+    double start = now_seconds();
+    long found = 0;
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < SAMPLE_COUNT; i++) {
+            found += fn(inputs[i], needle);
+        }
+    }
+    *hits = found;
+    return now_seconds() - start;
+}
+
+static int bench_set(const char *label, char **inputs, const char *needle, int rounds) {
+    ContainsFn fns[] = { naive_ci_contains, scalar_ci_contains, ci_contains };
+    const char *names[] = { "naive", "scalar", "simd" };
+    long hits[3];
+    double secs[3];
+
+    // Interleave repetitions and keep the best time to damp scheduler noise
+    for (int f = 0; f < 3; f++) secs[f] = -1.0;
+    for (int rep = 0; rep < REPETITIONS; rep++) {
+        for (int f = 0; f < 3; f++) {
+            double t = run(fns[f], inputs, needle, rounds, &hits[f]);
+            if (secs[f] < 0 || t < secs[f]) secs[f] = t;
+        }
+    }
+    double calls = (double)rounds * SAMPLE_COUNT;
+    for (int f = 0; f < 3; f++) {
+        printf("%-10s %-10s needle=%-12s %8.1f ns/call  %5.2fx  hits=%ld\n",
+               label, names[f], needle, secs[f] * 1e9 / calls, secs[0] / secs[f], hits[f]);
+    }
+    if (hits[1] != hits[0] || hits[2] != hits[0]) {
+        fprintf(stderr, "result mismatch for %s/%s\n", label, needle);
+        return 1;
+    }
+    return 0;
+}
+
+// Compare every implementation on random short strings over a small alphabet
+static int cross_check(void) {
+    const char alphabet[] = "aAbB-=,.sS";
+    char hay[200];
+    char needle[8];
+    srand(1);
+    for (int t = 0; t < 200000; t++) {
+        size_t hlen = (size_t)(rand() % 199);
+        size_t nlen = (size_t)(rand() % 7);
+        for (size_t i = 0; i < hlen; i++) hay[i] = alphabet[rand() % 10];
+        for (size_t i = 0; i < nlen; i++) needle[i] = alphabet[rand() % 10];
+        hay[hlen] = '\0';
+        needle[nlen] = '\0';
+        if (naive_ci_contains(hay, needle) != ci_contains(hay, needle) ||
+            naive_ci_contains(hay, needle) != scalar_ci_contains(hay, needle)) {
+            fprintf(stderr, "cross-check mismatch: '%s' in '%s'\n", needle, hay);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 50;
+    if (rounds <= 0) rounds = 50;
+
+    if (cross_check() != 0) return 1;
+
+    char **dns = calloc(SAMPLE_COUNT, sizeof(char *));
+    char **names = calloc(SAMPLE_COUNT, sizeof(char *));
+    if (!dns || !names) return 1;
+    for (unsigned i = 0; i < SAMPLE_COUNT; i++) {
+        dns[i] = malloc(160);
+        names[i] = malloc(48);
+        if (!dns[i] || !names[i]) return 1;
+        make_dn(dns[i], 160, i * 2654435761u >> 8);
+        make_username(names[i], 48, i * 40503u);
+    }
+
+    int rc = 0;
+    rc |= bench_set("dn", dns, "service", rounds);
+    rc |= bench_set("dn", dns, "tier0", rounds);
+    rc |= bench_set("dn", dns, "zzz", rounds);
+    rc |= bench_set("username", names, "service", rounds);
+    rc |= bench_set("username", names, "svc", rounds);
+
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        free(dns[i]);
+        free(names[i]);
+    }
+    free(dns);
+    free(names);
+    return rc;
+}
@@ -0,0 +1,237 @@
+// Benchmark: export a synthetic directory of 1M users (by default) to CSV with
+// the original fprintf exporter and with the buffered export_to_csv and
+// export_to_csv_group_rows, writing to /dev/null so formatting is what is
+// timed (best of ROUNDS). A smaller export is then written to a temporary
+// file and parsed back as RFC 4180 to check every field.
+#include "export.h"
+#include "group_table.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GROUP_COUNT 2000
+#define MAX_GROUPS_PER_USER 8
+#define CHECK_USERS 20000
+#define ROUNDS 3
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned int next_random(unsigned int *state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+static const char *safe_str(const char *s) {
+    return (s && strlen(s) > 0) ? s : "N/A";
+}
+
+// Original export.c implementation
+static void legacy_export_to_csv(const char *filename, ADUser *users, int count) {
+    FILE *fp = fopen(filename, "w");
+    if (!fp) {
+        perror("[ERROR] fopen failed");
+        return;
+    }
+
+    fprintf(fp, "Username,CN,Email,Groups,IsAdmin,CanResetPass,CanModifyACL,CanDelegate,HasServiceAcct,CanReadSecrets,CanWriteSecrets,Risk\n");
+    for (int i = 0; i < count; i++) {
+        fprintf(fp, "%s,%s,%s,",
+                safe_str(users[i].username),
+                safe_str(users[i].cn),
+                safe_str(users[i].mail));
+        if (users[i].group_count > 0) {
+            group_table_write(fp, users[i].group_ids, users[i].group_count, ",");
+        } else {
+            fputs(safe_str(NULL), fp);
+        }
+        fprintf(fp, ",%d,%d,%d,%d,%d,%d,%d,%d\n",
+                users[i].perms.isAdmin,
+                users[i].perms.canResetPasswords,
+                users[i].perms.canModifyACLs,
+                users[i].perms.canDelegateAuth,
+                users[i].perms.hasServiceAcct,
+                users[i].perms.canReadSecrets,
+                users[i].perms.canWriteSecrets,
+                users[i].risk);
+    }
+
+    fclose(fp);
+}
+
+// Read one RFC 4180 field starting at *p into out; returns the byte that ended
+// it (',', '\r' of CRLF, or '\0' at end of input), -1 if malformed
+static int parse_field(const char **p, char *out, size_t cap) {
+    const char *s = *p;
+    size_t n = 0;
+    if (*s == '"') {
+        s++;
+        for (;;) {
+            if (*s == '\0') return -1;
+            if (*s == '"') {
+                if (s[1] != '"') break;
+                s++;
+            }
+            if (n + 1 < cap) out[n++] = *s;
+            s++;
+        }
+        s++;
+    } else {
+        while (*s && *s != ',' && *s != '\r' && *s != '\n' && *s != '"') {
+            if (n + 1 < cap) out[n++] = *s;
+            s++;
+        }
+    }
+    out[n] = '\0';
+    int end = (unsigned char)*s;
+    if (end == ',') {
+        s++;
+    } else if (end == '\r' && s[1] == '\n') {
+        s += 2;
+    } else if (end != '\0') {
+        return -1;
+    }
+    *p = s;
+    return end;
+}
+
+static int check_export(const char *path, ADUser *users, int count) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *text = malloc((size_t)size + 1);
+    if (!text || fread(text, 1, (size_t)size, fp) != (size_t)size) {
+        fclose(fp);
+        free(text);
+        return -1;
+    }
+    fclose(fp);
+    text[size] = '\0';
+
+    const char *p = text;
+    char field[4096];
+    char expected[4096];
+    int rc = 0;
+    for (int row = -1; row < count && rc == 0; row++) {
+        for (int col = 0; col < 12; col++) {
+            int end = parse_field(&p, field, sizeof(field));
+            if (end != (col == 11 ? '\r' : ',')) {
+                rc = -1;
+                break;
+            }
+            if (row < 0) continue;
+            const ADUser *u = &users[row];
+            if (col == 0) snprintf(expected, sizeof(expected), "%s", safe_str(u->username));
+            if (col == 1) snprintf(expected, sizeof(expected), "%s", safe_str(u->cn));
+            if (col == 2) snprintf(expected, sizeof(expected), "%s", safe_str(u->mail));
+            if (col == 3) {
+                char *joined = group_table_join(u->group_ids, u->group_count, ";");
+                snprintf(expected, sizeof(expected), "%s", safe_str(joined));
+                free(joined);
+            }
+            if (col == 11) snprintf(expected, sizeof(expected), "%d", u->risk);
+            if ((col < 4 || col == 11) && strcmp(field, expected) != 0) rc = -1;
+        }
+    }
+    if (rc == 0 && *p != '\0') rc = -1;
+    free(text);
+    return rc;
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (count <= 0) count = 1000000;
+
+    // Group DNs carry commas, and some names quotes, so every Groups cell
+    // needs RFC 4180 quoting
+    char dn[128];
+    for (int g = 0; g < GROUP_COUNT; g++) {
+        int len = g % 100 == 0 ? snprintf(dn, sizeof(dn), "CN=\"Legacy\" Group %d,OU=Groups,DC=corp,DC=example,DC=local", g)
+                               : snprintf(dn, sizeof(dn), "CN=Group %d,OU=Groups,DC=corp,DC=example,DC=local", g);
+        group_table_intern(dn, (size_t)len);
+    }
+
+    ADUser *users = calloc((size_t)count, sizeof(ADUser));
+    int *ids = malloc((size_t)count * MAX_GROUPS_PER_USER * sizeof(int));
+    char *names = malloc((size_t)count * 48);
+    if (!users || !ids || !names) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    unsigned int seed = 42;
+    long memberships = 0;
+    long group_row_count = 0;
+    for (int i = 0; i < count; i++) {
+        char *name = names + (size_t)i * 48;
+        snprintf(name, 16, "user%d", i);
+        snprintf(name + 16, 32, "user%d@corp.example", i);
+        users[i].username = name;
+        users[i].cn = i % 1000 == 0 ? "Smith, John" : name;
+        users[i].mail = i % 7 == 0 ? NULL : name + 16;
+        users[i].group_ids = ids + (size_t)i * MAX_GROUPS_PER_USER;
+        users[i].group_count = (int)(next_random(&seed) % (MAX_GROUPS_PER_USER + 1));
+        for (int g = 0; g < users[i].group_count; g++) {
+            users[i].group_ids[g] = (int)(next_random(&seed) % GROUP_COUNT);
+        }
+        users[i].perms.isAdmin = i % 50 == 0;
+        users[i].perms.hasServiceAcct = i % 20 == 0;
+        users[i].risk = (int)(next_random(&seed) % 101);
+        memberships += users[i].group_count;
+        group_row_count += users[i].group_count > 0 ? users[i].group_count : 1;
+    }
+    printf("%d users, %ld memberships, %d groups\n", count, memberships, GROUP_COUNT);
+
+    // export_to_csv reports on stdout; keep the table readable
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    if (!freopen("/dev/null", "w", stdout)) return 1;
+
+    // Best of a few rounds, interleaved so a noisy neighbour hits every variant
+    double legacy = 0, buffered = 0, group_rows = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        double start = now_seconds();
+        legacy_export_to_csv("/dev/null", users, count);
+        double elapsed = now_seconds() - start;
+        if (round == 0 || elapsed < legacy) legacy = elapsed;
+
+        start = now_seconds();
+        export_to_csv("/dev/null", users, count);
+        elapsed = now_seconds() - start;
+        if (round == 0 || elapsed < buffered) buffered = elapsed;
+
+        start = now_seconds();
+        export_to_csv_group_rows("/dev/null", users, count);
+        elapsed = now_seconds() - start;
+        if (round == 0 || elapsed < group_rows) group_rows = elapsed;
+    }
+
+    const char *tmpdir = getenv("TMPDIR");
+    char path[512];
+    snprintf(path, sizeof(path), "%s/aclguard_csv_bench.%d.csv", tmpdir && tmpdir[0] ? tmpdir : "/tmp", (int)getpid());
+    int check_count = count < CHECK_USERS ? count : CHECK_USERS;
+    export_to_csv(path, users, check_count);
+    int check = check_export(path, users, check_count);
+    remove(path);
+
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+
+    printf("%-16s %8.1f ms  %6.2f M rows/s\n", "legacy fprintf", legacy * 1e3, count / legacy / 1e6);
+    printf("%-16s %8.1f ms  %6.2f M rows/s  %5.2fx\n", "buffered", buffered * 1e3, count / buffered / 1e6, legacy / buffered);
+    printf("%-16s %8.1f ms  %6.2f M rows/s  (%ld rows)\n", "group rows", group_rows * 1e3,
+           (double)group_row_count / group_rows / 1e6, group_row_count);
+    if (check != 0) {
+        fprintf(stderr, "buffered export does not parse back as RFC 4180\n");
+        return 1;
+    }
+    printf("RFC 4180 round trip OK (%d users)\n", check_count);
+    return 0;
+}
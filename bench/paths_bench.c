@@ -0,0 +1,98 @@
+// Benchmark: build the attack graph of a synthetic forest with 500k nodes (by
+// default) and a few million membership and ACE edges, then answer the
+// all-users shortest-path query to a Tier-0 group set. Every reported path is
+// walked and checked against the distances.
+#include "attack_graph.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define GROUP_SHARE 10        // One node in ten is a group
+#define MEMBERSHIPS_PER_USER 6
+#define NESTING_PER_GROUP 2
+#define ACE_EDGES_PER_USER 1
+#define TIER0_GROUPS 4
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned int next_random(unsigned int *state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+int main(int argc, char *argv[]) {
+    int nodes = argc > 1 ? atoi(argv[1]) : 500000;
+    if (nodes < 100) nodes = 500000;
+    int groups = nodes / GROUP_SHARE;
+    int users = nodes - groups;
+
+    // Users first, then groups; the first groups form Tier-0. Groups nest only
+    // into groups with a lower index, as real tiering does, plus a few cycles.
+    double start = now_seconds();
+    AttackGraph graph;
+    attack_graph_init(&graph, nodes);
+    unsigned int seed = 7;
+    for (int u = 0; u < users; u++) {
+        for (int m = 0; m < MEMBERSHIPS_PER_USER; m++) {
+            int group = TIER0_GROUPS + (int)(next_random(&seed) % (unsigned int)(groups - TIER0_GROUPS));
+            if (attack_graph_add_edge(&graph, u, users + group, ATTACK_EDGE_MEMBER_OF) != 0) return 1;
+        }
+        for (int a = 0; a < ACE_EDGES_PER_USER; a++) {
+            int target = (int)(next_random(&seed) % (unsigned int)users);
+            if (attack_graph_add_edge(&graph, u, target, 1u << (next_random(&seed) % 8)) != 0) return 1;
+        }
+    }
+    for (int g = 1; g < groups; g++) {
+        for (int n = 0; n < NESTING_PER_GROUP; n++) {
+            int parent = (int)(next_random(&seed) % (unsigned int)g);
+            if (g % 1000 == 0 && n == 0) parent = g + 1 < groups ? g + 1 : 0;
+            if (attack_graph_add_edge(&graph, users + g, users + parent, ATTACK_EDGE_MEMBER_OF) != 0) return 1;
+        }
+    }
+    long edges = graph.edge_count;
+    if (attack_graph_finish(&graph) != 0) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    double build = now_seconds() - start;
+
+    int targets[TIER0_GROUPS];
+    for (int t = 0; t < TIER0_GROUPS; t++) targets[t] = users + t;
+    AttackPaths paths;
+    start = now_seconds();
+    if (attack_graph_paths(&graph, targets, TIER0_GROUPS, &paths) != 0) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    double query = now_seconds() - start;
+
+    // Each hop must lower the distance by exactly one and end at a target
+    int rc = 0;
+    long hops = 0;
+    int reachable_users = 0;
+    for (int u = 0; u < users && rc == 0; u++) {
+        if (paths.dist[u] < 0) continue;
+        reachable_users++;
+        int node = u;
+        while (paths.next[node] >= 0) {
+            if (paths.dist[paths.next[node]] != paths.dist[node] - 1) rc = 1;
+            node = paths.next[node];
+            hops++;
+        }
+        if (paths.dist[node] != 0) rc = 1;
+    }
+    if (rc != 0) fprintf(stderr, "inconsistent path\n");
+
+    printf("%d nodes (%d users, %d groups), %ld edges\n", nodes, users, groups, edges);
+    printf("%-16s %8.1f ms\n", "build (CSR)", build * 1e3);
+    printf("%-16s %8.1f ms  %d users reach Tier-0, %.2f hops on average\n", "all-users BFS", query * 1e3,
+           reachable_users, reachable_users > 0 ? (double)hops / reachable_users : 0.0);
+
+    attack_paths_free(&paths);
+    attack_graph_free(&graph);
+    return rc;
+}
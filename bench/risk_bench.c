@@ -0,0 +1,114 @@
+// Benchmark: score a synthetic directory of 1M users (by default) with the
+// per-user path and with risk_score_batch() on pools of 1..8 threads, and check that
+// every run produces the same scores.
+#include "classifier.h"
+#include "group_table.h"
+#include "risk_engine.h"
+#include "thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define GROUP_COUNT 2000
+#define MAX_GROUPS_PER_USER 24
+
+static const char *group_names[] = {
+    "Domain Admins", "Help Desk", "Backup Operators", "SQL Service", "Delegation Admins",
+    "Read Secret Vault", "Write Secret Vault", "Finance", "Engineering", "Sales"
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned int next_random(unsigned int *state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+static long checksum(const ADUser *users, int count) {
+    long sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum = sum * 31 + users[i].risk * 257 + (long)user_perm_bits(&users[i]);
+    }
+    return sum;
+}
+
+static void clear_scores(ADUser *users, int count) {
+    for (int i = 0; i < count; i++) {
+        users[i].risk = 0;
+        apply_perm_bits(&users[i], 0);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (count <= 0) count = 1000000;
+
+    // Most groups are benign; every tenth matches one of the built-in rules
+    char dn[128];
+    for (int g = 0; g < GROUP_COUNT; g++) {
+        const char *name = g % 10 == 0 ? group_names[(g / 10) % 7] : group_names[7 + g % 3];
+        int len = snprintf(dn, sizeof(dn), "CN=%s %d,OU=Groups,DC=corp,DC=example,DC=local", name, g);
+        group_table_intern(dn, (size_t)len);
+    }
+
+    ADUser *users = calloc((size_t)count, sizeof(ADUser));
+    int *ids = malloc((size_t)count * MAX_GROUPS_PER_USER * sizeof(int));
+    if (!users || !ids) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    unsigned int seed = 42;
+    long memberships = 0;
+    for (int i = 0; i < count; i++) {
+        users[i].username = (i % 50 == 0) ? "svc_backup" : "user";
+        users[i].group_ids = ids + (size_t)i * MAX_GROUPS_PER_USER;
+        users[i].group_count = (int)(next_random(&seed) % MAX_GROUPS_PER_USER);
+        for (int g = 0; g < users[i].group_count; g++) {
+            users[i].group_ids[g] = (int)(next_random(&seed) % GROUP_COUNT);
+        }
+        memberships += users[i].group_count;
+    }
+    printf("%d users, %ld memberships, %d groups\n", count, memberships, GROUP_COUNT);
+
+    RiskModel model;
+    risk_model_default(&model);
+
+    classifier_reset_cache();
+    double start = now_seconds();
+    for (int i = 0; i < count; i++) {
+        risk_score_user(&users[i], &model);
+    }
+    double per_user = now_seconds() - start;
+    long expected = checksum(users, count);
+    printf("%-16s %8.1f ms  %7.1f ns/user\n", "per-user", per_user * 1e3, per_user * 1e9 / count);
+
+    int rc = 0;
+    int thread_counts[] = {1, 2, 4, 8};
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        clear_scores(users, count);
+        classifier_reset_cache();
+        thread_pool_init(thread_counts[t]);
+        start = now_seconds();
+        if (risk_score_batch(users, count, &model) != 0) {
+            fprintf(stderr, "batch scoring failed\n");
+            return 1;
+        }
+        double secs = now_seconds() - start;
+        char label[32];
+        snprintf(label, sizeof(label), "batch x%d", thread_counts[t]);
+        printf("%-16s %8.1f ms  %7.1f ns/user  %5.2fx\n", label, secs * 1e3, secs * 1e9 / count, per_user / secs);
+        if (checksum(users, count) != expected) {
+            fprintf(stderr, "score mismatch with %d threads\n", thread_counts[t]);
+            rc = 1;
+        }
+    }
+
+    free(ids);
+    free(users);
+    return rc;
+}
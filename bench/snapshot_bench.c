@@ -0,0 +1,133 @@
+// Benchmark: save a synthetic directory of 1M users (by default) as a snapshot,
+// then time opening it (mmap plus the bounds check of every offset) and the
+// column reductions status-style summaries run, against building the same
+// user store from the in-memory users. Every user is checked after the round
+// trip.
+#include "classifier.h"
+#include "group_table.h"
+#include "snapshot.h"
+#include "user_store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GROUP_COUNT 2000
+#define MAX_GROUPS_PER_USER 8
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned int next_random(unsigned int *state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+static int same_string(const char *a, const char *b) {
+    return (!a && !b) || (a && b && strcmp(a, b) == 0);
+}
+
+static int check_snapshot(const Snapshot *snap, const ADUser *users, const uint8_t *detections, int count) {
+    if (snap->store.count != count || snap->group_count != group_table_count()) return -1;
+    for (int i = 0; i < count; i++) {
+        ADUser view;
+        user_store_view(&snap->store, i, &view);
+        const ADUser *u = &users[i];
+        if (!same_string(view.username, u->username) || !same_string(view.cn, u->cn) ||
+            !same_string(view.dn, u->dn) || !same_string(view.guid, u->guid) || !same_string(view.mail, u->mail) ||
+            view.risk != u->risk || user_perm_bits(&view) != user_perm_bits(u) ||
+            snap->detections[i] != detections[i] || view.group_count != u->group_count) {
+            return -1;
+        }
+        for (int g = 0; g < u->group_count; g++) {
+            if (strcmp(snapshot_group_name(snap, view.group_ids[g]), group_table_name(u->group_ids[g])) != 0) return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (count <= 0) count = 1000000;
+
+    char dn[128];
+    for (int g = 0; g < GROUP_COUNT; g++) {
+        int len = snprintf(dn, sizeof(dn), "CN=Group %d,OU=Groups,DC=corp,DC=example,DC=local", g);
+        group_table_intern(dn, (size_t)len);
+    }
+
+    ADUser *users = calloc((size_t)count, sizeof(ADUser));
+    int *ids = malloc((size_t)count * MAX_GROUPS_PER_USER * sizeof(int));
+    char *names = malloc((size_t)count * 112);
+    uint8_t *detections = malloc((size_t)count);
+    if (!users || !ids || !names || !detections) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    unsigned int seed = 7;
+    for (int i = 0; i < count; i++) {
+        char *name = names + (size_t)i * 112;
+        snprintf(name, 16, "user%07d", i);
+        snprintf(name + 16, 32, "user%07d@corp.example", i);
+        snprintf(name + 48, 64, "CN=user%07d,OU=Users,DC=corp,DC=example,DC=local", i);
+        users[i].username = name;
+        users[i].cn = name;
+        users[i].mail = i % 7 == 0 ? NULL : name + 16;
+        users[i].dn = name + 48;
+        users[i].group_ids = ids + (size_t)i * MAX_GROUPS_PER_USER;
+        users[i].group_count = (int)(next_random(&seed) % (MAX_GROUPS_PER_USER + 1));
+        for (int g = 0; g < users[i].group_count; g++) {
+            users[i].group_ids[g] = (int)(next_random(&seed) % GROUP_COUNT);
+        }
+        users[i].perms.isAdmin = i % 50 == 0;
+        users[i].perms.hasServiceAcct = i % 20 == 0;
+        users[i].risk = (int)(next_random(&seed) % 101);
+        detections[i] = (uint8_t)(next_random(&seed) % 8);
+    }
+
+    const char *tmpdir = getenv("TMPDIR");
+    char path[512];
+    snprintf(path, sizeof(path), "%s/aclguard_snapshot_bench.%d.snap", tmpdir && tmpdir[0] ? tmpdir : "/tmp", (int)getpid());
+
+    double start = now_seconds();
+    UserStore store;
+    if (user_store_build(&store, users, count, USER_STORE_ALL) != 0) return 1;
+    double build = now_seconds() - start;
+    start = now_seconds();
+    int written = snapshot_write(path, &store, detections, "2026-01-01T00:00:00Z");
+    double write = now_seconds() - start;
+    user_store_free(&store);
+    if (written != 0) return 1;
+
+    start = now_seconds();
+    Snapshot snap;
+    if (snapshot_open(path, &snap) != 0) return 1;
+    double open = now_seconds() - start;
+
+    start = now_seconds();
+    int admins = user_store_count_any(&snap.store, PERM_ADMIN);
+    int high_risk = user_store_count_risk_at_least(&snap.store, 60);
+    long flagged = 0;
+    for (int i = 0; i < snap.store.count; i++) flagged += snap.detections[i] != 0;
+    double reduce = now_seconds() - start;
+
+    int check = check_snapshot(&snap, users, detections, count);
+    snapshot_close(&snap);
+    remove(path);
+
+    printf("%d users: %d admins, %d high risk, %ld flagged\n", count, admins, high_risk, flagged);
+    printf("%-22s %8.1f ms\n", "store from users", build * 1e3);
+    printf("%-22s %8.1f ms\n", "snapshot write", write * 1e3);
+    printf("%-22s %8.1f ms\n", "snapshot open", open * 1e3);
+    printf("%-22s %8.1f ms\n", "reduce mapped columns", reduce * 1e3);
+    if (check != 0) {
+        fprintf(stderr, "snapshot does not match the users it was written from\n");
+        return 1;
+    }
+    printf("Snapshot round trip OK\n");
+    return 0;
+}
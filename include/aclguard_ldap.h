@@ -4,7 +4,11 @@
 #include "config.h"
 #include "types.h"
 
-// Fetch users from LDAP
-ADUser *fetch_real_users(const Config *config, int *count_out);
+// Fetch users from LDAP; stats may be NULL. Release the result with
+// release_real_users().
+ADUser *fetch_real_users(const Config *config, int *count_out, ScanStats *stats);
+
+// Free a fetch_real_users() result and every string and group list it references
+void release_real_users(ADUser *users);
 
 #endif
@@ -0,0 +1,36 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bump allocator with chunked growth. Everything allocated from an arena is
+// released together by arena_destroy(); individual blocks are never freed.
+// An arena is not thread-safe: give each thread its own and merge them.
+
+typedef struct ArenaChunk ArenaChunk;
+
+typedef struct {
+    ArenaChunk *head;     // Current chunk; older chunks follow via next
+    size_t next_size;     // Size of the next regular chunk
+    size_t bytes_used;    // Bytes handed out, alignment padding included
+    size_t bytes_reserved;// Bytes obtained from malloc for chunks
+    long allocations;     // Blocks handed out
+    long chunks;          // Chunks obtained from malloc
+} Arena;
+
+void arena_init(Arena *arena);
+
+// Allocate size bytes aligned for any scalar type; NULL on allocation failure
+void *arena_alloc(Arena *arena, size_t size);
+
+// Copy len bytes of s plus a terminating NUL
+char *arena_strndup(Arena *arena, const char *s, size_t len);
+char *arena_strdup(Arena *arena, const char *s);
+
+// Move every chunk of src into dst and reset src
+void arena_merge(Arena *dst, Arena *src);
+
+// Release every chunk and reset the arena for reuse
+void arena_destroy(Arena *arena);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef ATTACK_GRAPH_H
+#define ATTACK_GRAPH_H
+
+// Directed graph of principals for attack-path queries. An edge from -> to
+// means control of from yields control of to: a user or group is a member of
+// group to, holds dangerous ACE rights over object to, or from is a container
+// whose control reaches object to beneath it. Edges are staged with
+// attack_graph_add_edge() and packed into compressed sparse rows (CSR) by
+// attack_graph_finish(); queries then touch only flat arrays.
+
+// Edge labels of a membership and of a container holding an object; any
+// other label is the PERM_* bits of ACE rights
+#define ATTACK_EDGE_MEMBER_OF 0u
+#define ATTACK_EDGE_CONTAINS (1u << 31)
+
+typedef struct {
+    int node_count;
+    long edge_count;
+    long edge_cap;
+    int *edge_from;          // Staged edges, freed by attack_graph_finish()
+    int *edge_to;
+    unsigned int *edge_label;
+    long *in_start;          // CSR of reversed edges: edges into v are
+    int *in_from;            // in_from/in_label[in_start[v] .. in_start[v + 1])
+    unsigned int *in_label;
+} AttackGraph;
+
+// Shortest paths from every node to the nearest target
+typedef struct {
+    int *dist;               // Hops to the nearest target, 0 at targets, -1 if unreachable
+    int *next;               // Next node on a shortest path, -1 at targets and unreachable nodes
+    unsigned int *label;     // Label of the edge node -> next
+    int reachable;           // Non-target nodes with a path
+} AttackPaths;
+
+// Empty graph over nodes 0 .. node_count - 1. Returns 0, -1 on allocation failure.
+int attack_graph_init(AttackGraph *graph, int node_count);
+
+// Stage the edge from -> to; out-of-range nodes are ignored. Returns 0, -1 on
+// allocation failure.
+int attack_graph_add_edge(AttackGraph *graph, int from, int to, unsigned int label);
+
+// Pack the staged edges into CSR form. Edges into a node keep the order they
+// were added in, so queries are deterministic. Returns 0, -1 on allocation failure.
+int attack_graph_finish(AttackGraph *graph);
+
+// One multi-source BFS over the reversed edges from every target at once:
+// fills the distance and next hop of every node. Returns 0, -1 on allocation failure.
+int attack_graph_paths(const AttackGraph *graph, const int *targets, int target_count, AttackPaths *paths);
+
+void attack_paths_free(AttackPaths *paths);
+void attack_graph_free(AttackGraph *graph);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef CI_SEARCH_H
+#define CI_SEARCH_H
+
+#include <stddef.h>
+
+// ASCII case-insensitive string search. On x86 the scan is vectorized (AVX2
+// when the CPU supports it, SSE2 otherwise); other targets use a scalar loop.
+
+// ASCII lower-case folding table ('A'-'Z' -> 'a'-'z', all other bytes unchanged)
+extern const unsigned char ci_fold_table[256];
+
+// First case-insensitive occurrence of needle in haystack, or NULL. An empty
+// needle matches at the start of haystack.
+const char *ci_search(const char *haystack, size_t hlen, const char *needle, size_t nlen);
+
+// 1 if needle occurs in haystack ignoring ASCII case; NULL strings never match
+int ci_contains(const char *haystack, const char *needle);
+
+// 1 if str starts with prefix ignoring ASCII case
+int ci_starts_with(const char *str, const char *prefix);
+
+// Portable reference implementation used for short inputs and tails
+const char *ci_search_scalar(const char *haystack, size_t hlen, const char *needle, size_t nlen);
+
+#endif
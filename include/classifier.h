@@ -0,0 +1,58 @@
+#ifndef CLASSIFIER_H
+#define CLASSIFIER_H
+
+#include "types.h"
+
+// Permission bits, one per ADUser.perms flag
+#define PERM_ADMIN          (1u << 0)
+#define PERM_RESET_PASSWORD (1u << 1)
+#define PERM_MODIFY_ACL     (1u << 2)
+#define PERM_DELEGATE_AUTH  (1u << 3)
+#define PERM_SERVICE_ACCT   (1u << 4)
+#define PERM_PRIVILEGED     (1u << 5)
+#define PERM_READ_SECRETS   (1u << 6)
+#define PERM_WRITE_SECRETS  (1u << 7)
+#define PERM_COUNT          8
+
+// Classification outcome for a single group
+typedef struct {
+    unsigned int perms; // PERM_* bits granted by membership
+    int risk;           // Risk contribution of the membership
+} GroupVerdict;
+
+// Classify one group DN against the group-name rules. Rules match the group's
+// CN (the leaf RDN value), so the OUs and containers above it cannot make a
+// group privileged; a name that is not a DN is matched whole. The rule
+// patterns are compiled into one automaton on first use and matched in a
+// single pass.
+void classify_group(const char *group, GroupVerdict *verdict);
+
+// Replace the built-in rules with a JSON rule pack compiled into a decision
+// table. Call before scanning; returns 0 on success.
+int classifier_load_rules(const char *path);
+
+// Cached verdict for a group ID, classifying the group on first use. Each
+// distinct group is classified once per scan; later lookups are cache hits.
+void classifier_lookup(int id, GroupVerdict *out);
+
+// Copy of the verdicts of every interned group, indexed by group ID, with
+// unseen groups classified first. Lets batch scoring run without the cache
+// lock. Caller frees; NULL on allocation failure.
+GroupVerdict *classifier_verdict_table(int *count_out);
+
+// Count memberships scored from a verdict table as cache hits
+void classifier_record_hits(long hits);
+
+// Set the ADUser.perms flags from PERM_* bits
+void apply_perm_bits(ADUser *user, unsigned int perms);
+
+// PERM_* bits of the ADUser.perms flags (inverse of apply_perm_bits)
+unsigned int user_perm_bits(const ADUser *user);
+
+// Forget all cached group verdicts and zero the hit/miss counters
+void classifier_reset_cache(void);
+
+// Group verdict cache hit/miss counters since the last reset
+void classifier_cache_stats(long *hits, long *misses);
+
+#endif
@@ -7,6 +7,12 @@ typedef struct {
     char *bind_dn;   // Bind DN for authentication
     char *bind_pw;   // Bind password
     char *base_dn;   // Base DN for searches
+    int page_size;   // Paged results page size (0 = single unpaged search)
+    int scan_workers; // Parallel partition workers (1 = single connection)
+    int delta_scan;  // Fetch only objects changed since the stored USN high-water mark
+    char *state_dir; // Directory holding per-target delta scan state
+    int threads;     // Classification/detection threads (1 = single-threaded)
+    char *snapshot_file; // Save the scan here once it finishes ("" = don't)
 } Config;
 
 // Environment variable names
@@ -14,12 +20,24 @@ typedef struct {
 #define ENV_BIND_DN  "ACLGUARD_BIND_DN"
 #define ENV_BIND_PW  "ACLGUARD_BIND_PW"
 #define ENV_BASE_DN  "ACLGUARD_BASE_DN"
+#define ENV_PAGE_SIZE "ACLGUARD_PAGE_SIZE"
+#define ENV_SCAN_WORKERS "ACLGUARD_SCAN_WORKERS"
+#define ENV_DELTA_SCAN "ACLGUARD_DELTA_SCAN"
+#define ENV_STATE_DIR "ACLGUARD_STATE_DIR"
+#define ENV_THREADS "ACLGUARD_THREADS"
+#define ENV_SNAPSHOT_FILE "ACLGUARD_SNAPSHOT_FILE"
 
 // Default values
 #define DEFAULT_LDAP_URI ""
 #define DEFAULT_BIND_DN  ""
 #define DEFAULT_BIND_PW  ""
 #define DEFAULT_BASE_DN  ""
+#define DEFAULT_PAGE_SIZE 1000  // Matches the AD default MaxPageSize
+#define DEFAULT_SCAN_WORKERS 1
+#define DEFAULT_DELTA_SCAN 0
+#define DEFAULT_STATE_DIR ".aclguard_state"
+#define DEFAULT_THREADS 1
+#define DEFAULT_SNAPSHOT_FILE ""
 
 // Function declarations
 int load_env_config(Config *config);
@@ -0,0 +1,57 @@
+#ifndef CSV_WRITER_H
+#define CSV_WRITER_H
+
+#include <stddef.h>
+
+// Buffered RFC 4180 CSV writer on a file descriptor. Rows are formatted into a
+// large buffer that is handed to write(2) whole, integers are formatted by
+// hand, and a field is quoted only when it holds a comma, a double quote, CR
+// or LF (quotes inside are doubled). Rows end with CRLF.
+
+typedef struct {
+    int fd;
+    char *buf;
+    size_t len;
+    size_t cap;
+    int fields;    // Fields written in the current row
+    int error;     // Set on allocation or write failure
+} CsvWriter;
+
+// Start a writer on fd; returns 0 or -1. The caller owns fd.
+int csv_writer_init(CsvWriter *w, int fd);
+
+// Field of len bytes, quoted when it needs to be
+void csv_writer_field(CsvWriter *w, const char *s, size_t len);
+void csv_writer_string(CsvWriter *w, const char *s);
+void csv_writer_int(CsvWriter *w, long value);
+
+// count integer fields in one step, e.g. a row's flag columns
+void csv_writer_ints(CsvWriter *w, const long *values, int count);
+
+// One quoted field written in pieces, e.g. a list joined with commas
+void csv_writer_begin_quoted(CsvWriter *w);
+void csv_writer_append(CsvWriter *w, const char *s, size_t len);
+void csv_writer_end_quoted(CsvWriter *w);
+
+void csv_writer_end_row(CsvWriter *w);
+
+// Values escaped once for quoted fields, then written by index many times
+// (group DNs across every user's memberships)
+typedef struct {
+    char *heap;          // Escaped values back to back
+    size_t *offsets;     // count + 1 offsets into heap
+    int count;
+} CsvCells;
+
+// Escape count values; returns 0 or -1 on allocation failure
+int csv_cells_build(CsvCells *cells, char *const *values, const size_t *lengths, int count);
+void csv_cells_free(CsvCells *cells);
+
+// One quoted field listing the cells of ids (unknown IDs skipped) separated
+// by sep; returns the number listed and writes nothing when that is 0
+int csv_writer_cell_list(CsvWriter *w, const CsvCells *cells, const int *ids, int count, char sep);
+
+// Write out the buffer and release it; returns 0, or -1 if anything failed
+int csv_writer_finish(CsvWriter *w);
+
+#endif
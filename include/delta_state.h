@@ -0,0 +1,39 @@
+#ifndef DELTA_STATE_H
+#define DELTA_STATE_H
+
+#include "arena.h"
+#include "config.h"
+#include "types.h"
+
+// Result set and USN high-water mark persisted between delta scans
+typedef struct {
+    long long highest_usn; // highestCommittedUSN read before the stored scan
+    char *server;          // dsServiceName of the DC that counted it, or NULL
+    ADUser *users;         // Stored users (unclassified; callers re-run analysis)
+    int count;
+} DeltaState;
+
+// State file for the configured target (<state_dir>/<hash of uri + base DN>.json); caller frees
+char *delta_state_path(const Config *config);
+
+// Load a stored state; strings and group IDs are allocated from arena.
+// Returns 0 on success, -1 if missing or unreadable.
+int delta_state_load(const char *path, DeltaState *state, Arena *arena);
+
+// Persist users and the high-water mark counted by server (may be NULL);
+// returns 0 on success
+int delta_state_save(const char *path, const Config *config, const char *server, long long highest_usn,
+                     ADUser *users, int count);
+
+// Overlay changed users on the stored set: entries with the same objectGUID (or DN
+// when no GUID is known) are replaced, new ones appended, and deleted GUIDs dropped.
+// A user listed twice in changed is kept once.
+// Returns a new array and consumes state->users and changed.
+ADUser *delta_merge(DeltaState *state,
+                    ADUser *changed,
+                    int changed_count,
+                    char **deleted_guids,
+                    int deleted_count,
+                    int *count_out);
+
+#endif
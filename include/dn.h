@@ -0,0 +1,44 @@
+#ifndef DN_H
+#define DN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Zero-copy RFC 4514 distinguished name parsing. An RDN is reported as slices
+// of the input string; nothing is copied until a value is unescaped or the DN
+// is canonicalized. Multi-valued RDNs (a+b=...) are one RDN whose value slice
+// runs to the next unescaped comma.
+
+typedef struct {
+    const char *type;    // Attribute type, e.g. "CN" or "2.5.4.3"
+    size_t type_len;
+    const char *value;   // Raw value, escapes not yet decoded, outer spaces trimmed
+    size_t value_len;
+    int escaped;         // Value holds at least one backslash escape
+} DnRdn;
+
+// Read the RDN starting at *pos and advance *pos past its separator. Returns 1
+// for an RDN, 0 at the end of the DN, -1 if the DN is malformed (missing '=',
+// empty attribute type, dangling escape).
+int dn_next_rdn(const char *dn, size_t len, size_t *pos, DnRdn *rdn);
+
+// Offset of the parent DN (past the first unescaped comma and any spaces after
+// it), len when the DN has a single RDN
+size_t dn_parent_offset(const char *dn, size_t len);
+
+// Decode the escapes of an RDN value into out (at most value_len bytes);
+// returns the decoded length. "\,", "\2C" and "\2c" all decode to ",".
+size_t dn_unescape(const DnRdn *rdn, char *out);
+
+// Canonical form for DN equality: attribute types and values ASCII case-folded,
+// spaces around separators dropped, value escapes decoded and only the
+// characters RFC 4514 requires re-escaped, as a backslash and the character.
+// A string that does not parse as a DN is case-folded as one opaque value so
+// it still interns. out must hold 2 * len + 1 bytes; returns the canonical
+// length and NUL-terminates out.
+size_t dn_canonicalize(const char *dn, size_t len, char *out);
+
+// FNV-1a hash of a canonical DN
+uint32_t dn_hash(const char *canonical, size_t len);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef EFFECTIVE_RIGHTS_H
+#define EFFECTIVE_RIGHTS_H
+
+#include <stddef.h>
+#include "arena.h"
+#include "types.h"
+
+// Effective ACE rights over the container tree (domain root, OUs, containers)
+// and the scanned objects directly inside it. Each container descriptor is
+// read once per scan. effective_rights_build() then visits containers parents
+// first. The inheritable ACEs a container adds are stored once and linked to
+// the nearest ancestor that added any. Containers that add nothing, and all
+// siblings, share one chain instead of copying it. The rights a chain gives to
+// user objects are flattened once per container and shared by every user in it.
+// Building is single-threaded; once built the tables are read-only.
+
+typedef struct {
+    int containers;         // Containers with a readable descriptor
+    int rooted;             // Containers whose parent was not read (keep their own inherited ACEs)
+    int protected_dacls;    // Containers that block inheritance
+    long inheritable_aces;  // Inheritable ACEs granting rights of interest
+    int chain_links;        // Containers adding inheritable ACEs to the chain
+    int shared_chains;      // Containers passing an ancestor's chain on unchanged
+    int user_sets;          // Per-container user grant sets flattened
+    int users_inherited;    // Users whose inherited grants came from the tree
+} EffectiveRightsStats;
+
+// Record a container and its nTSecurityDescriptor. object_class is its most
+// specific class (domainDNS, organizationalUnit, container); inheritable ACEs
+// restricted to another class pass through it without applying. Returns 0, 1
+// if the descriptor is malformed (the container is skipped), -1 on
+// allocation failure.
+int effective_rights_add_container(const char *dn, const char *object_class, const void *sd, size_t len);
+
+// Compute the effective grants of every recorded container. Then each user
+// directly inside a recorded container gets its explicit grants plus the
+// grants inherited through the tree in place of the inherited ACEs its own
+// descriptor carried, unless its DACL is protected. Users elsewhere keep
+// their grants. New grant arrays come from arena. Scanned objects count as
+// class user. Returns the number of users given tree grants, -1 on allocation
+// failure.
+int effective_rights_build(ADUser *users, int count, Arena *arena);
+
+// Recorded containers: 0 .. effective_rights_containers() - 1
+int effective_rights_containers(void);
+const char *effective_rights_container_dn(int container);
+
+// Effective grants over a container (explicit and inherited); returns the count
+int effective_rights_container_grants(int container, const AceGrant **grants);
+
+// Whether a container's DACL is protected (it inherits nothing)
+int effective_rights_container_protected(int container);
+
+// Recorded container directly holding the object dn of len bytes, or -1
+int effective_rights_parent(const char *dn, size_t len);
+
+void effective_rights_stats(EffectiveRightsStats *stats);
+
+// Forget every container
+void effective_rights_reset(void);
+
+#endif
@@ -4,6 +4,8 @@
 #include "types.h"
 
 void export_to_csv(const char *filename, ADUser *users, int count);
+void export_to_csv_group_rows(const char *filename, ADUser *users, int count);
 void export_to_json(const char *filename, ADUser *users, int count);
+void export_to_ndjson(const char *filename, ADUser *users, int count);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef GROUP_GRAPH_H
+#define GROUP_GRAPH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Group nesting graph over group_table IDs. Edges (a group is a member of
+// another group) are collected once per scan; group_graph_build() collapses
+// nesting cycles into strongly connected components and propagates ancestor
+// bitsets through the condensed graph in topological order, so the groups a
+// user belongs to through nesting come from ORing a few bitsets instead of
+// walking the graph (or asking the directory) per user.
+// Building is single-threaded; once built the graph is read-only and can be
+// queried from any thread.
+
+typedef struct {
+    int groups;             // Group IDs covered by the graph
+    long edges;             // Nesting edges recorded
+    int nested_groups;      // Groups that are a member of another group
+    int cycles;             // Components of more than one group (or a self-loop)
+    int parents;            // Groups that have other groups as members (bitset width)
+    size_t bitset_bytes;    // Memory held by the component ancestor bitsets
+} GroupGraphStats;
+
+// Record that group member is itself a member of group parent. Returns 0, -1
+// on allocation failure.
+int group_graph_add_edge(int member, int parent);
+
+// Condense the recorded edges and compute every group's ancestors. Returns the
+// number of nested groups (0: nesting plays no part), -1 on allocation failure.
+int group_graph_build(void);
+
+// Caller-owned working memory for group_graph_nested(). Allocate one per
+// thread or batch once the graph is built and reuse it for every user; it is
+// sized for the graph as built at that point.
+typedef struct {
+    uint64_t *bits;         // Ancestor bitset
+    int *groups;            // Group IDs reached through nesting
+    int words;              // Bitset words, 0 while nothing is nested
+} GroupGraphScratch;
+
+// Size scratch for the built graph; nothing is allocated while nothing is
+// nested. Returns 0, -1 on allocation failure.
+int group_graph_scratch_init(GroupGraphScratch *scratch);
+
+void group_graph_scratch_free(GroupGraphScratch *scratch);
+
+// Collect in scratch->groups the groups reached from ids only through
+// nesting; the groups in ids themselves are left out. Returns their count.
+int group_graph_nested(const int *ids, int count, GroupGraphScratch *scratch);
+
+// Recorded edges: group (*members)[i] is nested in group (*parents)[i].
+// Returns the edge count.
+long group_graph_edges(const int **members, const int **parents);
+
+void group_graph_stats(GroupGraphStats *stats);
+
+// Forget every edge and the computed closure
+void group_graph_reset(void);
+
+#endif
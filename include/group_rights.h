@@ -0,0 +1,28 @@
+#ifndef GROUP_RIGHTS_H
+#define GROUP_RIGHTS_H
+
+#include "types.h"
+
+// ACE grants over group objects, indexed by group_table ID. Each group's
+// nTSecurityDescriptor is interned through sd_cache, so the grants are the
+// cache's shared arrays and stay valid until sd_cache_reset(). A group keeps
+// the inherited ACEs its own descriptor carries. Filled while the groups are
+// read (single-threaded); read-only afterwards.
+
+// Record the grants over group id and whether its DACL is protected. Returns
+// 0, -1 on allocation failure.
+int group_rights_set(int id, const AceGrant *grants, int count, int protected_dacl);
+
+// Grants over group id; returns the count (0 for a group without any)
+int group_rights_get(int id, const AceGrant **grants);
+
+// Whether group id was recorded with a protected DACL (it inherits nothing)
+int group_rights_protected(int id);
+
+// Recorded group IDs are below this bound
+int group_rights_bound(void);
+
+// Forget every group's grants
+void group_rights_reset(void);
+
+#endif
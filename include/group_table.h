@@ -0,0 +1,44 @@
+#ifndef GROUP_TABLE_H
+#define GROUP_TABLE_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// Process-wide table of distinct group DNs. Every memberOf value is interned once
+// and users refer to groups by dense integer IDs (0 .. group_table_count() - 1).
+// Interning is thread-safe so parallel scan workers can share the table.
+// DNs are keyed by their canonical form (see dn.h), so spellings that differ
+// only in case, escaping or spaces around separators share one ID and DN
+// equality is an ID compare. The table keeps the first spelling seen.
+
+// Intern a group DN of len bytes; returns its ID or -1 on allocation failure
+int group_table_intern(const char *dn, size_t len);
+
+// ID of an already interned group DN, or -1
+int group_table_find(const char *dn, size_t len);
+
+// DN of an interned group, or NULL for an unknown ID
+const char *group_table_name(int id);
+
+// Decoded value of the leaf RDN (the group's CN) of an interned group, or NULL
+// for an unknown ID; the whole string for a name that is not a DN. Sets *len.
+const char *group_table_leaf(int id, size_t *len);
+
+// Number of distinct groups interned so far
+int group_table_count(void);
+
+// Borrow the DN and length arrays, indexed by group ID; returns the group
+// count. The arrays move when a group is interned, so hold them only once the
+// scan is done (exports read every membership through them without locking).
+int group_table_names(char *const **names, const size_t **lengths);
+
+// Join the DNs of ids with sep into a newly allocated string (NULL if count is 0)
+char *group_table_join(const int *ids, int count, const char *sep);
+
+// Write the DNs of ids separated by sep
+void group_table_write(FILE *fp, const int *ids, int count, const char *sep);
+
+// Drop every interned group
+void group_table_reset(void);
+
+#endif
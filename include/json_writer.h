@@ -0,0 +1,71 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+struct json_object;
+
+// Streaming JSON writer. Values are formatted straight into a fixed buffer that
+// is flushed to the sink in large writes, so memory stays constant however
+// many records are written. The pretty layout is byte-for-byte what
+// json_object_to_json_string_ext(JSON_C_TO_STRING_PRETTY) prints for the same
+// document: two-space indent, no space after ':', '/' escaped as "\/",
+// doubles as %.17g. Without JSON_WRITER_PRETTY the layout matches
+// JSON_C_TO_STRING_PLAIN.
+
+#define JSON_WRITER_PRETTY 0x1u
+
+// Values of the json_output argument subcommand printers take. NDJSON is one
+// compact record per line, written as the records are produced.
+#define OUTPUT_TEXT   0
+#define OUTPUT_JSON   1
+#define OUTPUT_NDJSON 2
+#define JSON_WRITER_MAX_DEPTH 64
+
+typedef struct {
+    FILE *fp;             // Sink; NULL collects the document in memory
+    char *buf;
+    size_t len;
+    size_t cap;
+    unsigned int flags;
+    int depth;            // Open containers
+    unsigned char in_object[JSON_WRITER_MAX_DEPTH];
+    unsigned char has_items[JSON_WRITER_MAX_DEPTH];
+    int error;            // Set on allocation, write or nesting failure
+} JsonWriter;
+
+// Start a writer on fp, or in memory when fp is NULL; returns 0 or -1
+int json_writer_init(JsonWriter *w, FILE *fp, unsigned int flags);
+
+void json_writer_begin_object(JsonWriter *w);
+void json_writer_end_object(JsonWriter *w);
+void json_writer_begin_array(JsonWriter *w);
+void json_writer_end_array(JsonWriter *w);
+
+// Member name inside an object; the next call writes its value
+void json_writer_key(JsonWriter *w, const char *key);
+
+void json_writer_string(JsonWriter *w, const char *s);
+void json_writer_string_len(JsonWriter *w, const char *s, size_t len);
+void json_writer_int(JsonWriter *w, int64_t value);
+void json_writer_double(JsonWriter *w, double value);
+void json_writer_bool(JsonWriter *w, int value);
+void json_writer_null(JsonWriter *w);
+
+// Write a json-c value in place, laid out as if it were part of the stream
+void json_writer_json(JsonWriter *w, struct json_object *value);
+
+// Raw bytes between top-level documents, e.g. the trailing newline
+void json_writer_raw(JsonWriter *w, const char *s, size_t len);
+
+// Push buffered bytes to the sink
+void json_writer_flush(JsonWriter *w);
+
+// Flush and release the writer; returns 0, or -1 if anything failed. For an
+// in-memory writer, *out (if out is non-NULL) receives the NUL-terminated
+// document, which the caller frees.
+int json_writer_finish(JsonWriter *w, char **out);
+
+#endif
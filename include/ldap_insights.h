@@ -1,12 +1,29 @@
 #ifndef LDAP_INSIGHTS_H
 #define LDAP_INSIGHTS_H
 
+#include "snapshot.h"
 #include "types.h"
 
 int ldap_status_output(ADUser *users, int count, int json_output);
 int ldap_alerts_recent_output(ADUser *users, int count, int json_output);
 int ldap_correlate_attack_output(ADUser *users, int count, const char *attack, int json_output);
 int ldap_analyze_incident_output(ADUser *users, int count, const char *incident_id, int json_output);
-int ldap_metrics_output(ADUser *users, int count, double scan_seconds, const char *metric, int json_output);
+int ldap_paths_output(ADUser *users, int count, int json_output);
+int ldap_rights_output(ADUser *users, int count, const char *principal, int json_output);
+int ldap_metrics_output(ADUser *users, int count, const ScanStats *stats, const char *metric, int json_output);
+
+// Every REPORT_* section selected in sections, built from one scan's alerts,
+// incidents and correlations, as one document
+int ldap_report_output(ADUser *users, int count, const ScanStats *stats, unsigned int sections, int json_output);
+
+// Save the scan with its alert order and detector flags (see snapshot.h);
+// returns 0 on success
+int ldap_snapshot_save(const char *path, ADUser *users, int count);
+
+// status, alerts, correlate and analyze against a saved scan, without LDAP
+int snapshot_status_output(const Snapshot *snap, int json_output);
+int snapshot_alerts_recent_output(const Snapshot *snap, int json_output);
+int snapshot_correlate_attack_output(const Snapshot *snap, const char *attack, int json_output);
+int snapshot_analyze_incident_output(const Snapshot *snap, const char *incident_id, int json_output);
 
 #endif
@@ -6,5 +6,8 @@ int mock_alerts_recent(int json_output);
 int mock_correlate_attack(const char *attack, int json_output);
 int mock_analyze_incident(const char *incident_id, int json_output);
 int mock_metrics(const char *metric, int json_output);
+int mock_paths(int json_output);
+int mock_rights(const char *principal, int json_output);
+int mock_report(unsigned int sections, int json_output);
 
 #endif
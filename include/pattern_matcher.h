@@ -0,0 +1,35 @@
+#ifndef PATTERN_MATCHER_H
+#define PATTERN_MATCHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Multi-pattern substring matcher (Aho-Corasick). Patterns are compiled once
+// into a single automaton; one pass over a string reports every pattern that
+// occurs in it, so adding patterns does not add passes over the input.
+
+#define PATTERN_NOCASE 0x1u  // Match ASCII letters case-insensitively
+
+typedef struct PatternMatcher PatternMatcher;
+
+PatternMatcher *pattern_matcher_new(void);
+void pattern_matcher_free(PatternMatcher *matcher);
+
+// Add a pattern before compiling; identical pattern/flag pairs share one ID.
+// Returns the pattern ID or -1 on error (empty pattern, already compiled, no memory).
+int pattern_matcher_add(PatternMatcher *matcher, const char *pattern, unsigned int flags);
+
+// Build failure links and the full transition table; returns 0 on success
+int pattern_matcher_compile(PatternMatcher *matcher);
+
+// Number of distinct patterns (IDs are 0 .. count - 1)
+int pattern_matcher_count(const PatternMatcher *matcher);
+
+// Number of 64-bit words a hit set for this matcher needs
+size_t pattern_matcher_words(const PatternMatcher *matcher);
+
+// Scan text once and set bit ID in hits for every pattern found. hits must hold
+// pattern_matcher_words() words and is cleared first.
+void pattern_matcher_scan(const PatternMatcher *matcher, const char *text, size_t len, uint64_t *hits);
+
+#endif
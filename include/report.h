@@ -0,0 +1,24 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+struct json_object;
+
+// Sections of the report subcommand. One scan feeds every selected section, so
+// a dashboard gets status, alerts, incidents, correlations and metrics in one
+// document instead of one directory scan per subcommand.
+#define REPORT_STATUS       0x01u
+#define REPORT_ALERTS       0x02u
+#define REPORT_INCIDENTS    0x04u
+#define REPORT_CORRELATIONS 0x08u
+#define REPORT_METRICS      0x10u
+#define REPORT_ALL          0x1fu
+
+// Parse a comma-separated section list such as "status,alerts"; returns 0, or
+// -1 after naming the unknown section on stderr
+int report_parse_sections(const char *list, unsigned int *sections);
+
+// Print a report document {"summary": ..., "data": {<section>: ...}} as
+// pretty JSON or as text, one block per section present in data
+int report_print(struct json_object *report, int json_output);
+
+#endif
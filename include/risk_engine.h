@@ -1,6 +1,42 @@
 #ifndef RISK_ENGINE_H
 #define RISK_ENGINE_H
 
-int evaluate_risk(const char *username);
+#include "types.h"
 
-#endif
\ No newline at end of file
+// Risk factors that can contribute to a user's score
+#define RISK_FACTOR_GROUP_RULES   (1u << 0) // A group rule granted permissions or risk
+#define RISK_FACTOR_SERVICE_NAME  (1u << 1) // Account name looks like a service account
+#define RISK_FACTOR_GROUP_VOLUME  (1u << 2) // Unusually many group memberships
+#define RISK_FACTOR_ACL_RIGHTS    (1u << 3) // Holds rights through ACEs on scanned objects
+
+// Weighted scoring model. A user's score is the summed group-rule weights
+// scaled by group_weight, plus the weight of every other factor present,
+// capped at cap.
+typedef struct {
+    double group_weight;        // Scale applied to summed group-rule weights
+    int service_name_weight;    // Added for svc* / *service* account names
+    int group_volume_threshold; // Memberships at which GROUP_VOLUME applies
+    int group_volume_weight;    // Added when GROUP_VOLUME applies
+    int acl_rights_weight;      // Added when ACL_RIGHTS applies
+    int cap;                    // Maximum score
+} RiskModel;
+
+// Default model: group rules plus ACE-derived rights, capped at 100
+void risk_model_default(RiskModel *model);
+
+// Process-wide model: the defaults overridden by ACLGUARD_RISK_* variables
+const RiskModel *risk_model_active(void);
+
+// RISK_FACTOR_* bits that apply to user, ignoring their weights
+unsigned int risk_user_factors(const ADUser *user, const RiskModel *model);
+
+// Score one user through the shared group verdict cache: sets perms (group
+// verdicts plus acl_perms) and risk. Returns 0, -1 on allocation failure.
+int risk_score_user(ADUser *user, const RiskModel *model);
+
+// Score a whole user set. Distinct groups are classified once up front, then
+// users are scored lock-free in chunks on the thread pool. Returns 0 on
+// success, -1 on allocation failure.
+int risk_score_batch(ADUser *users, int count, const RiskModel *model);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef RULE_PACK_H
+#define RULE_PACK_H
+
+// Group classification rule as loaded from a rule pack. A rule fires for a
+// group when any of its any_of patterns occurs in the group's CN (the leaf RDN
+// value, not the rest of the DN) and all of its all_of patterns do too (an
+// empty list is satisfied trivially).
+
+// Patterns must equal the whole CN, ignoring ASCII case, rather than occur in it
+#define RULE_MATCH_CN 0x100u
+
+typedef struct {
+    const char *name;
+    const char **any_of;
+    int any_count;
+    const char **all_of;
+    int all_count;
+    unsigned int match_flags; // PATTERN_* or RULE_MATCH_CN flags applied to every pattern
+    unsigned int perms;       // PERM_* bits set when the rule fires
+    int risk;                 // Risk weight added when the rule fires
+} RuleSpec;
+
+typedef struct {
+    RuleSpec *rules;
+    int count;
+} RulePack;
+
+// Load a JSON rule pack; returns 0 on success and logs the reason on failure
+int rule_pack_load(const char *path, RulePack *pack);
+
+// Release a pack returned by rule_pack_load
+void rule_pack_free(RulePack *pack);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef SD_CACHE_H
+#define SD_CACHE_H
+
+#include <stddef.h>
+#include "types.h"
+
+// Process-wide hash-consing table of security descriptors. Objects under one
+// OU usually carry byte-identical inherited descriptors, so each distinct blob
+// (64-bit fingerprint plus byte compare) is parsed and evaluated once and every
+// object carrying it shares the resulting grant array. Interning is
+// thread-safe so parallel scan workers can share the table.
+
+typedef struct {
+    long lookups;          // Descriptors interned, duplicates included
+    long unique;           // Distinct descriptors held by the table
+    long malformed;        // Lookups that returned a malformed descriptor
+    size_t bytes;          // Descriptor bytes looked up
+    size_t unique_bytes;   // Descriptor bytes held by the table
+    size_t bytes_saved;    // Descriptor and grant bytes shared instead of copied
+} SdCacheStats;
+
+// Intern one descriptor and return its grants (see sd_collect_grants) through
+// grants_out and whether its DACL is protected through protected_out. The
+// grants belong to the cache and must not be modified; they stay valid until
+// sd_cache_reset(). Returns the grant count, SD_MALFORMED if the descriptor is
+// malformed (remembered like any other descriptor) and SD_NO_MEMORY if memory
+// ran out (nothing is cached, so a retry parses again).
+int sd_cache_intern(const void *data, size_t len, AceGrant **grants_out, int *protected_out);
+
+// Counters since the last reset
+void sd_cache_stats(SdCacheStats *stats);
+
+// Drop every interned descriptor; earlier grant pointers become invalid
+void sd_cache_reset(void);
+
+#endif
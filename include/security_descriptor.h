@@ -0,0 +1,105 @@
+#ifndef SECURITY_DESCRIPTOR_H
+#define SECURITY_DESCRIPTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "types.h"
+
+// Zero-copy reader for self-relative SECURITY_DESCRIPTOR blobs as returned in
+// nTSecurityDescriptor. Every view points into the caller's buffer (typically
+// the berval of the LDAP value); nothing is copied or allocated while parsing.
+
+// LDAP_SERVER_SD_FLAGS_OID and the parts requested through it
+#define SD_FLAGS_CONTROL_OID "1.2.840.113556.1.4.801"
+#define SD_OWNER_SECURITY_INFORMATION 0x1
+#define SD_DACL_SECURITY_INFORMATION  0x4
+
+// ACE types and flags the parser understands
+#define ACE_ACCESS_ALLOWED        0x00
+#define ACE_ACCESS_DENIED         0x01
+#define ACE_ACCESS_ALLOWED_OBJECT 0x05
+#define ACE_ACCESS_DENIED_OBJECT  0x06
+#define ACE_CONTAINER_INHERIT     0x02
+#define ACE_NO_PROPAGATE_INHERIT  0x04
+#define ACE_INHERIT_ONLY          0x08
+#define ACE_INHERITED             0x10
+
+// Failure codes of sd_collect_grants() and sd_cache_intern()
+#define SD_MALFORMED (-1)
+#define SD_NO_MEMORY (-2)
+
+// Longest textual SID: "S-1-" + 48-bit authority + 15 sub-authorities
+#define SID_STRING_MAX 192
+
+typedef struct {
+    const uint8_t *owner;     // Owner SID, NULL when not returned
+    size_t owner_len;
+    const uint8_t *dacl;      // First ACE of the DACL, NULL when not returned
+    const uint8_t *dacl_end;
+    int ace_count;
+    int protected_dacl;       // SE_DACL_PROTECTED: parent ACEs are not inherited
+} SecurityDescriptor;
+
+typedef struct {
+    uint8_t type;             // ACE_* type
+    uint8_t flags;            // ACE_INHERIT_ONLY and the inheritance bits
+    uint32_t mask;            // Access mask
+    const uint8_t *object_type; // 16-byte schema/extended-right GUID, or NULL
+    const uint8_t *inherited_object_type; // Class GUID of the children that inherit it, or NULL
+    const uint8_t *sid;       // Trustee SID
+    size_t sid_len;
+} AceView;
+
+typedef struct {
+    const uint8_t *next;
+    const uint8_t *end;
+    int remaining;
+} AceIterator;
+
+// Validate the header of a descriptor and locate its owner and DACL.
+// Returns 0 on success, -1 if the blob is malformed.
+int sd_parse(const void *data, size_t len, SecurityDescriptor *sd);
+
+// Walk the DACL ACEs in order. sd_next_ace() returns 1 for each ACE, 0 at
+// the end and -1 on a truncated or malformed ACE.
+void sd_aces(const SecurityDescriptor *sd, AceIterator *it);
+int sd_next_ace(AceIterator *it, AceView *ace);
+
+// Whether sid can name a principal holding rights: an NT AUTHORITY SID
+// (S-1-5-..., domain principals included) or Everyone (S-1-1-0)
+int sid_is_principal(const uint8_t *sid, size_t len);
+
+// Byte length of the SID at sid (at most avail bytes); 0 if malformed
+size_t sid_length(const uint8_t *sid, size_t avail);
+
+// Format a binary SID as S-1-... into buf; returns the length, -1 if it does
+// not fit or is malformed
+int sid_to_string(const uint8_t *sid, size_t len, char *buf, size_t size);
+
+// Parse S-1-... back into a binary SID; returns its length, -1 if malformed
+int sid_from_string(const char *text, uint8_t *out, size_t size);
+
+// PERM_* bits an allow ACE grants over the object it protects
+unsigned int ace_perms(const AceView *ace);
+
+// Collect the rights a descriptor grants to principals (sid_is_principal());
+// well-known principals marked as expected holders in data/wellknown.tsv, such
+// as SYSTEM and Domain Admins, are skipped. Owners count as WriteDACL. Rights from inherited
+// ACEs are kept apart from explicit ones (AceGrant.inherited).
+// The grant array and trustee strings come from the arena. Returns the number
+// of grants, 0 for none, SD_MALFORMED if the descriptor is malformed and
+// SD_NO_MEMORY if the arena ran out.
+int sd_collect_grants(const void *data, size_t len, Arena *arena, AceGrant **grants_out);
+
+// Credit every user's acl_grants to their trustees, replacing acl_perms: a
+// trustee that is one of users (matched by objectSid) gets the rights itself,
+// and a trustee the SID resolver knows as a group passes them to its members,
+// direct or through nested groups (group_graph.h). A principal every user
+// belongs to (Everyone, Authenticated Users, Domain Users) passes them to
+// every user. Rights over recorded containers (effective_rights.h) and over
+// groups (group_rights.h) are credited the same way. Returns the
+// number of users holding ACE rights, -1 on allocation failure.
+int sd_resolve_grants(ADUser *users, int count);
+
+#endif
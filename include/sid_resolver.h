@@ -0,0 +1,61 @@
+#ifndef SID_RESOLVER_H
+#define SID_RESOLVER_H
+
+#include "types.h"
+
+// SID -> principal map used to resolve ACE trustees. It is preloaded with the
+// objectSid of every scanned user; the remaining trustees are listed by
+// sid_resolver_pending() so the caller can look them up in batches and add
+// the answers. Well-known SIDs the directory does not resolve are answered
+// from the generated table (wellknown.h). Not thread-safe: resolution runs
+// after the download.
+
+typedef enum {
+    PRINCIPAL_UNKNOWN,      // Looked up, but the directory did not return it
+    PRINCIPAL_USER,
+    PRINCIPAL_GROUP,
+    PRINCIPAL_COMPUTER,
+    PRINCIPAL_OTHER,
+    PRINCIPAL_WELLKNOWN,    // Well-known principal outside the directory (Anonymous Logon, ...)
+    PRINCIPAL_ALL_USERS     // Well-known principal every user belongs to (Everyone, Domain Users, ...)
+} PrincipalKind;
+
+typedef struct {
+    const char *name;       // DN, or the well-known name
+    PrincipalKind kind;
+    int user_index;         // Index into the users passed to sid_resolver_add_users, or -1
+} Principal;
+
+typedef struct {
+    long wellknown_hits;    // Lookups answered by the well-known table
+    long hits;              // Lookups answered by the map
+    long misses;            // Distinct SIDs that needed a directory lookup
+    long batches;           // Directory searches issued for misses
+    long unresolved;        // Lookups that found no principal
+} SidResolverStats;
+
+// Forget every principal and zero the counters
+void sid_resolver_reset(void);
+
+// Map sid to a principal (name is copied); replaces an earlier mapping.
+// Returns 0, -1 on allocation failure.
+int sid_resolver_add(const char *sid, const char *name, PrincipalKind kind, int user_index);
+
+// Map the objectSid of every user to that user
+int sid_resolver_add_users(const ADUser *users, int count);
+
+// Trustees of the users' acl_grants and of the rights over recorded
+// containers and groups that are not mapped, without duplicates (well-known principals
+// only when they are ordinary directory groups);
+// each counts as a miss. The array (caller frees) points at the grant strings. Returns the count, -1 on allocation failure.
+int sid_resolver_pending(const ADUser *users, int count, const char ***sids_out);
+
+// Count one directory search issued for pending SIDs
+void sid_resolver_record_batch(void);
+
+// Resolve sid; returns 1 and fills out when the principal is known
+int sid_resolver_lookup(const char *sid, Principal *out);
+
+void sid_resolver_stats(SidResolverStats *stats);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "user_store.h"
+
+// Versioned binary snapshot of one scan. The file is the user store's columns
+// laid out as they sit in memory, so opening it is an mmap and a bounds check:
+//
+//   header    magic "ACLGSNAP", version, byte order, counts, scan time and
+//             an (offset, size) entry per block
+//   columns   PERM_* bits, risk, permission bit planes and detector flags,
+//             one byte (or bit) per user
+//   strings   USER_COL_COUNT offset columns into a heap of NUL-terminated
+//             strings, USER_STORE_NO_STRING for a missing value
+//   groups    per-user offsets into a heap of group IDs, and the group table:
+//             offsets into a heap of NUL-terminated group DNs
+//
+// Blocks start on 8-byte boundaries and use the writer's byte order; a file
+// from a machine of the other order is rejected. Users are stored in alert
+// order (sorted by name), so readers never sort.
+
+#define SNAPSHOT_VERSION 1
+
+typedef struct {
+    UserStore store;              // Columns point into the read-only mapping
+    const uint8_t *detections;    // Detector flags per user, as the scan found them
+    int group_count;
+    const uint32_t *group_names;  // Offsets of group DNs into group_heap
+    const char *group_heap;
+    size_t group_bytes;
+    char scan_time[32];           // RFC 3339 time of the scan
+    void *map;
+    size_t map_size;
+} Snapshot;
+
+// Write store (built with USER_STORE_ALL), its detector flags and the current
+// group table to path, through a temporary file renamed into place.
+// Returns 0 on success.
+int snapshot_write(const char *path, const UserStore *store, const uint8_t *detections, const char *scan_time);
+
+// Map a snapshot read-only and check every block and offset against the file;
+// returns 0 on success, -1 (after logging why) otherwise
+int snapshot_open(const char *path, Snapshot *snap);
+
+// Unmap a snapshot opened by snapshot_open
+void snapshot_close(Snapshot *snap);
+
+// DN of group id in the snapshot's group table, or NULL for an unknown ID
+const char *snapshot_group_name(const Snapshot *snap, int id);
+
+#endif
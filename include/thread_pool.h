@@ -0,0 +1,34 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Process-wide worker pool for data-parallel loops. parallel_for() splits a
+// range into fixed-size chunks and deals them out to per-thread deques; a
+// thread that runs out of chunks steals from the far end of another thread's
+// deque. The calling thread works too, so a pool of N threads starts N - 1
+// workers.
+
+// Body of a parallel loop: process items [begin, end)
+typedef void (*ParallelBody)(void *ctx, int begin, int end);
+
+// Default number of items per chunk
+#define PARALLEL_CHUNK 1024
+
+// Size the pool (threads <= 1 disables it). Returns 0 on success; on failure
+// the pool keeps running loops on the calling thread.
+int thread_pool_init(int threads);
+
+// Threads parallel_for() uses, the caller included (1 when disabled)
+int thread_pool_size(void);
+
+// Stop and join the workers; registered with atexit() by thread_pool_init()
+void thread_pool_shutdown(void);
+
+// Run body over [0, count) in chunks of chunk_size items and return once every
+// chunk is done. Chunks run concurrently and in no particular order, so bodies
+// must only write state owned by their own range. Nested calls run inline.
+void parallel_for(int count, int chunk_size, ParallelBody body, void *ctx);
+
+// Chunks taken from another thread's deque since startup
+long thread_pool_steals(void);
+
+#endif
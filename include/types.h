@@ -2,13 +2,29 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <stddef.h>
+
+// Rights an object's DACL grants to one trustee
+typedef struct {
+    char *trustee;       // Trustee objectSid (S-1-5-...)
+    unsigned int perms;  // PERM_* bits the trustee holds over the object
+    unsigned int inherited; // 1 if the ACE was inherited from a parent container
+} AceGrant;
+
 // Active Directory / LDAP User representation
 typedef struct {
     char *username;   // sAMAccountName or uid
     char *cn;         // Common Name
     char *dn;         // Distinguished Name
+    char *guid;       // objectGUID (hex), tracks the object across delta scans
     char *mail;       // Email address
-    char *memberOf;   // Group memberships (comma-separated)
+    char *sid;        // objectSid (S-1-5-...), matched against ACE trustees
+    int *group_ids;   // Group memberships as IDs into the interned group table
+    int group_count;  // Number of entries in group_ids
+    AceGrant *acl_grants; // Rights this object's DACL grants to other principals
+    int acl_grant_count;
+    int acl_protected;    // DACL does not inherit ACEs from parent containers
+    unsigned int acl_perms; // PERM_* bits held through ACEs on scanned objects
     
     // Permission flags (1 = has permission, 0 = no permission)
     struct {
@@ -25,4 +41,36 @@ typedef struct {
     int risk;         // Risk score (0-100)
 } ADUser;
 
+// Timing and volume counters collected while a directory scan runs
+typedef struct {
+    double first_result_seconds; // Scan start until the first entry was classified (decoded with --threads)
+    double total_seconds;        // Wall time of the whole scan, connect included
+    int pages;                   // Search result pages received
+    long security_descriptors;   // nTSecurityDescriptor values read
+    long unique_security_descriptors; // Distinct descriptors parsed and evaluated
+    long malformed_security_descriptors; // Descriptors ignored as malformed
+    size_t security_descriptor_bytes; // Descriptor bytes received
+    size_t security_descriptor_bytes_saved; // Descriptor and grant bytes shared, not copied
+    long group_nesting_edges;    // Group-in-group memberships read
+    int nested_groups;           // Groups nested in at least one other group
+    int group_nesting_cycles;    // Nesting cycles collapsed into one component
+    int containers;              // Container descriptors read for inheritance
+    long inheritable_aces;       // Inheritable ACEs granting rights of interest
+    int inherit_chain_links;     // Containers adding ACEs to their children's chain
+    int inherit_chains_shared;   // Containers passing an ancestor's chain on unchanged
+    int users_inheriting;        // Users whose inherited rights came from the container tree
+    long sid_cache_hits;         // ACE trustees resolved from the SID map
+    long sid_cache_misses;       // Distinct trustees looked up in the directory
+    long sid_wellknown_hits;     // ACE trustees resolved from the well-known table
+    long sid_lookup_batches;     // Searches issued for trustee lookups
+    long sid_unresolved;         // ACE trustees no principal was found for
+    long wellknown_hits;         // Well-known SID/GUID table lookups that matched
+    long wellknown_misses;       // Well-known SID/GUID table lookups that did not
+    long group_cache_hits;       // Memberships scored from a cached group verdict
+    long group_cache_misses;     // Distinct groups classified during the scan
+    size_t arena_bytes;          // Bytes of user data allocated from the scan arena
+    long arena_allocations;      // Blocks served by the arena
+    long arena_chunks;           // Chunks the arena obtained from malloc
+} ScanStats;
+
 #endif
\ No newline at end of file
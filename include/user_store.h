@@ -0,0 +1,73 @@
+#ifndef USER_STORE_H
+#define USER_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+
+// Columnar (structure-of-arrays) copy of a scan result. Aggregate passes read
+// only the narrow columns they need: a packed PERM_* byte per user, a risk
+// byte per user, and one bit plane per permission for popcount reductions.
+// Strings and group IDs live in two shared heaps referenced by offset.
+
+// String columns
+typedef enum {
+    USER_COL_USERNAME,
+    USER_COL_CN,
+    USER_COL_DN,
+    USER_COL_GUID,
+    USER_COL_MAIL,
+    USER_COL_COUNT
+} UserColumn;
+
+#define USER_STORE_NO_STRING UINT32_MAX
+
+// Optional parts of a store; the permission and risk columns are always built
+#define USER_STORE_STRINGS 0x1u
+#define USER_STORE_GROUPS  0x2u
+#define USER_STORE_ALL     (USER_STORE_STRINGS | USER_STORE_GROUPS)
+
+typedef struct {
+    int count;
+    size_t words;                  // 64-bit words per bit plane
+
+    uint8_t *perm_bits;            // PERM_* bits per user
+    uint8_t *risk;                 // Risk score (0-100) per user
+    uint64_t *perm_planes;         // PERM_COUNT planes of `words` words; bit i = user i
+
+    unsigned int parts;            // USER_STORE_* parts that were built
+    uint32_t *strings[USER_COL_COUNT]; // Offsets into string_heap, USER_STORE_NO_STRING for NULL
+    char *string_heap;
+    size_t string_bytes;
+
+    uint32_t *group_start;         // count + 1 offsets into group_heap
+    int *group_heap;               // Group IDs of all users, back to back
+} UserStore;
+
+// Build a store from users with the requested optional parts; summary passes
+// that only reduce over permissions and risk can pass 0. Returns 0 on success.
+int user_store_build(UserStore *store, const ADUser *users, int count, unsigned int parts);
+
+// Same, with user i taken from users[i] (e.g. users in alert order)
+int user_store_build_ordered(UserStore *store, const ADUser *const *users, int count, unsigned int parts);
+
+// Release a store built by user_store_build
+void user_store_free(UserStore *store);
+
+// String column value for user i, or NULL (always NULL without USER_STORE_STRINGS)
+const char *user_store_string(const UserStore *store, UserColumn column, int i);
+
+// ADUser compatibility view of user i; strings and group IDs point into the
+// store and are empty for parts that were not built
+void user_store_view(const UserStore *store, int i, ADUser *out);
+
+// Users holding any PERM_* bit in mask (popcount over the OR of bit planes)
+int user_store_count_any(const UserStore *store, unsigned int mask);
+
+// Users whose risk score is at least threshold
+int user_store_count_risk_at_least(const UserStore *store, int threshold);
+
+// Users with a non-zero risk score or any permission bit
+int user_store_count_classified(const UserStore *store);
+
+#endif
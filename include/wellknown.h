@@ -0,0 +1,74 @@
+#ifndef WELLKNOWN_H
+#define WELLKNOWN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Well-known SIDs and extended-right/schema GUIDs. The table is generated at
+// build time from data/wellknown.tsv by tools/gen_wellknown, which searches for
+// a hash seed that places every key in its own slot (a perfect hash), so a
+// lookup is one hash, one probe and one compare.
+
+typedef enum {
+    WELLKNOWN_SID,            // Fixed SID, e.g. S-1-5-18
+    WELLKNOWN_DOMAIN_RID,     // Domain-relative SID, keyed as DOMAIN-<rid>
+    WELLKNOWN_EXTENDED_RIGHT, // Control-access right GUID
+    WELLKNOWN_ATTRIBUTE,      // Attribute or property-set GUID
+    WELLKNOWN_CLASS           // Object class GUID
+} WellKnownKind;
+
+// How ACE grants to a well-known principal count
+typedef enum {
+    WELLKNOWN_HOLDER_NONE,      // An ordinary trustee
+    WELLKNOWN_HOLDER_EXPECTED,  // Holds the rights by design (SYSTEM, Domain Admins, ...); skipped
+    WELLKNOWN_HOLDER_ALL_USERS  // Every user belongs to it (Everyone, Domain Users, ...)
+} WellKnownHolder;
+
+typedef struct {
+    const char *key;          // SID, DOMAIN-<rid>, or lowercase GUID; NULL = empty slot
+    const char *name;
+    WellKnownKind kind;
+    unsigned int perms;       // PERM_* bits the right or attribute write grants
+    WellKnownHolder holder;   // For SIDs: how grants to the principal count
+} WellKnownEntry;
+
+// Shared by the generator and the lookup: FNV-1a with a seeded basis and a
+// final avalanche
+static inline uint32_t wellknown_hash(const char *key, size_t len, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)key[i];
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    return hash ^ (hash >> 16);
+}
+
+// Generated table (src/wellknown_table.c)
+extern const uint32_t wellknown_seed;
+extern const uint32_t wellknown_slots; // Power of two
+extern const WellKnownEntry wellknown_table[];
+
+// Entry for a textual key, NULL if it is not well known
+const WellKnownEntry *wellknown_lookup(const char *key);
+
+// Entry for a SID string; domain SIDs (S-1-5-21-a-b-c-rid) match by RID
+const WellKnownEntry *wellknown_sid(const char *sid);
+
+// Whether grants to sid are expected and skipped (WELLKNOWN_HOLDER_EXPECTED)
+int wellknown_expected_holder(const char *sid);
+
+// Entry for a 16-byte GUID in on-the-wire (mixed-endian) layout
+const WellKnownEntry *wellknown_guid(const uint8_t *guid);
+
+// Lookups through wellknown_sid()/wellknown_guid() that found / missed an
+// entry; either pointer may be NULL
+void wellknown_stats(long *hits, long *misses);
+
+// Format a 16-byte on-the-wire GUID as lowercase xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
+void guid_format(const uint8_t *guid, char out[37]);
+
+#endif
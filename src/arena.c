@@ -0,0 +1,114 @@
+#include "arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_MIN_CHUNK (64 * 1024)
+#define ARENA_MAX_CHUNK (1024 * 1024)
+#define ARENA_ALIGN 16
+
+struct ArenaChunk {
+    ArenaChunk *next;
+    size_t size;  // Usable bytes in data
+    size_t used;
+    _Alignas(ARENA_ALIGN) unsigned char data[];
+};
+
+void arena_init(Arena *arena) {
+    memset(arena, 0, sizeof(*arena));
+    arena->next_size = ARENA_MIN_CHUNK;
+}
+
+static ArenaChunk *add_chunk(Arena *arena, size_t min_size) {
+    size_t size = arena->next_size ? arena->next_size : ARENA_MIN_CHUNK;
+    if (size < min_size) size = min_size;
+
+    ArenaChunk *chunk = malloc(sizeof(ArenaChunk) + size);
+    if (!chunk) return NULL;
+    chunk->size = size;
+    chunk->used = 0;
+
+    // Oversized blocks get a private chunk behind the current one so the
+    // remaining space in the current chunk stays usable
+    if (arena->head && min_size > arena->next_size) {
+        chunk->next = arena->head->next;
+        arena->head->next = chunk;
+    } else {
+        chunk->next = arena->head;
+        arena->head = chunk;
+        if (arena->next_size < ARENA_MAX_CHUNK) arena->next_size *= 2;
+    }
+
+    arena->bytes_reserved += size;
+    arena->chunks++;
+    return chunk;
+}
+
+static void *arena_alloc_align(Arena *arena, size_t size, size_t align) {
+    if (size == 0) size = 1;
+
+    ArenaChunk *chunk = arena->head;
+    if (chunk) {
+        size_t start = (chunk->used + align - 1) & ~(align - 1);
+        if (start <= chunk->size && size <= chunk->size - start) {
+            arena->bytes_used += start - chunk->used + size;
+            arena->allocations++;
+            chunk->used = start + size;
+            return chunk->data + start;
+        }
+    }
+
+    chunk = add_chunk(arena, size);
+    if (!chunk) return NULL;
+    chunk->used = size;
+    arena->bytes_used += size;
+    arena->allocations++;
+    return chunk->data;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    return arena_alloc_align(arena, size, ARENA_ALIGN);
+}
+
+char *arena_strndup(Arena *arena, const char *s, size_t len) {
+    char *copy = arena_alloc_align(arena, len + 1, 1);
+    if (!copy) return NULL;
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+char *arena_strdup(Arena *arena, const char *s) {
+    return s ? arena_strndup(arena, s, strlen(s)) : NULL;
+}
+
+void arena_merge(Arena *dst, Arena *src) {
+    if (!src->head) return;
+
+    // Append src's chunks after dst's current chunk so dst keeps bumping into it
+    ArenaChunk *tail = src->head;
+    while (tail->next) tail = tail->next;
+    if (dst->head) {
+        tail->next = dst->head->next;
+        dst->head->next = src->head;
+    } else {
+        dst->head = src->head;
+    }
+
+    dst->bytes_used += src->bytes_used;
+    dst->bytes_reserved += src->bytes_reserved;
+    dst->allocations += src->allocations;
+    dst->chunks += src->chunks;
+    if (!dst->next_size) dst->next_size = ARENA_MIN_CHUNK;
+    arena_init(src);
+}
+
+void arena_destroy(Arena *arena) {
+    ArenaChunk *chunk = arena->head;
+    while (chunk) {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena_init(arena);
+}
@@ -0,0 +1,129 @@
+#include "attack_graph.h"
+#include <stdlib.h>
+#include <string.h>
+
+int attack_graph_init(AttackGraph *graph, int node_count) {
+    memset(graph, 0, sizeof(*graph));
+    graph->node_count = node_count > 0 ? node_count : 0;
+    return 0;
+}
+
+int attack_graph_add_edge(AttackGraph *graph, int from, int to, unsigned int label) {
+    if (from < 0 || to < 0 || from >= graph->node_count || to >= graph->node_count) return 0;
+    if (graph->edge_count == graph->edge_cap) {
+        long new_cap = graph->edge_cap == 0 ? 1024 : graph->edge_cap * 2;
+        int *edge_from = realloc(graph->edge_from, (size_t)new_cap * sizeof(int));
+        if (!edge_from) return -1;
+        graph->edge_from = edge_from;
+        int *edge_to = realloc(graph->edge_to, (size_t)new_cap * sizeof(int));
+        if (!edge_to) return -1;
+        graph->edge_to = edge_to;
+        unsigned int *edge_label = realloc(graph->edge_label, (size_t)new_cap * sizeof(unsigned int));
+        if (!edge_label) return -1;
+        graph->edge_label = edge_label;
+        graph->edge_cap = new_cap;
+    }
+    graph->edge_from[graph->edge_count] = from;
+    graph->edge_to[graph->edge_count] = to;
+    graph->edge_label[graph->edge_count] = label;
+    graph->edge_count++;
+    return 0;
+}
+
+int attack_graph_finish(AttackGraph *graph) {
+    long *in_start = calloc((size_t)graph->node_count + 1, sizeof(long));
+    int *in_from = malloc((size_t)(graph->edge_count > 0 ? graph->edge_count : 1) * sizeof(int));
+    unsigned int *in_label = malloc((size_t)(graph->edge_count > 0 ? graph->edge_count : 1) * sizeof(unsigned int));
+    if (!in_start || !in_from || !in_label) {
+        free(in_start);
+        free(in_from);
+        free(in_label);
+        return -1;
+    }
+
+    // Counting sort by target node; stable, so insertion order is kept per node
+    for (long e = 0; e < graph->edge_count; e++) in_start[graph->edge_to[e] + 1]++;
+    for (int v = 0; v < graph->node_count; v++) in_start[v + 1] += in_start[v];
+    for (long e = 0; e < graph->edge_count; e++) {
+        long pos = in_start[graph->edge_to[e]]++;
+        in_from[pos] = graph->edge_from[e];
+        in_label[pos] = graph->edge_label[e];
+    }
+    // The fill pass advanced each start to the next node's start; shift back
+    for (int v = graph->node_count; v > 0; v--) in_start[v] = in_start[v - 1];
+    in_start[0] = 0;
+
+    free(graph->edge_from);
+    free(graph->edge_to);
+    free(graph->edge_label);
+    graph->edge_from = NULL;
+    graph->edge_to = NULL;
+    graph->edge_label = NULL;
+    graph->edge_cap = 0;
+    graph->in_start = in_start;
+    graph->in_from = in_from;
+    graph->in_label = in_label;
+    return 0;
+}
+
+int attack_graph_paths(const AttackGraph *graph, const int *targets, int target_count, AttackPaths *paths) {
+    int n = graph->node_count;
+    memset(paths, 0, sizeof(*paths));
+    paths->dist = malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    paths->next = malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    paths->label = calloc((size_t)(n > 0 ? n : 1), sizeof(unsigned int));
+    int *queue = malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    if (!paths->dist || !paths->next || !paths->label || !queue) {
+        free(queue);
+        attack_paths_free(paths);
+        return -1;
+    }
+    for (int v = 0; v < n; v++) {
+        paths->dist[v] = -1;
+        paths->next[v] = -1;
+    }
+
+    int head = 0;
+    int tail = 0;
+    for (int t = 0; t < target_count; t++) {
+        int v = targets[t];
+        if (v < 0 || v >= n || paths->dist[v] == 0) continue;
+        paths->dist[v] = 0;
+        queue[tail++] = v;
+    }
+
+    // Walking edges backwards from the targets reaches each node first along
+    // one of its shortest paths, so the whole graph is answered in O(V + E)
+    while (head < tail) {
+        int v = queue[head++];
+        for (long e = graph->in_start[v]; e < graph->in_start[v + 1]; e++) {
+            int u = graph->in_from[e];
+            if (paths->dist[u] >= 0) continue;
+            paths->dist[u] = paths->dist[v] + 1;
+            paths->next[u] = v;
+            paths->label[u] = graph->in_label[e];
+            queue[tail++] = u;
+            paths->reachable++;
+        }
+    }
+
+    free(queue);
+    return 0;
+}
+
+void attack_paths_free(AttackPaths *paths) {
+    free(paths->dist);
+    free(paths->next);
+    free(paths->label);
+    memset(paths, 0, sizeof(*paths));
+}
+
+void attack_graph_free(AttackGraph *graph) {
+    free(graph->edge_from);
+    free(graph->edge_to);
+    free(graph->edge_label);
+    free(graph->in_start);
+    free(graph->in_from);
+    free(graph->in_label);
+    memset(graph, 0, sizeof(*graph));
+}
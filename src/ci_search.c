@@ -0,0 +1,162 @@
+#include "ci_search.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define CI_SEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+const unsigned char ci_fold_table[256] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+    0x40, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f,
+    0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f,
+    0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+    0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+    0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+    0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+    0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf,
+    0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf,
+    0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef,
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff,
+};
+
+// Compare n bytes ignoring ASCII case
+static int ci_equal(const unsigned char *a, const unsigned char *b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (ci_fold_table[a[i]] != ci_fold_table[b[i]]) return 0;
+    }
+    return 1;
+}
+
+const char *ci_search_scalar(const char *haystack, size_t hlen, const char *needle, size_t nlen) {
+    if (nlen == 0) return haystack;
+    if (hlen < nlen) return NULL;
+
+    const unsigned char *h = (const unsigned char *)haystack;
+    const unsigned char *n = (const unsigned char *)needle;
+    unsigned char first = ci_fold_table[n[0]];
+    for (size_t i = 0; i <= hlen - nlen; i++) {
+        if (ci_fold_table[h[i]] == first && ci_equal(h + i + 1, n + 1, nlen - 1)) {
+            return haystack + i;
+        }
+    }
+    return NULL;
+}
+
+#ifdef CI_SEARCH_X86
+// Vector search compares the folded first and last needle bytes against every
+// window position at once and only verifies the full needle where both agree.
+
+static inline __m128i fold_sse2(__m128i v) {
+    // Bytes in 'A'..'Z' map to a signed range below -128 + 26 after the bias
+    const __m128i bias = _mm_set1_epi8((char)(0x80 - 'A'));
+    const __m128i limit = _mm_set1_epi8((char)(-128 + 26));
+    __m128i upper = _mm_cmpgt_epi8(limit, _mm_add_epi8(v, bias));
+    return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+static const char *ci_search_sse2(const char *haystack, size_t hlen, const char *needle, size_t nlen) {
+    const unsigned char *h = (const unsigned char *)haystack;
+    const unsigned char *n = (const unsigned char *)needle;
+    const __m128i first = _mm_set1_epi8((char)ci_fold_table[n[0]]);
+    const __m128i last = _mm_set1_epi8((char)ci_fold_table[n[nlen - 1]]);
+
+    size_t i = 0;
+    for (; i + nlen - 1 + 16 <= hlen; i += 16) {
+        __m128i block_first = fold_sse2(_mm_loadu_si128((const __m128i *)(h + i)));
+        __m128i block_last = fold_sse2(_mm_loadu_si128((const __m128i *)(h + i + nlen - 1)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last)));
+        while (mask) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if (ci_equal(h + i + bit + 1, n + 1, nlen - 2)) return haystack + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return ci_search_scalar(haystack + i, hlen - i, needle, nlen);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i fold_avx2(__m256i v) {
+    const __m256i bias = _mm256_set1_epi8((char)(0x80 - 'A'));
+    const __m256i limit = _mm256_set1_epi8((char)(-128 + 26));
+    __m256i upper = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(v, bias));
+    return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2")))
+static const char *ci_search_avx2(const char *haystack, size_t hlen, const char *needle, size_t nlen) {
+    const unsigned char *h = (const unsigned char *)haystack;
+    const unsigned char *n = (const unsigned char *)needle;
+    const __m256i first = _mm256_set1_epi8((char)ci_fold_table[n[0]]);
+    const __m256i last = _mm256_set1_epi8((char)ci_fold_table[n[nlen - 1]]);
+
+    size_t i = 0;
+    for (; i + nlen - 1 + 32 <= hlen; i += 32) {
+        __m256i block_first = fold_avx2(_mm256_loadu_si256((const __m256i *)(h + i)));
+        __m256i block_last = fold_avx2(_mm256_loadu_si256((const __m256i *)(h + i + nlen - 1)));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last)));
+        while (mask) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if (ci_equal(h + i + bit + 1, n + 1, nlen - 2)) {
+                _mm256_zeroupper();
+                return haystack + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    // Clear the upper YMM state explicitly: the compiler does not do it on every
+    // exit path, and a dirty upper half stalls the SSE code that runs next.
+    _mm256_zeroupper();
+    // Finish with 16-byte blocks, then the scalar tail
+    return ci_search_sse2(haystack + i, hlen - i, needle, nlen);
+}
+
+typedef const char *(*SearchFn)(const char *, size_t, const char *, size_t);
+
+static SearchFn select_search(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? ci_search_avx2 : ci_search_sse2;
+}
+#endif
+
+const char *ci_search(const char *haystack, size_t hlen, const char *needle, size_t nlen) {
+    if (nlen == 0) return haystack;
+    if (hlen < nlen) return NULL;
+#ifdef CI_SEARCH_X86
+    // Single-byte needles have no distinct last byte to filter on
+    if (nlen > 1 && hlen >= 16) {
+        static SearchFn search;
+        SearchFn fn = __atomic_load_n(&search, __ATOMIC_RELAXED);
+        if (!fn) {
+            fn = select_search();
+            __atomic_store_n(&search, fn, __ATOMIC_RELAXED);
+        }
+        return fn(haystack, hlen, needle, nlen);
+    }
+#endif
+    return ci_search_scalar(haystack, hlen, needle, nlen);
+}
+
+int ci_contains(const char *haystack, const char *needle) {
+    if (!haystack || !needle) return 0;
+    size_t nlen = strlen(needle);
+    if (nlen == 0) return 0;
+    return ci_search(haystack, strlen(haystack), needle, nlen) != NULL;
+}
+
+int ci_starts_with(const char *str, const char *prefix) {
+    if (!str || !prefix) return 0;
+    const unsigned char *s = (const unsigned char *)str;
+    const unsigned char *p = (const unsigned char *)prefix;
+    for (; *p; s++, p++) {
+        if (ci_fold_table[*s] != ci_fold_table[*p]) return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,451 @@
+#include "classifier.h"
+#include "ci_search.h"
+#include "dn.h"
+#include "error_handler.h"
+#include "group_table.h"
+#include "pattern_matcher.h"
+#include "rule_pack.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Per-scan verdict cache indexed by group ID
+typedef struct {
+    GroupVerdict *verdicts;
+    unsigned char *ready;  // 1 once verdicts[id] has been computed
+    int cap;
+    long hits;
+    long misses;
+} VerdictCache;
+
+static VerdictCache cache;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Built-in rule pack, used when no --rules file is given. Patterns are
+// case-sensitive substrings of the group's CN.
+static const char *admin_any[] = {
+    "Domain Admins", "Enterprise Admins", "Schema Admins", "Administrators",
+    "Group Policy Creator Owners", "Domain Controllers", "Administrator"
+};
+static const char *reset_any[] = { "Account Operators", "Help Desk", "Password Reset" };
+static const char *acl_any[] = {
+    "Backup Operators", "Server Operators", "Print Operators", "Remote Desktop Users", "Power Users"
+};
+static const char *service_any[] = { "Service", "SQL", "IIS", "Exchange" };
+static const char *delegation_any[] = { "Delegation", "Trusted" };
+static const char *read_secrets_all[] = { "Read", "Secret" };
+static const char *write_secrets_all[] = { "Write", "Secret" };
+
+#define PATTERNS(list) list, (int)(sizeof(list) / sizeof(list[0]))
+
+static const RuleSpec builtin_rules[] = {
+    // High risk for admin groups
+    { "admin-groups", PATTERNS(admin_any), NULL, 0, 0, PERM_ADMIN | PERM_PRIVILEGED, 40 },
+    // Medium-high risk for password reset
+    { "password-reset", PATTERNS(reset_any), NULL, 0, 0, PERM_RESET_PASSWORD | PERM_PRIVILEGED, 25 },
+    // Medium risk for ACL modification
+    { "acl-operators", PATTERNS(acl_any), NULL, 0, 0, PERM_MODIFY_ACL | PERM_PRIVILEGED, 20 },
+    // Medium risk for service accounts
+    { "service-accounts", PATTERNS(service_any), NULL, 0, 0, PERM_SERVICE_ACCT, 15 },
+    // High risk for delegation
+    { "delegation", PATTERNS(delegation_any), NULL, 0, 0, PERM_DELEGATE_AUTH, 30 },
+    // Medium risk for reading secrets
+    { "read-secrets", NULL, 0, PATTERNS(read_secrets_all), 0, PERM_READ_SECRETS, 20 },
+    // High risk for writing secrets
+    { "write-secrets", NULL, 0, PATTERNS(write_secrets_all), 0, PERM_WRITE_SECRETS, 35 },
+};
+
+// Rules compiled into a decision table: one shared automaton reports the
+// matched pattern IDs, and each row holds the any/all masks over those IDs
+// plus the verdict to apply when the row fires. Exact CN names (RULE_MATCH_CN)
+// sit in a hash set and take the IDs after the automaton's patterns, so a CN
+// costs one scan plus one lookup.
+typedef struct {
+    PatternMatcher *matcher;
+    size_t words;         // 64-bit words per pattern mask
+    size_t scan_words;    // Words the automaton itself reports
+    int pattern_count;    // Automaton patterns; name IDs start here
+    char **names;         // Exact CN names, case-folded
+    size_t *name_lengths;
+    int name_count;
+    int *name_slots;      // Open-addressing index: name + 1, 0 = empty
+    size_t name_slot_cap; // Power of two
+    int rule_count;
+    uint64_t *masks;      // Per rule: any mask then all mask, words each
+    unsigned char *has_any;
+    unsigned int *perms;
+    int *risk;
+} RuleTable;
+
+static RuleTable rules;
+static pthread_once_t rules_once = PTHREAD_ONCE_INIT;
+
+static void free_table(RuleTable *table) {
+    pattern_matcher_free(table->matcher);
+    for (int i = 0; i < table->name_count; i++) free(table->names[i]);
+    free(table->names);
+    free(table->name_lengths);
+    free(table->name_slots);
+    free(table->masks);
+    free(table->has_any);
+    free(table->perms);
+    free(table->risk);
+    memset(table, 0, sizeof(*table));
+}
+
+static uint32_t hash_name(const char *s, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= ci_fold_table[(unsigned char)s[i]];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int find_name(const RuleTable *table, const char *name, size_t len) {
+    if (table->name_slot_cap == 0) return -1;
+    size_t pos = hash_name(name, len) & (table->name_slot_cap - 1);
+    while (table->name_slots[pos] != 0) {
+        int index = table->name_slots[pos] - 1;
+        if (table->name_lengths[index] == len) {
+            size_t i = 0;
+            while (i < len && table->names[index][i] == (char)ci_fold_table[(unsigned char)name[i]]) i++;
+            if (i == len) return index;
+        }
+        pos = (pos + 1) & (table->name_slot_cap - 1);
+    }
+    return -1;
+}
+
+// Add an exact CN name; identical names share one index
+static int add_name(RuleTable *table, const char *name) {
+    size_t len = strlen(name);
+    int index = find_name(table, name, len);
+    if (index >= 0) return index;
+
+    if ((size_t)(table->name_count + 1) * 2 > table->name_slot_cap) {
+        size_t new_cap = table->name_slot_cap == 0 ? 16 : table->name_slot_cap * 2;
+        int *slots = calloc(new_cap, sizeof(int));
+        char **names = realloc(table->names, new_cap * sizeof(char *));
+        if (names) table->names = names;
+        size_t *lengths = realloc(table->name_lengths, new_cap * sizeof(size_t));
+        if (lengths) table->name_lengths = lengths;
+        if (!slots || !names || !lengths) {
+            free(slots);
+            return -1;
+        }
+        for (int i = 0; i < table->name_count; i++) {
+            size_t pos = hash_name(table->names[i], table->name_lengths[i]) & (new_cap - 1);
+            while (slots[pos] != 0) pos = (pos + 1) & (new_cap - 1);
+            slots[pos] = i + 1;
+        }
+        free(table->name_slots);
+        table->name_slots = slots;
+        table->name_slot_cap = new_cap;
+    }
+
+    char *copy = malloc(len + 1);
+    if (!copy) return -1;
+    for (size_t i = 0; i <= len; i++) copy[i] = (char)ci_fold_table[(unsigned char)name[i]];
+    index = table->name_count++;
+    table->names[index] = copy;
+    table->name_lengths[index] = len;
+    size_t pos = hash_name(copy, len) & (table->name_slot_cap - 1);
+    while (table->name_slots[pos] != 0) pos = (pos + 1) & (table->name_slot_cap - 1);
+    table->name_slots[pos] = index + 1;
+    return index;
+}
+
+// Automaton pattern IDs are stored as is, name indexes as -2 - index until
+// the pattern count is known
+static int add_patterns(RuleTable *table, const char **patterns, int count,
+                        unsigned int flags, int *ids) {
+    for (int i = 0; i < count; i++) {
+        if (flags & RULE_MATCH_CN) {
+            int index = add_name(table, patterns[i]);
+            if (index < 0) return -1;
+            ids[i] = -2 - index;
+        } else {
+            ids[i] = pattern_matcher_add(table->matcher, patterns[i], flags);
+            if (ids[i] < 0) return -1;
+        }
+    }
+    return 0;
+}
+
+static int compile_table(const RuleSpec *specs, int count, RuleTable *table) {
+    memset(table, 0, sizeof(*table));
+    table->matcher = pattern_matcher_new();
+    if (!table->matcher) return -1;
+
+    int total = 0;
+    for (int r = 0; r < count; r++) {
+        total += specs[r].any_count + specs[r].all_count;
+    }
+    int *ids = malloc((size_t)(total > 0 ? total : 1) * sizeof(int));
+    if (!ids) goto fail;
+
+    // Register every pattern first so the mask width is known
+    int next = 0;
+    for (int r = 0; r < count; r++) {
+        if (add_patterns(table, specs[r].any_of, specs[r].any_count,
+                         specs[r].match_flags, ids + next) != 0 ||
+            add_patterns(table, specs[r].all_of, specs[r].all_count,
+                         specs[r].match_flags, ids + next + specs[r].any_count) != 0) {
+            goto fail;
+        }
+        next += specs[r].any_count + specs[r].all_count;
+    }
+    if (pattern_matcher_compile(table->matcher) != 0) goto fail;
+
+    table->pattern_count = pattern_matcher_count(table->matcher);
+    table->scan_words = pattern_matcher_words(table->matcher);
+    table->words = ((size_t)(table->pattern_count + table->name_count) + 63) / 64;
+    if (table->words < table->scan_words) table->words = table->scan_words;
+    for (int i = 0; i < total; i++) {
+        if (ids[i] <= -2) ids[i] = table->pattern_count + (-2 - ids[i]);
+    }
+    table->rule_count = count;
+    table->masks = calloc((size_t)(count > 0 ? count : 1) * 2 * table->words, sizeof(uint64_t));
+    table->has_any = calloc((size_t)(count > 0 ? count : 1), 1);
+    table->perms = calloc((size_t)(count > 0 ? count : 1), sizeof(unsigned int));
+    table->risk = calloc((size_t)(count > 0 ? count : 1), sizeof(int));
+    if (!table->masks || !table->has_any || !table->perms || !table->risk) goto fail;
+
+    next = 0;
+    for (int r = 0; r < count; r++) {
+        uint64_t *any_mask = table->masks + (size_t)r * 2 * table->words;
+        uint64_t *all_mask = any_mask + table->words;
+        for (int i = 0; i < specs[r].any_count; i++, next++) {
+            any_mask[ids[next] >> 6] |= 1ULL << (ids[next] & 63);
+        }
+        for (int i = 0; i < specs[r].all_count; i++, next++) {
+            all_mask[ids[next] >> 6] |= 1ULL << (ids[next] & 63);
+        }
+        table->has_any[r] = specs[r].any_count > 0;
+        table->perms[r] = specs[r].perms;
+        table->risk[r] = specs[r].risk;
+    }
+
+    free(ids);
+    return 0;
+
+fail:
+    free(ids);
+    free_table(table);
+    return -1;
+}
+
+static void compile_builtin_rules(void) {
+    if (rules.matcher) return; // A rule pack was loaded first
+    if (compile_table(builtin_rules, (int)(sizeof(builtin_rules) / sizeof(builtin_rules[0])), &rules) != 0) {
+        log_error("Failed to compile built-in group rules");
+    }
+}
+
+int classifier_load_rules(const char *path) {
+    RulePack pack;
+    if (rule_pack_load(path, &pack) != 0) return -1;
+
+    RuleTable table;
+    int rc = compile_table(pack.rules, pack.count, &table);
+    rule_pack_free(&pack);
+    if (rc != 0) {
+        log_error("Failed to compile rule pack: %s", path);
+        return -1;
+    }
+
+    free_table(&rules);
+    rules = table;
+    classifier_reset_cache();
+    return 0;
+}
+
+static void classify_cn(const char *cn, size_t len, GroupVerdict *verdict) {
+    verdict->perms = 0;
+    verdict->risk = 0;
+
+    pthread_once(&rules_once, compile_builtin_rules);
+    if (!rules.matcher) return;
+
+    // One pass over the CN finds every rule pattern it contains, one lookup
+    // whether it is an exact name
+    uint64_t stack_hits[4];
+    uint64_t *hits = rules.words <= 4 ? stack_hits : malloc(rules.words * sizeof(uint64_t));
+    if (!hits) return;
+    pattern_matcher_scan(rules.matcher, cn, len, hits);
+    for (size_t w = rules.scan_words; w < rules.words; w++) hits[w] = 0;
+    int name = find_name(&rules, cn, len);
+    if (name >= 0) {
+        int id = rules.pattern_count + name;
+        hits[id >> 6] |= 1ULL << (id & 63);
+    }
+
+    const size_t words = rules.words;
+    const uint64_t *mask = rules.masks;
+    for (int r = 0; r < rules.rule_count; r++, mask += 2 * words) {
+        const uint64_t *all_mask = mask + words;
+        int any = !rules.has_any[r];
+        int all = 1;
+        for (size_t w = 0; w < words; w++) {
+            any |= (hits[w] & mask[w]) != 0;
+            all &= (hits[w] & all_mask[w]) == all_mask[w];
+        }
+        if (any && all) {
+            verdict->perms |= rules.perms[r];
+            verdict->risk += rules.risk[r];
+        }
+    }
+
+    if (hits != stack_hits) free(hits);
+}
+
+void classify_group(const char *group, GroupVerdict *verdict) {
+    size_t len = strlen(group);
+    size_t pos = 0;
+    DnRdn rdn;
+    if (dn_next_rdn(group, len, &pos, &rdn) != 1) {
+        classify_cn(group, len, verdict);
+        return;
+    }
+    if (!rdn.escaped) {
+        classify_cn(rdn.value, rdn.value_len, verdict);
+        return;
+    }
+    char stack_cn[256];
+    char *cn = rdn.value_len <= sizeof(stack_cn) ? stack_cn : malloc(rdn.value_len);
+    if (!cn) {
+        verdict->perms = 0;
+        verdict->risk = 0;
+        return;
+    }
+    classify_cn(cn, dn_unescape(&rdn, cn), verdict);
+    if (cn != stack_cn) free(cn);
+}
+
+static int grow_cache(int min_cap) {
+    int new_cap = cache.cap == 0 ? 256 : cache.cap;
+    while (new_cap < min_cap) new_cap *= 2;
+
+    GroupVerdict *verdicts = realloc(cache.verdicts, (size_t)new_cap * sizeof(GroupVerdict));
+    if (!verdicts) return -1;
+    cache.verdicts = verdicts;
+    unsigned char *ready = realloc(cache.ready, (size_t)new_cap);
+    if (!ready) return -1;
+    memset(ready + cache.cap, 0, (size_t)(new_cap - cache.cap));
+    cache.ready = ready;
+    cache.cap = new_cap;
+    return 0;
+}
+
+void classifier_lookup(int id, GroupVerdict *out) {
+    pthread_mutex_lock(&cache_lock);
+    if (id < cache.cap && cache.ready[id]) {
+        cache.hits++;
+        *out = cache.verdicts[id];
+        pthread_mutex_unlock(&cache_lock);
+        return;
+    }
+    cache.misses++;
+    pthread_mutex_unlock(&cache_lock);
+
+    size_t len = 0;
+    const char *cn = group_table_leaf(id, &len);
+    if (cn) {
+        classify_cn(cn, len, out);
+    } else {
+        out->perms = 0;
+        out->risk = 0;
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    if (id < cache.cap || grow_cache(id + 1) == 0) {
+        cache.verdicts[id] = *out;
+        cache.ready[id] = 1;
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
+
+void apply_perm_bits(ADUser *user, unsigned int perms) {
+    user->perms.isAdmin = (perms & PERM_ADMIN) != 0;
+    user->perms.canResetPasswords = (perms & PERM_RESET_PASSWORD) != 0;
+    user->perms.canModifyACLs = (perms & PERM_MODIFY_ACL) != 0;
+    user->perms.canDelegateAuth = (perms & PERM_DELEGATE_AUTH) != 0;
+    user->perms.hasServiceAcct = (perms & PERM_SERVICE_ACCT) != 0;
+    user->perms.isPrivileged = (perms & PERM_PRIVILEGED) != 0;
+    user->perms.canReadSecrets = (perms & PERM_READ_SECRETS) != 0;
+    user->perms.canWriteSecrets = (perms & PERM_WRITE_SECRETS) != 0;
+}
+
+unsigned int user_perm_bits(const ADUser *user) {
+    unsigned int perms = 0;
+    if (user->perms.isAdmin) perms |= PERM_ADMIN;
+    if (user->perms.canResetPasswords) perms |= PERM_RESET_PASSWORD;
+    if (user->perms.canModifyACLs) perms |= PERM_MODIFY_ACL;
+    if (user->perms.canDelegateAuth) perms |= PERM_DELEGATE_AUTH;
+    if (user->perms.hasServiceAcct) perms |= PERM_SERVICE_ACCT;
+    if (user->perms.isPrivileged) perms |= PERM_PRIVILEGED;
+    if (user->perms.canReadSecrets) perms |= PERM_READ_SECRETS;
+    if (user->perms.canWriteSecrets) perms |= PERM_WRITE_SECRETS;
+    return perms;
+}
+
+GroupVerdict *classifier_verdict_table(int *count_out) {
+    int count = group_table_count();
+    GroupVerdict *table = malloc((size_t)(count > 0 ? count : 1) * sizeof(GroupVerdict));
+    *count_out = 0;
+    if (!table) return NULL;
+
+    // Classify only the groups no earlier lookup has seen; these are the misses
+    for (int id = 0; id < count; id++) {
+        pthread_mutex_lock(&cache_lock);
+        int ready = id < cache.cap && cache.ready[id];
+        if (ready) table[id] = cache.verdicts[id];
+        pthread_mutex_unlock(&cache_lock);
+        if (ready) continue;
+
+        size_t len = 0;
+        const char *cn = group_table_leaf(id, &len);
+        if (cn) {
+            classify_cn(cn, len, &table[id]);
+        } else {
+            table[id].perms = 0;
+            table[id].risk = 0;
+        }
+
+        pthread_mutex_lock(&cache_lock);
+        cache.misses++;
+        if (id < cache.cap || grow_cache(id + 1) == 0) {
+            cache.verdicts[id] = table[id];
+            cache.ready[id] = 1;
+        }
+        pthread_mutex_unlock(&cache_lock);
+    }
+
+    *count_out = count;
+    return table;
+}
+
+void classifier_record_hits(long hits) {
+    pthread_mutex_lock(&cache_lock);
+    cache.hits += hits;
+    pthread_mutex_unlock(&cache_lock);
+}
+
+void classifier_reset_cache(void) {
+    pthread_mutex_lock(&cache_lock);
+    if (cache.ready) {
+        memset(cache.ready, 0, (size_t)cache.cap);
+    }
+    cache.hits = 0;
+    cache.misses = 0;
+    pthread_mutex_unlock(&cache_lock);
+}
+
+void classifier_cache_stats(long *hits, long *misses) {
+    pthread_mutex_lock(&cache_lock);
+    if (hits) *hits = cache.hits;
+    if (misses) *misses = cache.misses;
+    pthread_mutex_unlock(&cache_lock);
+}
@@ -1,3 +1,4 @@
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include "config.h"
@@ -10,11 +11,29 @@ static char *get_env_or_default(const char *env_name, const char *default_val) {
     return strdup(default_val);
 }
 
+static int get_env_int_or_default(const char *env_name, int default_val) {
+    char *val = getenv(env_name);
+    if (val && strlen(val) > 0) {
+        char *end = NULL;
+        long parsed = strtol(val, &end, 10);
+        if (end && *end == '\0' && parsed >= 0 && parsed <= INT_MAX) {
+            return (int)parsed;
+        }
+    }
+    return default_val;
+}
+
 int load_env_config(Config *config) {
     config->ldap_uri = get_env_or_default(ENV_LDAP_URI, DEFAULT_LDAP_URI);
     config->bind_dn  = get_env_or_default(ENV_BIND_DN, DEFAULT_BIND_DN);
     config->bind_pw  = get_env_or_default(ENV_BIND_PW, DEFAULT_BIND_PW);
     config->base_dn  = get_env_or_default(ENV_BASE_DN, DEFAULT_BASE_DN);
+    config->page_size = get_env_int_or_default(ENV_PAGE_SIZE, DEFAULT_PAGE_SIZE);
+    config->scan_workers = get_env_int_or_default(ENV_SCAN_WORKERS, DEFAULT_SCAN_WORKERS);
+    config->delta_scan = get_env_int_or_default(ENV_DELTA_SCAN, DEFAULT_DELTA_SCAN);
+    config->state_dir = get_env_or_default(ENV_STATE_DIR, DEFAULT_STATE_DIR);
+    config->threads = get_env_int_or_default(ENV_THREADS, DEFAULT_THREADS);
+    config->snapshot_file = get_env_or_default(ENV_SNAPSHOT_FILE, DEFAULT_SNAPSHOT_FILE);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "csv_writer.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define WRITER_BUFFER (1024 * 1024)
+
+// Bytes that force a field to be quoted, plus NUL to end C strings
+static const unsigned char csv_special[256] = {
+    [0] = 1, [','] = 1, ['"'] = 1, ['\n'] = 1, ['\r'] = 1,
+};
+
+int csv_writer_init(CsvWriter *w, int fd) {
+    memset(w, 0, sizeof(*w));
+    w->fd = fd;
+    w->cap = WRITER_BUFFER;
+    w->buf = malloc(w->cap);
+    if (!w->buf) {
+        w->error = 1;
+        return -1;
+    }
+    return 0;
+}
+
+static void write_all(CsvWriter *w, const char *s, size_t n) {
+    while (n > 0 && !w->error) {
+        ssize_t written = write(w->fd, s, n);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) {
+            w->error = 1;
+            break;
+        }
+        s += written;
+        n -= (size_t)written;
+    }
+}
+
+static void flush(CsvWriter *w) {
+    write_all(w, w->buf, w->len);
+    w->len = 0;
+}
+
+// Room for n more bytes (n <= cap); NULL once the writer has failed
+static char *reserve(CsvWriter *w, size_t n) {
+    if (w->cap - w->len < n) flush(w);
+    return w->error ? NULL : w->buf + w->len;
+}
+
+static void put(CsvWriter *w, const char *s, size_t n) {
+    if (n > w->cap) {
+        flush(w);
+        write_all(w, s, n);
+        return;
+    }
+    char *p = reserve(w, n);
+    if (!p) return;
+    memcpy(p, s, n);
+    w->len += n;
+}
+
+static void put_char(CsvWriter *w, char c) {
+    char *p = reserve(w, 1);
+    if (!p) return;
+    *p = c;
+    w->len++;
+}
+
+static void separator(CsvWriter *w) {
+    if (w->fields++ > 0) put_char(w, ',');
+}
+
+void csv_writer_append(CsvWriter *w, const char *s, size_t len) {
+    const char *quote;
+    while ((quote = memchr(s, '"', len)) != NULL) {
+        size_t n = (size_t)(quote - s) + 1;
+        put(w, s, n);
+        put_char(w, '"');
+        s += n;
+        len -= n;
+    }
+    put(w, s, len);
+}
+
+void csv_writer_begin_quoted(CsvWriter *w) {
+    separator(w);
+    put_char(w, '"');
+}
+
+void csv_writer_end_quoted(CsvWriter *w) {
+    put_char(w, '"');
+}
+
+static void quoted_field(CsvWriter *w, const char *s, size_t len) {
+    csv_writer_begin_quoted(w);
+    csv_writer_append(w, s, len);
+    csv_writer_end_quoted(w);
+}
+
+// Unquoted field, separator included, in one copy
+static void plain_field(CsvWriter *w, const char *s, size_t len) {
+    if (len >= w->cap) {
+        separator(w);
+        put(w, s, len);
+        return;
+    }
+    char *p = reserve(w, len + 1);
+    if (!p) return;
+    if (w->fields++ > 0) {
+        *p++ = ',';
+        w->len++;
+    }
+    memcpy(p, s, len);
+    w->len += len;
+}
+
+void csv_writer_field(CsvWriter *w, const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (csv_special[(unsigned char)s[i]] && s[i] != '\0') {
+            quoted_field(w, s, len);
+            return;
+        }
+    }
+    plain_field(w, s, len);
+}
+
+#define SHORT_FIELD 128
+
+void csv_writer_string(CsvWriter *w, const char *s) {
+    // Short plain values (names, mail addresses) are copied while they are
+    // checked; a quote-worthy or long value is measured first instead
+    char *start = reserve(w, SHORT_FIELD + 1);
+    if (!start) return;
+    char *p = start + (w->fields > 0);
+    *start = ',';
+    for (size_t i = 0; i < SHORT_FIELD; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (csv_special[c]) {
+            if (c != '\0') break;
+            w->fields++;
+            w->len += (size_t)(p - start);
+            return;
+        }
+        *p++ = (char)c;
+    }
+
+    // One pass finds both the length and whether the value needs quotes
+    size_t len = 0;
+    while (!csv_special[(unsigned char)s[len]]) len++;
+    if (s[len] != '\0') {
+        quoted_field(w, s, len + strlen(s + len));
+        return;
+    }
+    plain_field(w, s, len);
+}
+
+static char *format_int(char *p, long value) {
+    // Permission flags are 0 or 1 on almost every row
+    if (value >= 0 && value < 10) {
+        *p++ = (char)('0' + value);
+        return p;
+    }
+    char digits[24];
+    char *d = digits + sizeof(digits);
+    unsigned long v = value < 0 ? 0ul - (unsigned long)value : (unsigned long)value;
+    do {
+        *--d = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    if (value < 0) *p++ = '-';
+    size_t n = (size_t)(digits + sizeof(digits) - d);
+    memcpy(p, d, n);
+    return p + n;
+}
+
+void csv_writer_int(CsvWriter *w, long value) {
+    csv_writer_ints(w, &value, 1);
+}
+
+void csv_writer_ints(CsvWriter *w, const long *values, int count) {
+    // Separator, sign and 20 digits at most per value
+    char *start = reserve(w, (size_t)count * 22);
+    if (!start) return;
+    char *p = start;
+    for (int i = 0; i < count; i++) {
+        if (w->fields++ > 0) *p++ = ',';
+        p = format_int(p, values[i]);
+    }
+    w->len += (size_t)(p - start);
+}
+
+void csv_writer_end_row(CsvWriter *w) {
+    char *p = reserve(w, 2);
+    if (p) {
+        p[0] = '\r';
+        p[1] = '\n';
+        w->len += 2;
+    }
+    w->fields = 0;
+}
+
+int csv_cells_build(CsvCells *cells, char *const *values, const size_t *lengths, int count) {
+    memset(cells, 0, sizeof(*cells));
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += lengths[i];
+        for (const char *q = memchr(values[i], '"', lengths[i]); q;
+             q = memchr(q + 1, '"', lengths[i] - (size_t)(q + 1 - values[i]))) {
+            total++;
+        }
+    }
+    cells->heap = malloc(total > 0 ? total : 1);
+    cells->offsets = malloc(((size_t)count + 1) * sizeof(size_t));
+    if (!cells->heap || !cells->offsets) {
+        csv_cells_free(cells);
+        return -1;
+    }
+    size_t pos = 0;
+    for (int i = 0; i < count; i++) {
+        cells->offsets[i] = pos;
+        for (size_t j = 0; j < lengths[i]; j++) {
+            if (values[i][j] == '"') cells->heap[pos++] = '"';
+            cells->heap[pos++] = values[i][j];
+        }
+    }
+    cells->offsets[count] = pos;
+    cells->count = count;
+    return 0;
+}
+
+void csv_cells_free(CsvCells *cells) {
+    free(cells->heap);
+    free(cells->offsets);
+    memset(cells, 0, sizeof(*cells));
+}
+
+int csv_writer_cell_list(CsvWriter *w, const CsvCells *cells, const int *ids, int count, char sep) {
+    size_t total = 0;
+    int listed = 0;
+    for (int i = 0; i < count; i++) {
+        int id = ids[i];
+        if (id < 0 || id >= cells->count) continue;
+        total += cells->offsets[id + 1] - cells->offsets[id] + 1;
+        listed++;
+    }
+    if (listed == 0) return 0;
+
+    // Separator and quotes; the cells already carry their escapes, so the
+    // whole field is sized up front and copied in one reservation
+    total += 2;
+    char *p = total <= w->cap ? reserve(w, total) : NULL;
+    if (!p) {
+        csv_writer_begin_quoted(w);
+        int written = 0;
+        for (int i = 0; i < count; i++) {
+            int id = ids[i];
+            if (id < 0 || id >= cells->count) continue;
+            if (written++ > 0) put_char(w, sep);
+            put(w, cells->heap + cells->offsets[id], cells->offsets[id + 1] - cells->offsets[id]);
+        }
+        csv_writer_end_quoted(w);
+        return listed;
+    }
+    char *start = p;
+    if (w->fields++ > 0) *p++ = ',';
+    *p++ = '"';
+    int written = 0;
+    for (int i = 0; i < count; i++) {
+        int id = ids[i];
+        if (id < 0 || id >= cells->count) continue;
+        if (written++ > 0) *p++ = sep;
+        size_t len = cells->offsets[id + 1] - cells->offsets[id];
+        memcpy(p, cells->heap + cells->offsets[id], len);
+        p += len;
+    }
+    *p++ = '"';
+    w->len += (size_t)(p - start);
+    return listed;
+}
+
+int csv_writer_finish(CsvWriter *w) {
+    if (w->buf) flush(w);
+    free(w->buf);
+    w->buf = NULL;
+    return w->error ? -1 : 0;
+}
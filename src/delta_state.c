@@ -0,0 +1,271 @@
+#include "delta_state.h"
+#include "error_handler.h"
+#include "group_table.h"
+#include <errno.h>
+#include <json-c/json.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+
+#define DELTA_STATE_VERSION 4
+
+static uint64_t fnv1a64(uint64_t hash, const char *s) {
+    for (; s && *s; s++) {
+        hash ^= (unsigned char)*s;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+char *delta_state_path(const Config *config) {
+    uint64_t hash = 14695981039346656037ULL;
+    hash = fnv1a64(hash, config->ldap_uri);
+    hash = fnv1a64(hash, "\n");
+    hash = fnv1a64(hash, config->base_dn);
+
+    size_t len = strlen(config->state_dir) + 32;
+    char *path = malloc(len);
+    if (!path) return NULL;
+    snprintf(path, len, "%s/%016llx.json", config->state_dir, (unsigned long long)hash);
+    return path;
+}
+
+static char *dup_field(Arena *arena, struct json_object *obj, const char *key) {
+    struct json_object *val = NULL;
+    if (json_object_object_get_ex(obj, key, &val) && json_object_is_type(val, json_type_string)) {
+        return arena_strndup(arena, json_object_get_string(val), (size_t)json_object_get_string_len(val));
+    }
+    return NULL;
+}
+
+int delta_state_load(const char *path, DeltaState *state, Arena *arena) {
+    memset(state, 0, sizeof(*state));
+
+    struct json_object *root = json_object_from_file(path);
+    if (!root) return -1;
+
+    struct json_object *version = NULL;
+    struct json_object *usn = NULL;
+    struct json_object *users = NULL;
+    if (!json_object_object_get_ex(root, "version", &version) ||
+        json_object_get_int(version) != DELTA_STATE_VERSION ||
+        !json_object_object_get_ex(root, "highest_usn", &usn) ||
+        !json_object_object_get_ex(root, "users", &users) ||
+        !json_object_is_type(users, json_type_array)) {
+        log_error("Ignoring incompatible delta state file: %s", path);
+        json_object_put(root);
+        return -1;
+    }
+
+    size_t count = json_object_array_length(users);
+    state->users = calloc(count > 0 ? count : 1, sizeof(ADUser));
+    if (!state->users) {
+        json_object_put(root);
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        struct json_object *item = json_object_array_get_idx(users, i);
+        if (!item || !json_object_is_type(item, json_type_object)) continue;
+        ADUser *user = &state->users[state->count++];
+        user->dn = dup_field(arena, item, "dn");
+        user->guid = dup_field(arena, item, "guid");
+        user->username = dup_field(arena, item, "username");
+        user->cn = dup_field(arena, item, "cn");
+        user->mail = dup_field(arena, item, "mail");
+        user->sid = dup_field(arena, item, "sid");
+
+        struct json_object *groups = NULL;
+        if (json_object_object_get_ex(item, "groups", &groups) && json_object_is_type(groups, json_type_array)) {
+            size_t group_count = json_object_array_length(groups);
+            user->group_ids = arena_alloc(arena, (group_count > 0 ? group_count : 1) * sizeof(int));
+            for (size_t g = 0; user->group_ids && g < group_count; g++) {
+                struct json_object *name = json_object_array_get_idx(groups, g);
+                if (!name || !json_object_is_type(name, json_type_string)) continue;
+                int id = group_table_intern(json_object_get_string(name), (size_t)json_object_get_string_len(name));
+                if (id >= 0) user->group_ids[user->group_count++] = id;
+            }
+        }
+
+        struct json_object *acl = NULL;
+        if (json_object_object_get_ex(item, "acl", &acl) && json_object_is_type(acl, json_type_array)) {
+            size_t grant_count = json_object_array_length(acl);
+            user->acl_grants = arena_alloc(arena, (grant_count > 0 ? grant_count : 1) * sizeof(AceGrant));
+            for (size_t g = 0; user->acl_grants && g < grant_count; g++) {
+                struct json_object *grant = json_object_array_get_idx(acl, g);
+                struct json_object *perms = NULL;
+                char *trustee = grant ? dup_field(arena, grant, "trustee") : NULL;
+                if (!trustee || !json_object_object_get_ex(grant, "perms", &perms)) continue;
+                user->acl_grants[user->acl_grant_count].trustee = trustee;
+                user->acl_grants[user->acl_grant_count].perms = (unsigned int)json_object_get_int(perms);
+                struct json_object *inherited = NULL;
+                user->acl_grants[user->acl_grant_count].inherited =
+                    json_object_object_get_ex(grant, "inherited", &inherited) && json_object_get_boolean(inherited);
+                user->acl_grant_count++;
+            }
+        }
+        struct json_object *acl_protected = NULL;
+        user->acl_protected = json_object_object_get_ex(item, "acl_protected", &acl_protected) &&
+                              json_object_get_boolean(acl_protected);
+    }
+
+    state->server = dup_field(arena, root, "server");
+    state->highest_usn = json_object_get_int64(usn);
+    json_object_put(root);
+    return 0;
+}
+
+static void add_field(struct json_object *obj, const char *key, const char *value) {
+    if (value) {
+        json_object_object_add(obj, key, json_object_new_string(value));
+    }
+}
+
+int delta_state_save(const char *path, const Config *config, const char *server, long long highest_usn,
+                     ADUser *users, int count) {
+    if (mkdir(config->state_dir, 0700) != 0 && errno != EEXIST) {
+        log_error("Failed to create state directory %s: %s", config->state_dir, strerror(errno));
+        return -1;
+    }
+
+    struct json_object *root = json_object_new_object();
+    json_object_object_add(root, "version", json_object_new_int(DELTA_STATE_VERSION));
+    json_object_object_add(root, "ldap_uri", json_object_new_string(config->ldap_uri));
+    json_object_object_add(root, "base_dn", json_object_new_string(config->base_dn));
+    add_field(root, "server", server);
+    json_object_object_add(root, "highest_usn", json_object_new_int64(highest_usn));
+
+    struct json_object *jusers = json_object_new_array();
+    for (int i = 0; i < count; i++) {
+        struct json_object *juser = json_object_new_object();
+        add_field(juser, "dn", users[i].dn);
+        add_field(juser, "guid", users[i].guid);
+        add_field(juser, "username", users[i].username);
+        add_field(juser, "cn", users[i].cn);
+        add_field(juser, "mail", users[i].mail);
+        struct json_object *groups = json_object_new_array();
+        for (int g = 0; g < users[i].group_count; g++) {
+            const char *name = group_table_name(users[i].group_ids[g]);
+            if (name) json_object_array_add(groups, json_object_new_string(name));
+        }
+        json_object_object_add(juser, "groups", groups);
+        add_field(juser, "sid", users[i].sid);
+        if (users[i].acl_grant_count > 0) {
+            struct json_object *acl = json_object_new_array();
+            for (int g = 0; g < users[i].acl_grant_count; g++) {
+                struct json_object *grant = json_object_new_object();
+                add_field(grant, "trustee", users[i].acl_grants[g].trustee);
+                json_object_object_add(grant, "perms", json_object_new_int((int)users[i].acl_grants[g].perms));
+                if (users[i].acl_grants[g].inherited) {
+                    json_object_object_add(grant, "inherited", json_object_new_boolean(1));
+                }
+                json_object_array_add(acl, grant);
+            }
+            json_object_object_add(juser, "acl", acl);
+        }
+        if (users[i].acl_protected) {
+            json_object_object_add(juser, "acl_protected", json_object_new_boolean(1));
+        }
+        json_object_array_add(jusers, juser);
+    }
+    json_object_object_add(root, "users", jusers);
+
+    // Write to a temporary file first so an interrupted run never leaves a torn state
+    size_t tmp_len = strlen(path) + 5;
+    char *tmp_path = malloc(tmp_len);
+    if (!tmp_path) {
+        json_object_put(root);
+        return -1;
+    }
+    snprintf(tmp_path, tmp_len, "%s.tmp", path);
+
+    int rc = 0;
+    if (json_object_to_file_ext(tmp_path, root, JSON_C_TO_STRING_PLAIN) != 0 ||
+        rename(tmp_path, path) != 0) {
+        log_error("Failed to write delta state file: %s", path);
+        remove(tmp_path);
+        rc = -1;
+    }
+
+    free(tmp_path);
+    json_object_put(root);
+    return rc;
+}
+
+// Identity used to line up stored and changed entries
+static const char *merge_key(const ADUser *user) {
+    if (user->guid && user->guid[0] != '\0') return user->guid;
+    return user->dn ? user->dn : "";
+}
+
+static int merge_key_cmp(const void *a, const void *b) {
+    return strcasecmp(merge_key(a), merge_key(b));
+}
+
+static int guid_cmp(const void *a, const void *b) {
+    return strcasecmp(*(char * const *)a, *(char * const *)b);
+}
+
+ADUser *delta_merge(DeltaState *state,
+                    ADUser *changed,
+                    int changed_count,
+                    char **deleted_guids,
+                    int deleted_count,
+                    int *count_out) {
+    int total = state->count + changed_count;
+    ADUser *merged = malloc((size_t)(total > 0 ? total : 1) * sizeof(ADUser));
+    if (!merged) {
+        *count_out = 0;
+        return NULL;
+    }
+
+    if (changed_count > 1) {
+        // A user both changed and re-read for a group membership change is
+        // listed twice; both copies come from this run, keep one
+        qsort(changed, (size_t)changed_count, sizeof(ADUser), merge_key_cmp);
+        int unique = 1;
+        for (int i = 1; i < changed_count; i++) {
+            if (merge_key_cmp(&changed[unique - 1], &changed[i]) == 0) {
+                changed[unique - 1] = changed[i];
+            } else {
+                changed[unique++] = changed[i];
+            }
+        }
+        changed_count = unique;
+    }
+    if (deleted_count > 1) {
+        qsort(deleted_guids, (size_t)deleted_count, sizeof(char *), guid_cmp);
+    }
+
+    int count = 0;
+    for (int i = 0; i < state->count; i++) {
+        ADUser *prev = &state->users[i];
+        if (changed_count > 0 &&
+            bsearch(prev, changed, (size_t)changed_count, sizeof(ADUser), merge_key_cmp)) {
+            continue;
+        }
+        if (deleted_count > 0 && prev->guid) {
+            const char *key = prev->guid;
+            if (bsearch(&key, deleted_guids, (size_t)deleted_count, sizeof(char *), guid_cmp)) {
+                continue;
+            }
+        }
+        merged[count++] = *prev;
+    }
+
+    if (changed_count > 0) {
+        memcpy(merged + count, changed, (size_t)changed_count * sizeof(ADUser));
+        count += changed_count;
+    }
+
+    free(state->users);
+    state->users = NULL;
+    state->count = 0;
+    free(changed);
+
+    *count_out = count;
+    return merged;
+}
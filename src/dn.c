@@ -0,0 +1,142 @@
+#include "dn.h"
+#include "ci_search.h"
+#include <string.h>
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Decode the escape at s[0] == '\\'; sets *consumed to the bytes read
+static char decode_escape(const char *s, size_t avail, size_t *consumed) {
+    if (avail >= 3 && hex_value(s[1]) >= 0 && hex_value(s[2]) >= 0) {
+        *consumed = 3;
+        return (char)(hex_value(s[1]) << 4 | hex_value(s[2]));
+    }
+    *consumed = 2;
+    return s[1];
+}
+
+int dn_next_rdn(const char *dn, size_t len, size_t *pos, DnRdn *rdn) {
+    size_t i = *pos;
+    while (i < len && dn[i] == ' ') i++;
+    if (i >= len) {
+        *pos = len;
+        return 0;
+    }
+
+    rdn->type = dn + i;
+    while (i < len && dn[i] != '=' && dn[i] != ',' && dn[i] != '\\') i++;
+    if (i >= len || dn[i] != '=') return -1;
+    rdn->type_len = (size_t)(dn + i - rdn->type);
+    while (rdn->type_len > 0 && rdn->type[rdn->type_len - 1] == ' ') rdn->type_len--;
+    if (rdn->type_len == 0) return -1;
+
+    i++;
+    while (i < len && dn[i] == ' ') i++;
+    rdn->value = dn + i;
+    rdn->escaped = 0;
+    // Trailing spaces are dropped unless escaped, so track the last byte that counts
+    size_t end = i;
+    while (i < len && dn[i] != ',') {
+        if (dn[i] == '\\') {
+            if (i + 1 >= len) return -1;
+            rdn->escaped = 1;
+            i += 2;
+            end = i;
+        } else {
+            if (dn[i] != ' ') end = i + 1;
+            i++;
+        }
+    }
+    rdn->value_len = end - (size_t)(rdn->value - dn);
+    *pos = i < len ? i + 1 : len;
+    return 1;
+}
+
+size_t dn_parent_offset(const char *dn, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (dn[i] == '\\') {
+            i++;
+        } else if (dn[i] == ',') {
+            i++;
+            while (i < len && dn[i] == ' ') i++;
+            return i;
+        }
+    }
+    return len;
+}
+
+size_t dn_unescape(const DnRdn *rdn, char *out) {
+    if (!rdn->escaped) {
+        memcpy(out, rdn->value, rdn->value_len);
+        return rdn->value_len;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < rdn->value_len;) {
+        if (rdn->value[i] == '\\') {
+            size_t consumed;
+            out[n++] = decode_escape(rdn->value + i, rdn->value_len - i, &consumed);
+            i += consumed;
+        } else {
+            out[n++] = rdn->value[i++];
+        }
+    }
+    return n;
+}
+
+// Characters RFC 4514 requires escaped anywhere in a value
+static int must_escape(char c) {
+    return c == '"' || c == '+' || c == ',' || c == ';' || c == '<' || c == '>' || c == '\\';
+}
+
+static size_t fold_opaque(const char *s, size_t len, char *out) {
+    for (size_t i = 0; i < len; i++) out[i] = (char)ci_fold_table[(unsigned char)s[i]];
+    out[len] = '\0';
+    return len;
+}
+
+size_t dn_canonicalize(const char *dn, size_t len, char *out) {
+    size_t n = 0;
+    size_t pos = 0;
+    DnRdn rdn;
+    int rc;
+    while ((rc = dn_next_rdn(dn, len, &pos, &rdn)) == 1) {
+        if (n > 0) out[n++] = ',';
+        for (size_t i = 0; i < rdn.type_len; i++) out[n++] = (char)ci_fold_table[(unsigned char)rdn.type[i]];
+        out[n++] = '=';
+
+        // A leading '#' introduces a BER hex string, which is compared as written
+        if (rdn.value_len > 0 && rdn.value[0] == '#') {
+            for (size_t i = 0; i < rdn.value_len; i++) out[n++] = (char)ci_fold_table[(unsigned char)rdn.value[i]];
+            continue;
+        }
+        // Unescaped '+' separates the values of a multi-valued RDN and stays as is
+        for (size_t i = 0; i < rdn.value_len;) {
+            if (rdn.value[i] != '\\') {
+                out[n++] = (char)ci_fold_table[(unsigned char)rdn.value[i++]];
+                continue;
+            }
+            size_t consumed;
+            char c = decode_escape(rdn.value + i, rdn.value_len - i, &consumed);
+            int edge_space = c == ' ' && (i == 0 || i + consumed == rdn.value_len);
+            if (must_escape(c) || edge_space || (c == '#' && i == 0)) out[n++] = '\\';
+            out[n++] = (char)ci_fold_table[(unsigned char)c];
+            i += consumed;
+        }
+    }
+    if (rc < 0 || n == 0) return fold_opaque(dn, len, out);
+    out[n] = '\0';
+    return n;
+}
+
+uint32_t dn_hash(const char *canonical, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)canonical[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,426 @@
+#include "effective_rights.h"
+#include "classifier.h"
+#include "dn.h"
+#include "security_descriptor.h"
+#include "wellknown.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// An ACE of a container descriptor that grants rights of interest
+typedef struct {
+    const char *trustee;        // Trustee SID string
+    unsigned int self_perms;    // Rights over the container itself, 0 for inherit-only
+    unsigned int child_perms;   // Rights over the children inheriting it, 0 if not inheritable
+    unsigned char flags;        // ACE flags
+    const char *inherit_class;  // Only children of this class inherit it; NULL for all
+} RightsAce;
+
+typedef struct {
+    const char *dn;
+    size_t dn_len;
+    const char *object_class;
+    int protected_dacl;
+    int ace_first;              // RightsAce range in the pool
+    int ace_count;
+    int parent;                 // Container holding this one, -1 if not recorded
+    int depth;                  // RDN count
+    int rooted;                 // No recorded parent: its own inherited ACEs stand in for the tree
+    int head;                   // First chain link seen by children, -1 for none
+    int up;                     // Next link after this container's own ACEs
+    AceGrant *grants;           // Effective grants over the container
+    int grant_count;
+    AceGrant *user_grants;      // Grants users inside inherit, flattened on first use
+    int user_grant_count;       // -1 until flattened
+} Container;
+
+typedef struct {
+    Container *containers;
+    int count;
+    int cap;
+    RightsAce *aces;
+    int ace_count;
+    int ace_cap;
+    int *slots;                 // DN index: container + 1, 0 = empty
+    size_t slot_cap;            // Power of two
+    Arena arena;                // DNs, trustee strings and container grants
+    EffectiveRightsStats stats;
+} RightsTree;
+
+static RightsTree tree;
+
+// FNV-1a over the case-folded DN; DN comparisons are case-insensitive
+static uint32_t hash_dn(const char *dn, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)tolower((unsigned char)dn[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int find_container(const char *dn, size_t len, size_t *pos_out) {
+    if (tree.slot_cap == 0) return -1;
+    size_t pos = hash_dn(dn, len) & (tree.slot_cap - 1);
+    while (tree.slots[pos] != 0) {
+        const Container *c = &tree.containers[tree.slots[pos] - 1];
+        if (c->dn_len == len && strncasecmp(c->dn, dn, len) == 0) return tree.slots[pos] - 1;
+        pos = (pos + 1) & (tree.slot_cap - 1);
+    }
+    if (pos_out) *pos_out = pos;
+    return -1;
+}
+
+static int grow_slots(void) {
+    size_t new_cap = tree.slot_cap == 0 ? 256 : tree.slot_cap * 2;
+    int *slots = calloc(new_cap, sizeof(int));
+    if (!slots) return -1;
+    for (int i = 0; i < tree.count; i++) {
+        size_t pos = hash_dn(tree.containers[i].dn, tree.containers[i].dn_len) & (new_cap - 1);
+        while (slots[pos] != 0) pos = (pos + 1) & (new_cap - 1);
+        slots[pos] = i + 1;
+    }
+    free(tree.slots);
+    tree.slots = slots;
+    tree.slot_cap = new_cap;
+    return 0;
+}
+
+static int push_ace(const char *trustee, size_t len, unsigned int self_perms, unsigned int child_perms,
+                    unsigned char flags, const char *inherit_class) {
+    if (tree.ace_count == tree.ace_cap) {
+        int new_cap = tree.ace_cap == 0 ? 256 : tree.ace_cap * 2;
+        RightsAce *aces = realloc(tree.aces, (size_t)new_cap * sizeof(RightsAce));
+        if (!aces) return -1;
+        tree.aces = aces;
+        tree.ace_cap = new_cap;
+    }
+    RightsAce *ace = &tree.aces[tree.ace_count];
+    ace->trustee = arena_strndup(&tree.arena, trustee, len);
+    if (!ace->trustee) return -1;
+    ace->self_perms = self_perms;
+    ace->child_perms = child_perms;
+    ace->flags = flags;
+    ace->inherit_class = inherit_class;
+    tree.ace_count++;
+    return 0;
+}
+
+// Class named by the inherited object type of an ACE, NULL if any child inherits it
+static const char *inherit_class(const AceView *ace) {
+    if (!ace->inherited_object_type) return NULL;
+    const WellKnownEntry *entry = wellknown_guid(ace->inherited_object_type);
+    // A class missing from the table matches none of the objects tracked here
+    return entry && entry->kind == WELLKNOWN_CLASS ? entry->name : "";
+}
+
+int effective_rights_add_container(const char *dn, const char *object_class, const void *data, size_t len) {
+    SecurityDescriptor sd;
+    if (!dn || sd_parse(data, len, &sd) != 0) return 1;
+
+    if (tree.slot_cap == 0) {
+        arena_init(&tree.arena);
+    }
+    // Keep the load factor under one half
+    if ((size_t)(tree.count + 1) * 2 > tree.slot_cap && grow_slots() != 0) return -1;
+
+    size_t dn_len = strlen(dn);
+    size_t pos = 0;
+    if (find_container(dn, dn_len, &pos) >= 0) return 0;
+
+    if (tree.count == tree.cap) {
+        int new_cap = tree.cap == 0 ? 64 : tree.cap * 2;
+        Container *containers = realloc(tree.containers, (size_t)new_cap * sizeof(Container));
+        if (!containers) return -1;
+        tree.containers = containers;
+        tree.cap = new_cap;
+    }
+
+    int first = tree.ace_count;
+    char text[SID_STRING_MAX];
+    int text_len;
+    // The owner can rewrite the DACL; ownership is never inherited
+    if (sd.owner && sid_is_principal(sd.owner, sd.owner_len) &&
+        (text_len = sid_to_string(sd.owner, sd.owner_len, text, sizeof(text))) > 0 && !wellknown_expected_holder(text) &&
+        push_ace(text, (size_t)text_len, PERM_MODIFY_ACL, 0, 0, NULL) != 0) {
+        return -1;
+    }
+
+    AceIterator it;
+    AceView ace;
+    int rc;
+    sd_aces(&sd, &it);
+    while ((rc = sd_next_ace(&it, &ace)) > 0) {
+        if (ace.type != ACE_ACCESS_ALLOWED && ace.type != ACE_ACCESS_ALLOWED_OBJECT) continue;
+        if (!sid_is_principal(ace.sid, ace.sid_len)) continue;
+
+        unsigned int self_perms = ace_perms(&ace);
+        unsigned int child_perms = 0;
+        // Directory objects inherit through CONTAINER_INHERIT; the copy a child
+        // receives drops the inherit-only flag
+        if (ace.flags & ACE_CONTAINER_INHERIT) {
+            AceView copy = ace;
+            copy.flags &= (uint8_t)~ACE_INHERIT_ONLY;
+            child_perms = ace_perms(&copy);
+        }
+        if (!self_perms && !child_perms) continue;
+
+        text_len = sid_to_string(ace.sid, ace.sid_len, text, sizeof(text));
+        if (text_len < 0 || wellknown_expected_holder(text)) continue;
+        if (push_ace(text, (size_t)text_len, self_perms, child_perms, ace.flags, inherit_class(&ace)) != 0) return -1;
+    }
+    if (rc < 0) {
+        tree.ace_count = first;
+        return 1;
+    }
+
+    Container *c = &tree.containers[tree.count];
+    memset(c, 0, sizeof(*c));
+    c->dn = arena_strndup(&tree.arena, dn, dn_len);
+    c->object_class = arena_strdup(&tree.arena, object_class ? object_class : "container");
+    if (!c->dn || !c->object_class) return -1;
+    c->dn_len = dn_len;
+    c->protected_dacl = sd.protected_dacl;
+    c->ace_first = first;
+    c->ace_count = tree.ace_count - first;
+    tree.slots[pos] = ++tree.count;
+    return 0;
+}
+
+// Add perms for trustee, merging with an earlier grant of the same trustee and origin
+static int merge_grant(AceGrant *grants, int count, const char *trustee, unsigned int perms, unsigned int inherited) {
+    for (int i = 0; i < count; i++) {
+        if (grants[i].inherited == inherited && strcmp(grants[i].trustee, trustee) == 0) {
+            grants[i].perms |= perms;
+            return count;
+        }
+    }
+    grants[count].trustee = (char *)trustee;
+    grants[count].perms = perms;
+    grants[count].inherited = inherited;
+    return count + 1;
+}
+
+// Upper bound of the grants the chain seen inside container parent can give
+static int chain_bound(int parent) {
+    int bound = 0;
+    for (int k = tree.containers[parent].head; k >= 0; k = tree.containers[k].up) {
+        bound += tree.containers[k].ace_count;
+    }
+    return bound;
+}
+
+// Merge the rights an object of object_class directly inside container parent
+// inherits: walk the chain link by link. NO_PROPAGATE ACEs reach only the
+// immediate children of the container that holds them.
+static int merge_chain(int parent, const char *object_class, AceGrant *grants, int count) {
+    for (int k = tree.containers[parent].head; k >= 0; k = tree.containers[k].up) {
+        const Container *link = &tree.containers[k];
+        for (int a = link->ace_first; a < link->ace_first + link->ace_count; a++) {
+            const RightsAce *ace = &tree.aces[a];
+            if (!ace->child_perms) continue;
+            if ((ace->flags & ACE_INHERITED) && !link->rooted) continue;
+            if ((ace->flags & ACE_NO_PROPAGATE_INHERIT) && k != parent) continue;
+            if (ace->inherit_class && strcmp(ace->inherit_class, object_class) != 0) continue;
+            count = merge_grant(grants, count, ace->trustee, ace->child_perms, 1);
+        }
+    }
+    return count;
+}
+
+static int depth_cmp(const void *a, const void *b) {
+    int ia = *(const int *)a;
+    int ib = *(const int *)b;
+    int da = tree.containers[ia].depth;
+    int db = tree.containers[ib].depth;
+    if (da != db) return da < db ? -1 : 1;
+    return (ia > ib) - (ia < ib);
+}
+
+// Effective grants over container index: its own ACEs (explicit ones, plus the
+// inherited ones when it is rooted) and whatever the parent's chain passes down
+static int container_grants(int index) {
+    Container *c = &tree.containers[index];
+    int inherit = c->parent >= 0 && !c->protected_dacl;
+    int bound = c->ace_count + (inherit ? chain_bound(c->parent) : 0);
+    if (bound == 0) return 0;
+
+    c->grants = arena_alloc(&tree.arena, (size_t)bound * sizeof(AceGrant));
+    if (!c->grants) return -1;
+    int count = 0;
+    for (int a = c->ace_first; a < c->ace_first + c->ace_count; a++) {
+        const RightsAce *ace = &tree.aces[a];
+        if (!ace->self_perms || ((ace->flags & ACE_INHERITED) && !c->rooted)) continue;
+        count = merge_grant(c->grants, count, ace->trustee, ace->self_perms, (ace->flags & ACE_INHERITED) != 0);
+    }
+    if (inherit) {
+        count = merge_chain(c->parent, c->object_class, c->grants, count);
+    }
+    c->grant_count = count;
+    return 0;
+}
+
+// Grants a user directly inside container index inherits, flattened into
+// arena once and shared by every user there
+static int user_set(int index, Arena *arena) {
+    Container *c = &tree.containers[index];
+    if (c->user_grant_count >= 0) return 0;
+
+    int bound = chain_bound(index);
+    c->user_grants = NULL;
+    c->user_grant_count = 0;
+    if (bound == 0) return 0;
+
+    AceGrant *grants = arena_alloc(arena, (size_t)bound * sizeof(AceGrant));
+    if (!grants) return -1;
+    int count = merge_chain(index, "user", grants, 0);
+    // The users outlive this table, so their trustee strings go to their arena
+    for (int g = 0; g < count; g++) {
+        grants[g].trustee = arena_strdup(arena, grants[g].trustee);
+        if (!grants[g].trustee) return -1;
+    }
+    c->user_grants = count > 0 ? grants : NULL;
+    c->user_grant_count = count;
+    tree.stats.user_sets++;
+    return 0;
+}
+
+int effective_rights_build(ADUser *users, int count, Arena *arena) {
+    memset(&tree.stats, 0, sizeof(tree.stats));
+    tree.stats.containers = tree.count;
+    if (tree.count == 0) return 0;
+
+    // Parents by DN; depth orders the walk so each parent is done first
+    for (int i = 0; i < tree.count; i++) {
+        Container *c = &tree.containers[i];
+        size_t off = dn_parent_offset(c->dn, c->dn_len);
+        c->parent = off < c->dn_len ? find_container(c->dn + off, c->dn_len - off, NULL) : -1;
+        c->depth = 0;
+        for (size_t rest = 0; rest < c->dn_len; c->depth++) {
+            rest += dn_parent_offset(c->dn + rest, c->dn_len - rest);
+        }
+        c->rooted = c->parent < 0;
+        c->head = -1;
+        c->up = -1;
+        c->grants = NULL;
+        c->grant_count = 0;
+        c->user_grants = NULL;
+        c->user_grant_count = -1;
+    }
+    int *order = malloc((size_t)tree.count * sizeof(int));
+    if (!order) return -1;
+    for (int i = 0; i < tree.count; i++) order[i] = i;
+    qsort(order, (size_t)tree.count, sizeof(int), depth_cmp);
+
+    for (int o = 0; o < tree.count; o++) {
+        int index = order[o];
+        Container *c = &tree.containers[index];
+        int own = 0;
+        for (int a = c->ace_first; a < c->ace_first + c->ace_count; a++) {
+            const RightsAce *ace = &tree.aces[a];
+            if (ace->child_perms && (c->rooted || !(ace->flags & ACE_INHERITED))) {
+                own = 1;
+                tree.stats.inheritable_aces++;
+            }
+        }
+
+        // A protected DACL starts a fresh chain; otherwise the parent's chain
+        // continues, behind this container's own ACEs if it adds any
+        c->up = c->parent >= 0 && !c->protected_dacl ? tree.containers[c->parent].head : -1;
+        c->head = own ? index : c->up;
+        if (own) {
+            tree.stats.chain_links++;
+        } else if (c->head >= 0) {
+            tree.stats.shared_chains++;
+        }
+        if (c->rooted) tree.stats.rooted++;
+        if (c->protected_dacl) tree.stats.protected_dacls++;
+
+        if (container_grants(index) != 0) {
+            free(order);
+            return -1;
+        }
+    }
+    free(order);
+
+    for (int i = 0; i < count; i++) {
+        ADUser *user = &users[i];
+        if (!user->dn) continue;
+        size_t len = strlen(user->dn);
+        size_t off = dn_parent_offset(user->dn, len);
+        int parent = off < len ? find_container(user->dn + off, len - off, NULL) : -1;
+        if (parent < 0) continue;
+        if (user_set(parent, arena) != 0) return -1;
+
+        const Container *c = &tree.containers[parent];
+        int inherited = user->acl_protected ? 0 : c->user_grant_count;
+        int explicit_count = 0;
+        for (int g = 0; g < user->acl_grant_count; g++) {
+            if (!user->acl_grants[g].inherited) explicit_count++;
+        }
+        tree.stats.users_inherited++;
+
+        // Inherited ACEs of the object's own descriptor are replaced by the tree's
+        if (explicit_count == user->acl_grant_count && inherited == 0) continue;
+        if (explicit_count == 0) {
+            user->acl_grants = inherited > 0 ? c->user_grants : NULL;
+            user->acl_grant_count = inherited;
+            continue;
+        }
+        AceGrant *grants = arena_alloc(arena, (size_t)(explicit_count + inherited) * sizeof(AceGrant));
+        if (!grants) return -1;
+        int n = 0;
+        for (int g = 0; g < user->acl_grant_count; g++) {
+            if (!user->acl_grants[g].inherited) grants[n++] = user->acl_grants[g];
+        }
+        if (inherited > 0) {
+            memcpy(grants + n, c->user_grants, (size_t)inherited * sizeof(AceGrant));
+        }
+        user->acl_grants = grants;
+        user->acl_grant_count = n + inherited;
+    }
+    return tree.stats.users_inherited;
+}
+
+int effective_rights_containers(void) {
+    return tree.count;
+}
+
+const char *effective_rights_container_dn(int container) {
+    return container >= 0 && container < tree.count ? tree.containers[container].dn : NULL;
+}
+
+int effective_rights_container_grants(int container, const AceGrant **grants) {
+    if (container < 0 || container >= tree.count) {
+        *grants = NULL;
+        return 0;
+    }
+    *grants = tree.containers[container].grants;
+    return tree.containers[container].grant_count;
+}
+
+int effective_rights_container_protected(int container) {
+    return container >= 0 && container < tree.count ? tree.containers[container].protected_dacl : 0;
+}
+
+int effective_rights_parent(const char *dn, size_t len) {
+    size_t off = dn_parent_offset(dn, len);
+    return off < len ? find_container(dn + off, len - off, NULL) : -1;
+}
+
+void effective_rights_stats(EffectiveRightsStats *stats) {
+    *stats = tree.stats;
+    stats->containers = tree.count;
+}
+
+void effective_rights_reset(void) {
+    free(tree.containers);
+    free(tree.aces);
+    free(tree.slots);
+    if (tree.slot_cap > 0) {
+        arena_destroy(&tree.arena);
+    }
+    memset(&tree, 0, sizeof(tree));
+}
@@ -1,75 +1,217 @@
 #include "export.h"
+#include "csv_writer.h"
+#include "group_table.h"
+#include "json_writer.h"
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <json-c/json.h>
+#include <unistd.h>
 
 // Helper to safely return a string or "N/A"
 static const char* safe_str(const char* s) {
     return (s && strlen(s) > 0) ? s : "N/A";
 }
 
-void export_to_csv(const char *filename, ADUser *users, int count) {
-    FILE *fp = fopen(filename, "w");
-    if (!fp) {
-        perror("[ERROR] fopen failed");
-        return;
+static const char *const csv_flag_columns[] = {
+    "IsAdmin", "CanResetPass", "CanModifyACL", "CanDelegate", "HasServiceAcct", "CanReadSecrets", "CanWriteSecrets", "Risk"
+};
+
+static int open_export(const char *filename) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) perror("[ERROR] open failed");
+    return fd;
+}
+
+// safe_str without the strlen; csv_writer_string measures the value anyway
+static const char *csv_str(const char *s) {
+    return (s && s[0]) ? s : "N/A";
+}
+
+// Username, CN and Email columns
+static void csv_identity(CsvWriter *w, const ADUser *u) {
+    csv_writer_string(w, csv_str(u->username));
+    csv_writer_string(w, csv_str(u->cn));
+    csv_writer_string(w, csv_str(u->mail));
+}
+
+static void csv_flags(CsvWriter *w, const ADUser *u) {
+    const long values[] = {
+        u->perms.isAdmin, u->perms.canResetPasswords, u->perms.canModifyACLs, u->perms.canDelegateAuth,
+        u->perms.hasServiceAcct, u->perms.canReadSecrets, u->perms.canWriteSecrets, u->risk,
+    };
+    csv_writer_ints(w, values, (int)(sizeof(values) / sizeof(values[0])));
+}
+
+static void csv_header(CsvWriter *w, const char *groups_column) {
+    csv_writer_string(w, "Username");
+    csv_writer_string(w, "CN");
+    csv_writer_string(w, "Email");
+    csv_writer_string(w, groups_column);
+    for (size_t i = 0; i < sizeof(csv_flag_columns) / sizeof(csv_flag_columns[0]); i++) {
+        csv_writer_string(w, csv_flag_columns[i]);
+    }
+    csv_writer_end_row(w);
+}
+
+// Start the writer and escape every group DN once, so each membership is a
+// plain copy; closes fd and returns -1 on allocation failure
+static int begin_csv(CsvWriter *w, CsvCells *groups, int fd, const char *filename) {
+    char *const *names = NULL;
+    const size_t *lengths = NULL;
+    int group_count = group_table_names(&names, &lengths);
+    if (csv_writer_init(w, fd) != 0 || csv_cells_build(groups, names, lengths, group_count) != 0) {
+        csv_writer_finish(w);
+        close(fd);
+        fprintf(stderr, "[ERROR] Out of memory exporting %s\n", filename);
+        return -1;
     }
+    return 0;
+}
+
+static int finish_csv(CsvWriter *w, int fd, const char *filename) {
+    int rc = csv_writer_finish(w);
+    if (close(fd) != 0) rc = -1;
+    if (rc != 0) fprintf(stderr, "[ERROR] Failed to write %s\n", filename);
+    return rc;
+}
+
+// One row per user; the Groups column holds every DN joined with semicolons,
+// since the DNs themselves are comma-separated
+void export_to_csv(const char *filename, ADUser *users, int count) {
+    int fd = open_export(filename);
+    if (fd < 0) return;
 
-    fprintf(fp, "Username,CN,Email,Groups,IsAdmin,CanResetPass,CanModifyACL,CanDelegate,HasServiceAcct,CanReadSecrets,CanWriteSecrets,Risk\n");
+    CsvWriter w;
+    CsvCells groups;
+    if (begin_csv(&w, &groups, fd, filename) != 0) return;
+    csv_header(&w, "Groups");
     for (int i = 0; i < count; i++) {
-        fprintf(fp, "%s,%s,%s,%s,%d,%d,%d,%d,%d,%d,%d,%d\n",
-                safe_str(users[i].username),
-                safe_str(users[i].cn),
-                safe_str(users[i].mail),
-                safe_str(users[i].memberOf),
-                users[i].perms.isAdmin,
-                users[i].perms.canResetPasswords,
-                users[i].perms.canModifyACLs,
-                users[i].perms.canDelegateAuth,
-                users[i].perms.hasServiceAcct,
-                users[i].perms.canReadSecrets,
-                users[i].perms.canWriteSecrets,
-                users[i].risk);
+        const ADUser *u = &users[i];
+        csv_identity(&w, u);
+        if (csv_writer_cell_list(&w, &groups, u->group_ids, u->group_count, ';') == 0) {
+            csv_writer_string(&w, csv_str(NULL));
+        }
+        csv_flags(&w, u);
+        csv_writer_end_row(&w);
     }
+    csv_cells_free(&groups);
+    if (finish_csv(&w, fd, filename) != 0) return;
 
-    fclose(fp);
     printf("[INFO] Exported %d users to %s (CSV)\n", count, filename);
 }
 
-void export_to_json(const char *filename, ADUser *users, int count) {
-    struct json_object *jarray = json_object_new_array();
+// One row per (user, group) membership, for memberships too large to read as
+// one cell; users without groups get a single row with Group N/A
+void export_to_csv_group_rows(const char *filename, ADUser *users, int count) {
+    int fd = open_export(filename);
+    if (fd < 0) return;
 
+    CsvWriter w;
+    CsvCells groups;
+    if (begin_csv(&w, &groups, fd, filename) != 0) return;
+    csv_header(&w, "Group");
+    long rows = 0;
     for (int i = 0; i < count; i++) {
-        struct json_object *juser = json_object_new_object();
-
-        json_object_object_add(juser, "username", json_object_new_string(safe_str(users[i].username)));
-        json_object_object_add(juser, "cn", json_object_new_string(safe_str(users[i].cn)));
-        json_object_object_add(juser, "email", json_object_new_string(safe_str(users[i].mail)));
-        json_object_object_add(juser, "groups", json_object_new_string(safe_str(users[i].memberOf)));
-        json_object_object_add(juser, "isAdmin", json_object_new_int(users[i].perms.isAdmin));
-        json_object_object_add(juser, "canResetPasswords", json_object_new_int(users[i].perms.canResetPasswords));
-        json_object_object_add(juser, "canModifyACLs", json_object_new_int(users[i].perms.canModifyACLs));
-        json_object_object_add(juser, "canDelegateAuth", json_object_new_int(users[i].perms.canDelegateAuth));
-        json_object_object_add(juser, "hasServiceAcct", json_object_new_int(users[i].perms.hasServiceAcct));
-        json_object_object_add(juser, "canReadSecrets", json_object_new_int(users[i].perms.canReadSecrets));
-        json_object_object_add(juser, "canWriteSecrets", json_object_new_int(users[i].perms.canWriteSecrets));
-        json_object_object_add(juser, "risk", json_object_new_int(users[i].risk));
-
-        json_object_array_add(jarray, juser);
+        const ADUser *u = &users[i];
+        int written = 0;
+        for (int g = 0; g < u->group_count; g++) {
+            if (u->group_ids[g] < 0 || u->group_ids[g] >= groups.count) continue;
+            csv_identity(&w, u);
+            csv_writer_cell_list(&w, &groups, &u->group_ids[g], 1, ',');
+            csv_flags(&w, u);
+            csv_writer_end_row(&w);
+            written++;
+        }
+        if (written == 0) {
+            csv_identity(&w, u);
+            csv_writer_string(&w, csv_str(NULL));
+            csv_flags(&w, u);
+            csv_writer_end_row(&w);
+            written = 1;
+        }
+        rows += written;
     }
+    csv_cells_free(&groups);
+    if (finish_csv(&w, fd, filename) != 0) return;
+
+    printf("[INFO] Exported %ld rows for %d users to %s (CSV, one row per group)\n", rows, count, filename);
+}
 
+static void write_user(JsonWriter *w, const ADUser *u) {
+    json_writer_begin_object(w);
+    json_writer_key(w, "username");
+    json_writer_string(w, safe_str(u->username));
+    json_writer_key(w, "cn");
+    json_writer_string(w, safe_str(u->cn));
+    json_writer_key(w, "email");
+    json_writer_string(w, safe_str(u->mail));
+    char *groups = group_table_join(u->group_ids, u->group_count, ",");
+    json_writer_key(w, "groups");
+    json_writer_string(w, safe_str(groups));
+    free(groups);
+    json_writer_key(w, "isAdmin");
+    json_writer_int(w, u->perms.isAdmin);
+    json_writer_key(w, "canResetPasswords");
+    json_writer_int(w, u->perms.canResetPasswords);
+    json_writer_key(w, "canModifyACLs");
+    json_writer_int(w, u->perms.canModifyACLs);
+    json_writer_key(w, "canDelegateAuth");
+    json_writer_int(w, u->perms.canDelegateAuth);
+    json_writer_key(w, "hasServiceAcct");
+    json_writer_int(w, u->perms.hasServiceAcct);
+    json_writer_key(w, "canReadSecrets");
+    json_writer_int(w, u->perms.canReadSecrets);
+    json_writer_key(w, "canWriteSecrets");
+    json_writer_int(w, u->perms.canWriteSecrets);
+    json_writer_key(w, "risk");
+    json_writer_int(w, u->risk);
+    json_writer_end_object(w);
+}
+
+// Flush the writer and close fp; reports and returns -1 on a failed write
+static int finish_export(JsonWriter *w, FILE *fp, const char *filename) {
+    int rc = json_writer_finish(w, NULL);
+    if (fclose(fp) != 0) rc = -1;
+    if (rc != 0) fprintf(stderr, "[ERROR] Failed to write %s\n", filename);
+    return rc;
+}
+
+// Users are streamed one object at a time, so memory stays flat however many
+// are exported; the layout matches json-c's pretty printer
+void export_to_json(const char *filename, ADUser *users, int count) {
     FILE *fp = fopen(filename, "w");
     if (!fp) {
         perror("[ERROR] fopen failed");
-        json_object_put(jarray);
         return;
     }
 
-    fprintf(fp, "%s\n", json_object_to_json_string_ext(jarray, JSON_C_TO_STRING_PRETTY));
-    fclose(fp);
-
-    json_object_put(jarray);
+    JsonWriter w;
+    json_writer_init(&w, fp, JSON_WRITER_PRETTY);
+    json_writer_begin_array(&w);
+    for (int i = 0; i < count; i++) write_user(&w, &users[i]);
+    json_writer_end_array(&w);
+    json_writer_raw(&w, "\n", 1);
+    if (finish_export(&w, fp, filename) != 0) return;
 
     printf("[INFO] Exported %d users to %s (JSON)\n", count, filename);
-}
\ No newline at end of file
+}
+
+// Same user records as export_to_json, compact, one per line
+void export_to_ndjson(const char *filename, ADUser *users, int count) {
+    FILE *fp = fopen(filename, "w");
+    if (!fp) {
+        perror("[ERROR] fopen failed");
+        return;
+    }
+
+    JsonWriter w;
+    json_writer_init(&w, fp, 0);
+    for (int i = 0; i < count; i++) {
+        write_user(&w, &users[i]);
+        json_writer_raw(&w, "\n", 1);
+    }
+    if (finish_export(&w, fp, filename) != 0) return;
+
+    printf("[INFO] Exported %d users to %s (NDJSON)\n", count, filename);
+}
@@ -0,0 +1,287 @@
+#include "group_graph.h"
+#include "group_table.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int *members;          // Edge list as recorded: members[i] is nested in parents[i]
+    int *parents;
+    long edge_count;
+    long edge_cap;
+
+    int node_count;        // Group IDs 0 .. node_count - 1 at build time
+    int *comp;             // Node -> component, -1 for groups without edges
+    int *parent_bit;       // Node -> bit in the ancestor bitsets, -1 if not a parent
+    int *bit_group;        // Bit -> node
+    int words;             // uint64_t words per bitset, 0 when nothing is nested
+    uint64_t *bits;        // comp_count bitsets of words each, indexed by component
+    GroupGraphStats stats;
+} GroupGraph;
+
+static GroupGraph graph;
+
+int group_graph_add_edge(int member, int parent) {
+    if (member < 0 || parent < 0) return 0;
+    if (graph.edge_count == graph.edge_cap) {
+        long new_cap = graph.edge_cap == 0 ? 256 : graph.edge_cap * 2;
+        int *members = realloc(graph.members, (size_t)new_cap * sizeof(int));
+        if (!members) return -1;
+        graph.members = members;
+        int *parents = realloc(graph.parents, (size_t)new_cap * sizeof(int));
+        if (!parents) return -1;
+        graph.parents = parents;
+        graph.edge_cap = new_cap;
+    }
+    graph.members[graph.edge_count] = member;
+    graph.parents[graph.edge_count] = parent;
+    graph.edge_count++;
+    return 0;
+}
+
+static void clear_closure(void) {
+    free(graph.comp);
+    free(graph.parent_bit);
+    free(graph.bit_group);
+    free(graph.bits);
+    graph.comp = NULL;
+    graph.parent_bit = NULL;
+    graph.bit_group = NULL;
+    graph.bits = NULL;
+    graph.words = 0;
+    graph.node_count = 0;
+    memset(&graph.stats, 0, sizeof(graph.stats));
+}
+
+// Tarjan's algorithm, iterative so deep nesting chains cannot overflow the
+// stack. A component is emitted only after every component reachable from it,
+// i.e. in reverse topological order of the condensed graph, so each ancestor
+// bitset is the OR of bitsets that are already final.
+static int condense(const int *out_start, const int *out_edges) {
+    int n = graph.node_count;
+    int *index = malloc((size_t)n * sizeof(int));
+    int *low = malloc((size_t)n * sizeof(int));
+    int *stack = malloc((size_t)n * sizeof(int));
+    int *call_node = malloc((size_t)n * sizeof(int));
+    int *call_edge = malloc((size_t)n * sizeof(int));
+    char *on_stack = calloc((size_t)n, 1);
+    if (!index || !low || !stack || !call_node || !call_edge || !on_stack) {
+        free(index);
+        free(low);
+        free(stack);
+        free(call_node);
+        free(call_edge);
+        free(on_stack);
+        return -1;
+    }
+    for (int v = 0; v < n; v++) index[v] = -1;
+
+    int next_index = 0;
+    int comp_count = 0;
+    for (int root = 0; root < n; root++) {
+        if (index[root] != -1 || out_start[root] == out_start[root + 1]) continue;
+
+        int sp = 0;
+        int cp = 0;
+        index[root] = low[root] = next_index++;
+        stack[sp++] = root;
+        on_stack[root] = 1;
+        call_node[cp] = root;
+        call_edge[cp++] = out_start[root];
+
+        while (cp > 0) {
+            int v = call_node[cp - 1];
+            if (call_edge[cp - 1] < out_start[v + 1]) {
+                int w = out_edges[call_edge[cp - 1]++];
+                if (index[w] == -1) {
+                    index[w] = low[w] = next_index++;
+                    stack[sp++] = w;
+                    on_stack[w] = 1;
+                    call_node[cp] = w;
+                    call_edge[cp++] = out_start[w];
+                } else if (on_stack[w] && index[w] < low[v]) {
+                    low[v] = index[w];
+                }
+                continue;
+            }
+
+            cp--;
+            if (cp > 0 && low[v] < low[call_node[cp - 1]]) {
+                low[call_node[cp - 1]] = low[v];
+            }
+            if (low[v] != index[v]) continue;
+
+            // v roots a component: its members are on the stack above it
+            int base = sp - 1;
+            while (stack[base] != v) base--;
+            int c = comp_count++;
+            uint64_t *bits = graph.bits + (size_t)c * (size_t)graph.words;
+            int cyclic = sp - base > 1;
+            for (int k = base; k < sp; k++) {
+                graph.comp[stack[k]] = c;
+                on_stack[stack[k]] = 0;
+            }
+            for (int k = base; k < sp; k++) {
+                int m = stack[k];
+                if (graph.parent_bit[m] >= 0) bits[graph.parent_bit[m] / 64] |= 1ULL << (graph.parent_bit[m] % 64);
+                for (int e = out_start[m]; e < out_start[m + 1]; e++) {
+                    int w = out_edges[e];
+                    if (w == m) cyclic = 1;
+                    if (graph.comp[w] == c) continue;
+                    const uint64_t *succ = graph.bits + (size_t)graph.comp[w] * (size_t)graph.words;
+                    for (int word = 0; word < graph.words; word++) bits[word] |= succ[word];
+                }
+            }
+            if (cyclic) graph.stats.cycles++;
+            sp = base;
+        }
+    }
+
+    free(index);
+    free(low);
+    free(stack);
+    free(call_node);
+    free(call_edge);
+    free(on_stack);
+    return comp_count;
+}
+
+int group_graph_build(void) {
+    clear_closure();
+
+    int n = group_table_count();
+    for (long e = 0; e < graph.edge_count; e++) {
+        if (graph.members[e] >= n) n = graph.members[e] + 1;
+        if (graph.parents[e] >= n) n = graph.parents[e] + 1;
+    }
+    graph.node_count = n;
+    graph.stats.groups = n;
+    graph.stats.edges = graph.edge_count;
+    if (graph.edge_count == 0 || n == 0) return 0;
+
+    // Edges in CSR form: the groups each group is directly nested in
+    int *out_start = calloc((size_t)n + 1, sizeof(int));
+    int *out_edges = malloc((size_t)graph.edge_count * sizeof(int));
+    graph.comp = malloc((size_t)n * sizeof(int));
+    graph.parent_bit = malloc((size_t)n * sizeof(int));
+    if (!out_start || !out_edges || !graph.comp || !graph.parent_bit) {
+        free(out_start);
+        free(out_edges);
+        clear_closure();
+        return -1;
+    }
+    for (long e = 0; e < graph.edge_count; e++) out_start[graph.members[e] + 1]++;
+    for (int v = 0; v < n; v++) out_start[v + 1] += out_start[v];
+    int *fill = malloc((size_t)n * sizeof(int));
+    if (!fill) {
+        free(out_start);
+        free(out_edges);
+        clear_closure();
+        return -1;
+    }
+    memcpy(fill, out_start, (size_t)n * sizeof(int));
+    for (long e = 0; e < graph.edge_count; e++) out_edges[fill[graph.members[e]]++] = graph.parents[e];
+    free(fill);
+
+    // Only groups with group members can be reached through nesting, so the
+    // bitsets are as wide as that set rather than the whole group table
+    int nodes_with_edges = 0;
+    for (int v = 0; v < n; v++) {
+        graph.comp[v] = -1;
+        graph.parent_bit[v] = -1;
+    }
+    for (long e = 0; e < graph.edge_count; e++) graph.parent_bit[graph.parents[e]] = 0;
+    int parent_count = 0;
+    for (int v = 0; v < n; v++) {
+        if (graph.parent_bit[v] == 0) graph.parent_bit[v] = parent_count++;
+        if (out_start[v] != out_start[v + 1]) graph.stats.nested_groups++;
+        if (graph.parent_bit[v] >= 0 || out_start[v] != out_start[v + 1]) nodes_with_edges++;
+    }
+    graph.bit_group = malloc((size_t)parent_count * sizeof(int));
+    graph.words = (parent_count + 63) / 64;
+    graph.bits = calloc((size_t)nodes_with_edges * (size_t)graph.words, sizeof(uint64_t));
+    if (!graph.bit_group || !graph.bits) {
+        free(out_start);
+        free(out_edges);
+        clear_closure();
+        return -1;
+    }
+    for (int v = 0; v < n; v++) {
+        if (graph.parent_bit[v] >= 0) graph.bit_group[graph.parent_bit[v]] = v;
+    }
+
+    int comps = condense(out_start, out_edges);
+    free(out_start);
+    free(out_edges);
+    if (comps < 0) {
+        clear_closure();
+        return -1;
+    }
+
+    graph.stats.parents = parent_count;
+    graph.stats.bitset_bytes = (size_t)comps * (size_t)graph.words * sizeof(uint64_t);
+    return graph.stats.nested_groups;
+}
+
+int group_graph_scratch_init(GroupGraphScratch *scratch) {
+    memset(scratch, 0, sizeof(*scratch));
+    if (graph.stats.nested_groups == 0) return 0;
+
+    scratch->bits = malloc((size_t)graph.words * sizeof(uint64_t));
+    scratch->groups = malloc((size_t)graph.stats.parents * sizeof(int));
+    if (!scratch->bits || !scratch->groups) {
+        group_graph_scratch_free(scratch);
+        return -1;
+    }
+    scratch->words = graph.words;
+    return 0;
+}
+
+void group_graph_scratch_free(GroupGraphScratch *scratch) {
+    free(scratch->bits);
+    free(scratch->groups);
+    memset(scratch, 0, sizeof(*scratch));
+}
+
+int group_graph_nested(const int *ids, int count, GroupGraphScratch *scratch) {
+    if (scratch->words == 0) return 0;
+
+    uint64_t *bits = scratch->bits;
+    memset(bits, 0, (size_t)scratch->words * sizeof(uint64_t));
+    for (int i = 0; i < count; i++) {
+        int id = ids[i];
+        if (id < 0 || id >= graph.node_count || graph.comp[id] < 0) continue;
+        const uint64_t *comp_bits = graph.bits + (size_t)graph.comp[id] * (size_t)graph.words;
+        for (int word = 0; word < scratch->words; word++) bits[word] |= comp_bits[word];
+    }
+    // Direct memberships are scored as such, not a second time through nesting
+    for (int i = 0; i < count; i++) {
+        int id = ids[i];
+        if (id < 0 || id >= graph.node_count || graph.parent_bit[id] < 0) continue;
+        bits[graph.parent_bit[id] / 64] &= ~(1ULL << (graph.parent_bit[id] % 64));
+    }
+
+    int found = 0;
+    for (int word = 0; word < scratch->words; word++) {
+        for (uint64_t set = bits[word]; set; set &= set - 1) {
+            scratch->groups[found++] = graph.bit_group[word * 64 + __builtin_ctzll(set)];
+        }
+    }
+    return found;
+}
+
+long group_graph_edges(const int **members, const int **parents) {
+    *members = graph.members;
+    *parents = graph.parents;
+    return graph.edge_count;
+}
+
+void group_graph_stats(GroupGraphStats *stats) {
+    *stats = graph.stats;
+}
+
+void group_graph_reset(void) {
+    clear_closure();
+    free(graph.members);
+    free(graph.parents);
+    memset(&graph, 0, sizeof(graph));
+}
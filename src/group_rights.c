@@ -0,0 +1,52 @@
+#include "group_rights.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const AceGrant *grants;
+    int count;
+    int protected_dacl;
+} GroupGrants;
+
+static GroupGrants *groups;  // Indexed by group ID
+static int group_cap;
+
+int group_rights_set(int id, const AceGrant *grants, int count, int protected_dacl) {
+    if (id < 0) return 0;
+    if (id >= group_cap) {
+        int new_cap = group_cap == 0 ? 256 : group_cap;
+        while (new_cap <= id) new_cap *= 2;
+        GroupGrants *next = realloc(groups, (size_t)new_cap * sizeof(GroupGrants));
+        if (!next) return -1;
+        memset(next + group_cap, 0, (size_t)(new_cap - group_cap) * sizeof(GroupGrants));
+        groups = next;
+        group_cap = new_cap;
+    }
+    groups[id].grants = grants;
+    groups[id].count = count;
+    groups[id].protected_dacl = protected_dacl;
+    return 0;
+}
+
+int group_rights_get(int id, const AceGrant **grants) {
+    if (id < 0 || id >= group_cap) {
+        *grants = NULL;
+        return 0;
+    }
+    *grants = groups[id].grants;
+    return groups[id].count;
+}
+
+int group_rights_protected(int id) {
+    return id >= 0 && id < group_cap ? groups[id].protected_dacl : 0;
+}
+
+int group_rights_bound(void) {
+    return group_cap;
+}
+
+void group_rights_reset(void) {
+    free(groups);
+    groups = NULL;
+    group_cap = 0;
+}
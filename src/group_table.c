@@ -0,0 +1,262 @@
+#include "group_table.h"
+#include "dn.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Each entry is one allocation: the DN as first seen, its canonical form and
+// its decoded leaf RDN value, each NUL-terminated
+typedef struct {
+    char **names;      // Interned DNs indexed by group ID
+    size_t *lengths;
+    const char **canon;
+    size_t *canon_lengths;
+    const char **leaves;
+    size_t *leaf_lengths;
+    uint32_t *hashes;  // dn_hash of the canonical form
+    int count;
+    int cap;
+    int *slots;        // Open-addressing index: group ID + 1, 0 = empty
+    size_t slot_cap;   // Power of two
+} GroupTable;
+
+static GroupTable table;
+static pthread_mutex_t table_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Canonical DNs up to this size are built on the stack
+#define CANON_STACK 512
+
+typedef struct {
+    char stack[CANON_STACK];
+    char *text;
+    size_t len;
+    uint32_t hash;
+} CanonKey;
+
+static int canon_key(const char *dn, size_t len, CanonKey *key) {
+    key->text = 2 * len + 1 <= sizeof(key->stack) ? key->stack : malloc(2 * len + 1);
+    if (!key->text) return -1;
+    key->len = dn_canonicalize(dn, len, key->text);
+    key->hash = dn_hash(key->text, key->len);
+    return 0;
+}
+
+static void canon_key_free(CanonKey *key) {
+    if (key->text != key->stack) free(key->text);
+}
+
+static int lookup(const CanonKey *key, size_t *pos_out) {
+    size_t pos = key->hash & (table.slot_cap - 1);
+    while (table.slots[pos] != 0) {
+        int candidate = table.slots[pos] - 1;
+        if (table.hashes[candidate] == key->hash && table.canon_lengths[candidate] == key->len &&
+            memcmp(table.canon[candidate], key->text, key->len) == 0) {
+            return candidate;
+        }
+        pos = (pos + 1) & (table.slot_cap - 1);
+    }
+    if (pos_out) *pos_out = pos;
+    return -1;
+}
+
+// Copy the DN, canonical form and leaf value into one block
+static char *make_entry(const char *dn, size_t len, const CanonKey *key, size_t *leaf_off, size_t *leaf_len) {
+    char *block = malloc(len + 1 + key->len + 1 + len + 1);
+    if (!block) return NULL;
+    memcpy(block, dn, len);
+    block[len] = '\0';
+    memcpy(block + len + 1, key->text, key->len + 1);
+
+    *leaf_off = len + 1 + key->len + 1;
+    size_t pos = 0;
+    DnRdn rdn;
+    if (dn_next_rdn(dn, len, &pos, &rdn) == 1) {
+        *leaf_len = dn_unescape(&rdn, block + *leaf_off);
+    } else {
+        memcpy(block + *leaf_off, dn, len);
+        *leaf_len = len;
+    }
+    block[*leaf_off + *leaf_len] = '\0';
+    return block;
+}
+
+static int grow_slots(void) {
+    size_t new_cap = table.slot_cap == 0 ? 256 : table.slot_cap * 2;
+    int *slots = calloc(new_cap, sizeof(int));
+    if (!slots) return -1;
+    for (int id = 0; id < table.count; id++) {
+        size_t pos = table.hashes[id] & (new_cap - 1);
+        while (slots[pos] != 0) pos = (pos + 1) & (new_cap - 1);
+        slots[pos] = id + 1;
+    }
+    free(table.slots);
+    table.slots = slots;
+    table.slot_cap = new_cap;
+    return 0;
+}
+
+static int grow_entries(void) {
+    int new_cap = table.cap == 0 ? 128 : table.cap * 2;
+    char **names = realloc(table.names, (size_t)new_cap * sizeof(char *));
+    if (!names) return -1;
+    table.names = names;
+    size_t *lengths = realloc(table.lengths, (size_t)new_cap * sizeof(size_t));
+    if (!lengths) return -1;
+    table.lengths = lengths;
+    const char **canon = realloc(table.canon, (size_t)new_cap * sizeof(char *));
+    if (!canon) return -1;
+    table.canon = canon;
+    size_t *canon_lengths = realloc(table.canon_lengths, (size_t)new_cap * sizeof(size_t));
+    if (!canon_lengths) return -1;
+    table.canon_lengths = canon_lengths;
+    const char **leaves = realloc(table.leaves, (size_t)new_cap * sizeof(char *));
+    if (!leaves) return -1;
+    table.leaves = leaves;
+    size_t *leaf_lengths = realloc(table.leaf_lengths, (size_t)new_cap * sizeof(size_t));
+    if (!leaf_lengths) return -1;
+    table.leaf_lengths = leaf_lengths;
+    uint32_t *hashes = realloc(table.hashes, (size_t)new_cap * sizeof(uint32_t));
+    if (!hashes) return -1;
+    table.hashes = hashes;
+    table.cap = new_cap;
+    return 0;
+}
+
+int group_table_intern(const char *dn, size_t len) {
+    CanonKey key;
+    if (canon_key(dn, len, &key) != 0) return -1;
+    int id = -1;
+
+    pthread_mutex_lock(&table_lock);
+
+    // Keep the load factor under one half
+    if ((size_t)(table.count + 1) * 2 > table.slot_cap && grow_slots() != 0) {
+        pthread_mutex_unlock(&table_lock);
+        canon_key_free(&key);
+        return -1;
+    }
+
+    size_t pos = 0;
+    id = lookup(&key, &pos);
+    if (id < 0 && (table.count < table.cap || grow_entries() == 0)) {
+        size_t leaf_off = 0;
+        size_t leaf_len = 0;
+        char *name = make_entry(dn, len, &key, &leaf_off, &leaf_len);
+        if (name) {
+            id = table.count++;
+            table.names[id] = name;
+            table.lengths[id] = len;
+            table.canon[id] = name + len + 1;
+            table.canon_lengths[id] = key.len;
+            table.leaves[id] = name + leaf_off;
+            table.leaf_lengths[id] = leaf_len;
+            table.hashes[id] = key.hash;
+            table.slots[pos] = id + 1;
+        }
+    }
+
+    pthread_mutex_unlock(&table_lock);
+    canon_key_free(&key);
+    return id;
+}
+
+int group_table_find(const char *dn, size_t len) {
+    CanonKey key;
+    if (canon_key(dn, len, &key) != 0) return -1;
+
+    pthread_mutex_lock(&table_lock);
+    int id = table.slot_cap > 0 ? lookup(&key, NULL) : -1;
+    pthread_mutex_unlock(&table_lock);
+    canon_key_free(&key);
+    return id;
+}
+
+const char *group_table_name(int id) {
+    // Interned strings never move, but the index array may be reallocated by a
+    // concurrent intern, so the lookup itself is taken under the lock
+    const char *name = NULL;
+    pthread_mutex_lock(&table_lock);
+    if (id >= 0 && id < table.count) name = table.names[id];
+    pthread_mutex_unlock(&table_lock);
+    return name;
+}
+
+const char *group_table_leaf(int id, size_t *len) {
+    const char *leaf = NULL;
+    pthread_mutex_lock(&table_lock);
+    if (id >= 0 && id < table.count) {
+        leaf = table.leaves[id];
+        if (len) *len = table.leaf_lengths[id];
+    }
+    pthread_mutex_unlock(&table_lock);
+    return leaf;
+}
+
+int group_table_count(void) {
+    pthread_mutex_lock(&table_lock);
+    int count = table.count;
+    pthread_mutex_unlock(&table_lock);
+    return count;
+}
+
+int group_table_names(char *const **names, const size_t **lengths) {
+    pthread_mutex_lock(&table_lock);
+    *names = table.names;
+    *lengths = table.lengths;
+    int count = table.count;
+    pthread_mutex_unlock(&table_lock);
+    return count;
+}
+
+char *group_table_join(const int *ids, int count, const char *sep) {
+    if (!ids || count <= 0) return NULL;
+
+    size_t sep_len = strlen(sep);
+    size_t total = 1;
+    for (int i = 0; i < count; i++) {
+        if (ids[i] >= 0 && ids[i] < table.count) total += table.lengths[ids[i]] + sep_len;
+    }
+
+    char *out = malloc(total);
+    if (!out) return NULL;
+
+    size_t pos = 0;
+    for (int i = 0; i < count; i++) {
+        if (ids[i] < 0 || ids[i] >= table.count) continue;
+        if (pos > 0) {
+            memcpy(out + pos, sep, sep_len);
+            pos += sep_len;
+        }
+        memcpy(out + pos, table.names[ids[i]], table.lengths[ids[i]]);
+        pos += table.lengths[ids[i]];
+    }
+    out[pos] = '\0';
+    return out;
+}
+
+void group_table_write(FILE *fp, const int *ids, int count, const char *sep) {
+    int written = 0;
+    for (int i = 0; i < count; i++) {
+        if (ids[i] < 0 || ids[i] >= table.count) continue;
+        if (written++ > 0) fputs(sep, fp);
+        fwrite(table.names[ids[i]], 1, table.lengths[ids[i]], fp);
+    }
+}
+
+void group_table_reset(void) {
+    pthread_mutex_lock(&table_lock);
+    for (int i = 0; i < table.count; i++) {
+        free(table.names[i]);
+    }
+    free(table.names);
+    free(table.lengths);
+    free(table.canon);
+    free(table.canon_lengths);
+    free(table.leaves);
+    free(table.leaf_lengths);
+    free(table.hashes);
+    free(table.slots);
+    memset(&table, 0, sizeof(table));
+    pthread_mutex_unlock(&table_lock);
+}
@@ -0,0 +1,264 @@
+#include "json_writer.h"
+#include <json-c/json.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WRITER_BUFFER (256 * 1024)
+
+int json_writer_init(JsonWriter *w, FILE *fp, unsigned int flags) {
+    memset(w, 0, sizeof(*w));
+    w->fp = fp;
+    w->flags = flags;
+    w->cap = fp ? WRITER_BUFFER : 4096;
+    w->buf = malloc(w->cap);
+    if (!w->buf) {
+        w->error = 1;
+        return -1;
+    }
+    return 0;
+}
+
+void json_writer_flush(JsonWriter *w) {
+    if (!w->fp || w->len == 0) return;
+    if (fwrite(w->buf, 1, w->len, w->fp) != w->len) w->error = 1;
+    w->len = 0;
+}
+
+// Make room for n more bytes: flush a file sink, grow a memory sink
+static int reserve(JsonWriter *w, size_t n) {
+    if (w->len + n <= w->cap) return 0;
+    if (w->fp) {
+        json_writer_flush(w);
+        if (n <= w->cap) return 0;
+    }
+    size_t new_cap = w->cap;
+    while (new_cap < w->len + n) new_cap *= 2;
+    char *buf = realloc(w->buf, new_cap);
+    if (!buf) {
+        w->error = 1;
+        return -1;
+    }
+    w->buf = buf;
+    w->cap = new_cap;
+    return 0;
+}
+
+static void put(JsonWriter *w, const char *s, size_t n) {
+    if (w->error || reserve(w, n) != 0) return;
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+}
+
+static void put_char(JsonWriter *w, char c) {
+    if (w->error || reserve(w, 1) != 0) return;
+    w->buf[w->len++] = c;
+}
+
+static void indent(JsonWriter *w, int level) {
+    if (!(w->flags & JSON_WRITER_PRETTY)) return;
+    for (int i = 0; i < level; i++) put(w, "  ", 2);
+}
+
+// Separator and indent before an array element; object members get theirs
+// from json_writer_key
+static void before_value(JsonWriter *w) {
+    if (w->depth == 0 || w->in_object[w->depth - 1]) return;
+    if (w->has_items[w->depth - 1]) {
+        put_char(w, ',');
+        if (w->flags & JSON_WRITER_PRETTY) put_char(w, '\n');
+    }
+    w->has_items[w->depth - 1] = 1;
+    indent(w, w->depth);
+}
+
+static void open_container(JsonWriter *w, char bracket, int object) {
+    before_value(w);
+    if (w->depth == JSON_WRITER_MAX_DEPTH) {
+        w->error = 1;
+        return;
+    }
+    put_char(w, bracket);
+    // json-c breaks the line right after '[', but after '{' only per member
+    if (!object && (w->flags & JSON_WRITER_PRETTY)) put_char(w, '\n');
+    w->in_object[w->depth] = (unsigned char)object;
+    w->has_items[w->depth] = 0;
+    w->depth++;
+}
+
+static void close_container(JsonWriter *w, char bracket) {
+    if (w->depth == 0) {
+        w->error = 1;
+        return;
+    }
+    w->depth--;
+    // ...and mirrors that on close: '}' always starts a line, ']' only after
+    // an element, since '[' already broke the line
+    if (w->flags & JSON_WRITER_PRETTY) {
+        if (w->in_object[w->depth] || w->has_items[w->depth]) put_char(w, '\n');
+        indent(w, w->depth);
+    }
+    put_char(w, bracket);
+}
+
+void json_writer_begin_object(JsonWriter *w) {
+    open_container(w, '{', 1);
+}
+
+void json_writer_end_object(JsonWriter *w) {
+    close_container(w, '}');
+}
+
+void json_writer_begin_array(JsonWriter *w) {
+    open_container(w, '[', 0);
+}
+
+void json_writer_end_array(JsonWriter *w) {
+    close_container(w, ']');
+}
+
+static void put_escaped(JsonWriter *w, const char *s, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    size_t start = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\' && c != '/') continue;
+        put(w, s + start, i - start);
+        start = i + 1;
+        switch (c) {
+        case '\b': put(w, "\\b", 2); break;
+        case '\n': put(w, "\\n", 2); break;
+        case '\r': put(w, "\\r", 2); break;
+        case '\t': put(w, "\\t", 2); break;
+        case '\f': put(w, "\\f", 2); break;
+        case '"': put(w, "\\\"", 2); break;
+        case '\\': put(w, "\\\\", 2); break;
+        case '/': put(w, "\\/", 2); break;
+        default: {
+            char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+            put(w, esc, sizeof(esc));
+        }
+        }
+    }
+    put(w, s + start, len - start);
+}
+
+void json_writer_key(JsonWriter *w, const char *key) {
+    if (w->depth == 0 || !w->in_object[w->depth - 1]) {
+        w->error = 1;
+        return;
+    }
+    if (w->has_items[w->depth - 1]) put_char(w, ',');
+    if (w->flags & JSON_WRITER_PRETTY) put_char(w, '\n');
+    w->has_items[w->depth - 1] = 1;
+    indent(w, w->depth);
+    put_char(w, '"');
+    put_escaped(w, key, strlen(key));
+    put(w, "\":", 2);
+}
+
+void json_writer_string_len(JsonWriter *w, const char *s, size_t len) {
+    before_value(w);
+    put_char(w, '"');
+    put_escaped(w, s, len);
+    put_char(w, '"');
+}
+
+void json_writer_string(JsonWriter *w, const char *s) {
+    json_writer_string_len(w, s, strlen(s));
+}
+
+void json_writer_int(JsonWriter *w, int64_t value) {
+    char digits[24];
+    char *p = digits + sizeof(digits);
+    uint64_t v = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    do {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    if (value < 0) *--p = '-';
+    before_value(w);
+    put(w, p, (size_t)(digits + sizeof(digits) - p));
+}
+
+// json-c's default double format: %.17g, with ".0" added to integral values
+void json_writer_double(JsonWriter *w, double value) {
+    char buf[128];
+    int size;
+    if (isnan(value)) {
+        size = snprintf(buf, sizeof(buf), "NaN");
+    } else if (isinf(value)) {
+        size = snprintf(buf, sizeof(buf), value > 0 ? "Infinity" : "-Infinity");
+    } else {
+        size = snprintf(buf, sizeof(buf), "%.17g", value);
+        char *point = strchr(buf, ',');
+        if (point) {
+            *point = '.';
+        } else {
+            point = strchr(buf, '.');
+        }
+        int numeric = (buf[0] >= '0' && buf[0] <= '9') || (size > 1 && buf[0] == '-' && buf[1] >= '0' && buf[1] <= '9');
+        if (size < (int)sizeof(buf) - 2 && numeric && !point && !strchr(buf, 'e')) {
+            memcpy(buf + size, ".0", 3);
+            size += 2;
+        }
+    }
+    before_value(w);
+    if (size > 0) put(w, buf, (size_t)size);
+}
+
+void json_writer_bool(JsonWriter *w, int value) {
+    before_value(w);
+    if (value) {
+        put(w, "true", 4);
+    } else {
+        put(w, "false", 5);
+    }
+}
+
+void json_writer_null(JsonWriter *w) {
+    before_value(w);
+    put(w, "null", 4);
+}
+
+void json_writer_json(JsonWriter *w, struct json_object *value) {
+    int pretty = (w->flags & JSON_WRITER_PRETTY) != 0;
+    const char *text = json_object_to_json_string_ext(value, pretty ? JSON_C_TO_STRING_PRETTY : JSON_C_TO_STRING_PLAIN);
+    before_value(w);
+    if (!text) {
+        put(w, "null", 4);
+        return;
+    }
+    // json-c lays the value out from level 0; strings cannot hold a raw newline,
+    // so shifting every line right by the current level is exact
+    const char *line = text;
+    for (const char *nl = strchr(line, '\n'); nl; nl = strchr(line, '\n')) {
+        put(w, line, (size_t)(nl - line + 1));
+        indent(w, w->depth);
+        line = nl + 1;
+    }
+    put(w, line, strlen(line));
+}
+
+void json_writer_raw(JsonWriter *w, const char *s, size_t len) {
+    put(w, s, len);
+}
+
+int json_writer_finish(JsonWriter *w, char **out) {
+    if (out) *out = NULL;
+    json_writer_flush(w);
+    if (w->fp && fflush(w->fp) != 0) w->error = 1;
+    int rc = w->error || w->depth != 0 ? -1 : 0;
+    if (!w->fp && out && rc == 0) {
+        put_char(w, '\0');
+        if (!w->error) {
+            *out = w->buf;
+            w->buf = NULL;
+        } else {
+            rc = -1;
+        }
+    }
+    free(w->buf);
+    w->buf = NULL;
+    return rc;
+}
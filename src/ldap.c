@@ -1,114 +1,62 @@
 #include "aclguard_ldap.h"
+#include "arena.h"
+#include "classifier.h"
+#include "delta_state.h"
+#include "dn.h"
+#include "effective_rights.h"
 #include "error_handler.h"
+#include "group_graph.h"
+#include "group_rights.h"
+#include "group_table.h"
+#include "risk_engine.h"
+#include "sd_cache.h"
+#include "security_descriptor.h"
+#include "sid_resolver.h"
+#include "thread_pool.h"
+#include "wellknown.h"
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <pthread.h>
 #include <ldap.h>
 
-// Function to analyze user permissions based on group memberships
-void analyze_user_permissions(ADUser *user) {
-    // Initialize all permissions to 0
-    user->perms.isAdmin = 0;
-    user->perms.canResetPasswords = 0;
-    user->perms.canModifyACLs = 0;
-    user->perms.canDelegateAuth = 0;
-    user->perms.hasServiceAcct = 0;
-    user->perms.isPrivileged = 0;
-    user->perms.canReadSecrets = 0;
-    user->perms.canWriteSecrets = 0;
-    user->risk = 0;
-    
-    if (!user->memberOf) return;
-    
-    char *groups = strdup(user->memberOf);
-    char *group = strtok(groups, ",");
-    
-    while (group != NULL) {
-        // Remove leading/trailing whitespace
-        while (*group == ' ' || *group == '\t') group++;
-        char *end = group + strlen(group) - 1;
-        while (end > group && (*end == ' ' || *end == '\t')) end--;
-        *(end + 1) = '\0';
-        
-        // Check for high-risk group memberships
-        if (strstr(group, "Domain Admins") || 
-            strstr(group, "Enterprise Admins") ||
-            strstr(group, "Schema Admins") ||
-            strstr(group, "Administrators") ||
-            strstr(group, "Group Policy Creator Owners") ||
-            strstr(group, "Domain Controllers") ||
-            strstr(group, "Administrator")) {
-            user->perms.isAdmin = 1;
-            user->perms.isPrivileged = 1;
-            user->risk += 40; // High risk for admin groups
-        }
-        
-        if (strstr(group, "Account Operators") ||
-            strstr(group, "Help Desk") ||
-            strstr(group, "Password Reset")) {
-            user->perms.canResetPasswords = 1;
-            user->perms.isPrivileged = 1;
-            user->risk += 25; // Medium-high risk for password reset
-        }
-        
-        if (strstr(group, "Backup Operators") ||
-            strstr(group, "Server Operators") ||
-            strstr(group, "Print Operators") ||
-            strstr(group, "Remote Desktop Users") ||
-            strstr(group, "Power Users")) {
-            user->perms.canModifyACLs = 1;
-            user->perms.isPrivileged = 1;
-            user->risk += 20; // Medium risk for ACL modification
-        }
-        
-        if (strstr(group, "Service") ||
-            strstr(group, "SQL") ||
-            strstr(group, "IIS") ||
-            strstr(group, "Exchange")) {
-            user->perms.hasServiceAcct = 1;
-            user->risk += 15; // Medium risk for service accounts
-        }
-        
-        if (strstr(group, "Delegation") ||
-            strstr(group, "Trusted")) {
-            user->perms.canDelegateAuth = 1;
-            user->risk += 30; // High risk for delegation
-        }
-        
-        if (strstr(group, "Read") && strstr(group, "Secret")) {
-            user->perms.canReadSecrets = 1;
-            user->risk += 20; // Medium risk for reading secrets
-        }
-        
-        if (strstr(group, "Write") && strstr(group, "Secret")) {
-            user->perms.canWriteSecrets = 1;
-            user->risk += 35; // High risk for writing secrets
-        }
-        
-        group = strtok(NULL, ",");
-    }
-    
-    free(groups);
-    
-    // Cap risk score at 100
-    if (user->risk > 100) user->risk = 100;
-}
-
-ADUser *fetch_real_users(const Config *config, int *count_out) {
-    LDAP *ld = NULL;
-    LDAPMessage *result = NULL, *entry = NULL;
-    char *attrs[] = {"cn", "mail", "sAMAccountName", "uid", "memberOf", NULL};
-    int rc;
+// Growable user array filled page by page while a scan is running
+typedef struct {
+    ADUser *items;
+    int count;
+    int cap;
+} UserVec;
 
-    *count_out = 0;
+static ADUser *user_vec_next(UserVec *vec) {
+    if (vec->count + 1 > vec->cap) {
+        int new_cap = vec->cap == 0 ? 64 : vec->cap * 2;
+        ADUser *next = realloc(vec->items, (size_t)new_cap * sizeof(ADUser));
+        if (!next) return NULL;
+        vec->items = next;
+        vec->cap = new_cap;
+    }
+    ADUser *user = &vec->items[vec->count++];
+    memset(user, 0, sizeof(*user));
+    return user;
+}
+
+static LDAP *connect_and_bind(const Config *config) {
+    LDAP *ld = NULL;
 
     // 1. Initialize connection
-    rc = ldap_initialize(&ld, config->ldap_uri);
+    int rc = ldap_initialize(&ld, config->ldap_uri);
     if (rc != LDAP_SUCCESS) {
         log_error("LDAP initialization failed: %s", ldap_err2string(rc));
         return NULL;
     }
 
+    // Controls (paged results) are only sent on LDAPv3 sessions
+    int version = LDAP_VERSION3;
+    ldap_set_option(ld, LDAP_OPT_PROTOCOL_VERSION, &version);
+
     // 2. Prepare credentials
     struct berval cred;
     cred.bv_val = config->bind_pw;
@@ -128,132 +76,1358 @@ ADUser *fetch_real_users(const Config *config, int *count_out) {
         return NULL;
     }
 
+    return ld;
+}
+
+// Hex-encode a binary objectGUID value into the arena
+static char *guid_to_hex(Arena *arena, const struct berval *val) {
+    static const char digits[] = "0123456789abcdef";
+    char *hex = arena_alloc(arena, val->bv_len * 2 + 1);
+    if (!hex) return NULL;
+    for (ber_len_t i = 0; i < val->bv_len; i++) {
+        unsigned char byte = (unsigned char)val->bv_val[i];
+        hex[i * 2] = digits[byte >> 4];
+        hex[i * 2 + 1] = digits[byte & 0x0f];
+    }
+    hex[val->bv_len * 2] = '\0';
+    return hex;
+}
+
+// Copy the attributes of one search entry into user (strings and group IDs are
+// allocated from the scan arena, ACE grants come from the descriptor cache)
+// and, unless deferred, score it. Returns LDAP_NO_MEMORY if the descriptor
+// could not be evaluated or the user scored for lack of memory, LDAP_SUCCESS
+// otherwise.
+static int decode_user_entry(LDAP *ld, LDAPMessage *entry, ADUser *user, Arena *arena,
+                             ScanStats *stats, int score) {
+    int rc = LDAP_SUCCESS;
+    char *dn = ldap_get_dn(ld, entry);
+    if (dn) {
+        user->dn = arena_strdup(arena, dn);
+        ldap_memfree(dn);
+    }
+
+    BerElement *ber = NULL;
+    char *attr;
+    struct berval **vals;
+
+    for (attr = ldap_first_attribute(ld, entry, &ber);
+         attr != NULL;
+         attr = ldap_next_attribute(ld, entry, ber)) {
+
+        vals = ldap_get_values_len(ld, entry, attr);
+        if (vals) {
+            if (strcmp(attr, "cn") == 0) {
+                user->cn = arena_strndup(arena, vals[0]->bv_val, vals[0]->bv_len);
+            } else if (strcmp(attr, "mail") == 0) {
+                user->mail = arena_strndup(arena, vals[0]->bv_val, vals[0]->bv_len);
+            } else if (strcmp(attr, "sAMAccountName") == 0 || strcmp(attr, "uid") == 0) {
+                // Use sAMAccountName for AD or uid for OpenLDAP
+                if (!user->username) {  // Only set if not already set
+                    user->username = arena_strndup(arena, vals[0]->bv_val, vals[0]->bv_len);
+                }
+            } else if (strcmp(attr, "objectGUID") == 0) {
+                user->guid = guid_to_hex(arena, vals[0]);
+            } else if (strcmp(attr, "objectSid") == 0) {
+                char sid[SID_STRING_MAX];
+                int len = sid_to_string((const uint8_t *)vals[0]->bv_val, vals[0]->bv_len, sid, sizeof(sid));
+                if (len > 0) user->sid = arena_strndup(arena, sid, (size_t)len);
+            } else if (strcmp(attr, "nTSecurityDescriptor") == 0) {
+                // Identical descriptors are parsed once and share one grant array;
+                // a malformed one grants nothing and is counted by the cache
+                int grants = sd_cache_intern(vals[0]->bv_val, vals[0]->bv_len, &user->acl_grants,
+                                             &user->acl_protected);
+                if (grants == SD_NO_MEMORY) rc = LDAP_NO_MEMORY;
+                user->acl_grant_count = grants > 0 ? grants : 0;
+                if (stats) stats->security_descriptors++;
+            } else if (strcmp(attr, "memberOf") == 0) {
+                // Intern every membership once; the user keeps only compact IDs
+                int n = ldap_count_values_len(vals);
+                int *ids = arena_alloc(arena, (size_t)(user->group_count + n) * sizeof(int));
+                if (ids) {
+                    if (user->group_count > 0) {
+                        memcpy(ids, user->group_ids, (size_t)user->group_count * sizeof(int));
+                    }
+                    user->group_ids = ids;
+                    for (int v = 0; v < n; v++) {
+                        int id = group_table_intern(vals[v]->bv_val, vals[v]->bv_len);
+                        if (id >= 0) user->group_ids[user->group_count++] = id;
+                    }
+                }
+            }
+            ldap_value_free_len(vals);
+        }
+        ldap_memfree(attr);
+    }
+
+    if (ber) {
+        ber_free(ber, 0);
+    }
+
+    // Score the user from its group memberships
+    if (score && risk_score_user(user, risk_model_active()) != 0) {
+        rc = LDAP_NO_MEMORY;
+    }
+    return rc;
+}
+
+// Seconds elapsed on the monotonic clock since start
+static double seconds_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double seconds = (double)(now.tv_sec - start->tv_sec);
+    seconds += (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+    return seconds < 0.0 ? 0.0 : seconds;
+}
+
+// State shared by every request issued during one scan
+typedef struct {
+    UserVec users;
+    Arena arena;               // Owns the strings and group IDs of users
+    ScanStats *stats;          // Optional timing/volume counters
+    struct timespec start;     // Scan start, including connect and bind
+    int seen_first;            // Set once the first entry has been decoded
+    int defer_scoring;         // Score after the download on the thread pool
+    int scored;                // Every user in users already carries its score
+} ScanContext;
+
+// Issue one asynchronous search request and classify each entry as soon as
+// ldap_result() hands it over, so decoding and classification overlap with the
+// server still streaming the rest of the result. Returns the LDAP result code of
+// the request; response controls are handed back to the caller to free.
+static int run_search_request(LDAP *ld,
+                              ScanContext *scan,
+                              const char *base,
+                              int scope,
+                              const char *filter,
+                              char **attrs,
+                              LDAPControl **server_ctrls,
+                              LDAPControl ***resp_ctrls_out) {
+    int msgid = 0;
+    int rc = ldap_search_ext(ld,
+                             base,
+                             scope,
+                             filter,
+                             attrs,
+                             0,
+                             server_ctrls,
+                             NULL,
+                             NULL,
+                             LDAP_NO_LIMIT,
+                             &msgid);
+    if (rc != LDAP_SUCCESS) {
+        return rc;
+    }
+
+    for (;;) {
+        LDAPMessage *msg = NULL;
+        int type = ldap_result(ld, msgid, LDAP_MSG_ONE, NULL, &msg);
+        if (type <= 0) {
+            int err = LDAP_SERVER_DOWN;
+            ldap_get_option(ld, LDAP_OPT_RESULT_CODE, &err);
+            if (msg) ldap_msgfree(msg);
+            return err != LDAP_SUCCESS ? err : LDAP_OTHER;
+        }
+
+        if (type == LDAP_RES_SEARCH_ENTRY) {
+            ADUser *user = user_vec_next(&scan->users);
+            if (!user) {
+                log_error("Memory allocation failed for ADUser list.");
+                ldap_msgfree(msg);
+                ldap_abandon_ext(ld, msgid, NULL, NULL);
+                return LDAP_NO_MEMORY;
+            }
+            rc = decode_user_entry(ld, ldap_first_entry(ld, msg), user, &scan->arena, scan->stats,
+                                   !scan->defer_scoring);
+            ldap_msgfree(msg);
+            if (rc != LDAP_SUCCESS) {
+                log_error("Memory allocation failed while decoding a directory entry.");
+                ldap_abandon_ext(ld, msgid, NULL, NULL);
+                return rc;
+            }
+
+            if (!scan->seen_first) {
+                scan->seen_first = 1;
+                if (scan->stats) {
+                    scan->stats->first_result_seconds = seconds_since(&scan->start);
+                }
+            }
+            continue;
+        }
+
+        if (type == LDAP_RES_SEARCH_RESULT) {
+            int err = LDAP_SUCCESS;
+            rc = ldap_parse_result(ld, msg, &err, NULL, NULL, NULL, resp_ctrls_out, 1);
+            return rc != LDAP_SUCCESS ? rc : err;
+        }
+
+        // Referrals and intermediate responses carry no user data
+        ldap_msgfree(msg);
+    }
+}
+
+// Non-critical SD_FLAGS control asking for the owner and DACL only: the SACL
+// is large, and reading it needs privileges a scanning account lacks
+static LDAPControl *create_sd_flags_control(void) {
+    BerElement *ber = ber_alloc_t(LBER_USE_DER);
+    if (!ber) return NULL;
+
+    LDAPControl *ctrl = NULL;
+    struct berval value;
+    if (ber_printf(ber, "{i}", SD_OWNER_SECURITY_INFORMATION | SD_DACL_SECURITY_INFORMATION) < 0 ||
+        ber_flatten2(ber, &value, 0) != 0 ||
+        ldap_control_create(SD_FLAGS_CONTROL_OID, 0, &value, 1, &ctrl) != LDAP_SUCCESS) {
+        ctrl = NULL;
+    }
+    ber_free(ber, 1);
+    return ctrl;
+}
+
+// Run one logical search. With paging enabled (RFC 2696) each page is decoded,
+// classified and released before the next one is requested, so the LDAP message
+// buffers never hold more than page_size entries regardless of directory size.
+static int search_users(LDAP *ld,
+                        const Config *config,
+                        ScanContext *scan,
+                        const char *base,
+                        int scope,
+                        const char *filter,
+                        char **attrs) {
+    struct berval cookie = {0, NULL};
+    int rc;
+
+    LDAPControl *sd_ctrl = create_sd_flags_control();
+    if (!sd_ctrl) {
+        log_error("LDAP SD_FLAGS control creation failed; security descriptors may be omitted.");
+    }
+
+    do {
+        LDAPControl *page_ctrl = NULL;
+        if (config->page_size > 0) {
+            rc = ldap_create_page_control(ld, config->page_size, &cookie, 0, &page_ctrl);
+            if (rc != LDAP_SUCCESS) {
+                log_error("LDAP page control creation failed: %s", ldap_err2string(rc));
+                break;
+            }
+        }
+        if (cookie.bv_val) {
+            ber_memfree(cookie.bv_val);
+            cookie.bv_val = NULL;
+            cookie.bv_len = 0;
+        }
+
+        LDAPControl *server_ctrls[3] = {NULL, NULL, NULL};
+        int ctrl_count = 0;
+        if (page_ctrl) server_ctrls[ctrl_count++] = page_ctrl;
+        if (sd_ctrl) server_ctrls[ctrl_count++] = sd_ctrl;
+        LDAPControl **resp_ctrls = NULL;
+        rc = run_search_request(ld, scan, base, scope, filter, attrs,
+                                ctrl_count > 0 ? server_ctrls : NULL, &resp_ctrls);
+        if (page_ctrl) {
+            ldap_control_free(page_ctrl);
+        }
+
+        if (rc == LDAP_SUCCESS) {
+            if (scan->stats) scan->stats->pages++;
+
+            // An absent or empty cookie ends the scan
+            LDAPControl *page_resp = ldap_control_find(LDAP_CONTROL_PAGEDRESULTS, resp_ctrls, NULL);
+            if (page_resp) {
+                ber_int_t estimate = 0;
+                rc = ldap_parse_pageresponse_control(ld, page_resp, &estimate, &cookie);
+            }
+        }
+        if (resp_ctrls) {
+            ldap_controls_free(resp_ctrls);
+        }
+    } while (rc == LDAP_SUCCESS && cookie.bv_val != NULL && cookie.bv_len > 0);
+
+    if (cookie.bv_val) {
+        ber_memfree(cookie.bv_val);
+    }
+    if (sd_ctrl) {
+        ldap_control_free(sd_ctrl);
+    }
+    return rc;
+}
+
+static void discard_users(UserVec *users) {
+    free(users->items);
+    users->items = NULL;
+    users->count = 0;
+    users->cap = 0;
+}
+
+// Drop the users collected so far together with everything they reference
+static void discard_scan(ScanContext *scan) {
+    discard_users(&scan->users);
+    arena_destroy(&scan->arena);
+}
+
+// Connect, then run the primary search with the historical fallbacks
+static int single_scan(const Config *config, ScanContext *scan, char **attrs) {
+    LDAP *ld = connect_and_bind(config);
+    if (!ld) {
+        return LDAP_SERVER_DOWN;
+    }
+
     // 4. Perform search - try multiple approaches for compatibility
     // First try: Search for users with person objectClass (OpenLDAP)
-    rc = ldap_search_ext_s(ld,
-                           config->base_dn,
-                           LDAP_SCOPE_SUBTREE,
-                           "(objectClass=person)",
-                           attrs,
-                           0,
-                           NULL,
-                           NULL,
-                           NULL,
-                           LDAP_NO_LIMIT,
-                           &result);
-    
+    int rc = search_users(ld, config, scan, config->base_dn, LDAP_SCOPE_SUBTREE,
+                          "(objectClass=person)", attrs);
+
     if (rc != LDAP_SUCCESS) {
         // Fallback 1: Try AD Users container
+        discard_scan(scan);
         char *users_dn = "CN=Users,DC=example,DC=local";
-        rc = ldap_search_ext_s(ld,
-                               users_dn,
-                               LDAP_SCOPE_SUBTREE,
-                               "(objectClass=user)",
-                               attrs,
+        rc = search_users(ld, config, scan, users_dn, LDAP_SCOPE_SUBTREE,
+                          "(objectClass=user)", attrs);
+
+        if (rc != LDAP_SUCCESS) {
+            // Fallback 2: Try base DN with BASE scope
+            discard_scan(scan);
+            rc = search_users(ld, config, scan, config->base_dn, LDAP_SCOPE_BASE,
+                              "(objectClass=*)", attrs);
+
+            if (rc != LDAP_SUCCESS) {
+                log_error("LDAP search failed: %s", ldap_err2string(rc));
+                discard_scan(scan);
+            }
+        }
+    }
+
+    ldap_unbind_ext_s(ld, NULL, NULL);
+    return rc;
+}
+
+// One independently searchable slice of the directory tree
+typedef struct {
+    char *base;
+    int scope;
+} ScanPartition;
+
+// Work queue shared by the partition workers
+typedef struct {
+    const Config *config;
+    char **attrs;
+    ScanPartition *parts;
+    int part_count;
+    int next_part;             // Next unclaimed partition, guarded by lock
+    int failed;                // Set by the first worker that hits an error
+    pthread_mutex_t lock;
+} PartitionQueue;
+
+typedef struct {
+    pthread_t thread;
+    PartitionQueue *queue;
+    ScanContext scan;
+    ScanStats stats;
+    int rc;
+} PartitionWorker;
+
+static void free_partitions(ScanPartition *parts, int count) {
+    for (int i = 0; i < count; i++) {
+        free(parts[i].base);
+    }
+    free(parts);
+}
+
+// Split the base DN into the base object itself plus one subtree per direct
+// child (OUs and containers). Together the partitions cover the same entries as a
+// single subtree search, without overlap.
+static int discover_partitions(LDAP *ld, const char *base_dn, ScanPartition **parts_out, int *count_out) {
+    char *no_attrs[] = {LDAP_NO_ATTRS, NULL};
+    LDAPMessage *result = NULL;
+
+    *parts_out = NULL;
+    *count_out = 0;
+
+    int rc = ldap_search_ext_s(ld,
+                               base_dn,
+                               LDAP_SCOPE_ONELEVEL,
+                               "(objectClass=*)",
+                               no_attrs,
                                0,
                                NULL,
                                NULL,
                                NULL,
                                LDAP_NO_LIMIT,
                                &result);
-        
+    if (rc != LDAP_SUCCESS) {
+        if (result) ldap_msgfree(result);
+        return rc;
+    }
+
+    int children = ldap_count_entries(ld, result);
+    ScanPartition *parts = calloc((size_t)(children > 0 ? children : 0) + 1, sizeof(ScanPartition));
+    if (!parts) {
+        ldap_msgfree(result);
+        return LDAP_NO_MEMORY;
+    }
+
+    int count = 0;
+    parts[count].base = strdup(base_dn);
+    parts[count].scope = LDAP_SCOPE_BASE;
+    count++;
+
+    for (LDAPMessage *entry = ldap_first_entry(ld, result);
+         entry != NULL && count < children + 1;
+         entry = ldap_next_entry(ld, entry)) {
+        char *dn = ldap_get_dn(ld, entry);
+        if (!dn) continue;
+        parts[count].base = strdup(dn);
+        parts[count].scope = LDAP_SCOPE_SUBTREE;
+        count++;
+        ldap_memfree(dn);
+    }
+    ldap_msgfree(result);
+
+    *parts_out = parts;
+    *count_out = count;
+    return LDAP_SUCCESS;
+}
+
+static void *partition_worker_main(void *arg) {
+    PartitionWorker *worker = arg;
+    PartitionQueue *queue = worker->queue;
+
+    LDAP *ld = connect_and_bind(queue->config);
+    if (!ld) {
+        worker->rc = LDAP_SERVER_DOWN;
+        pthread_mutex_lock(&queue->lock);
+        queue->failed = 1;
+        pthread_mutex_unlock(&queue->lock);
+        return NULL;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        int index = queue->failed ? queue->part_count : queue->next_part++;
+        pthread_mutex_unlock(&queue->lock);
+        if (index >= queue->part_count) break;
+
+        ScanPartition *part = &queue->parts[index];
+        int rc = search_users(ld, queue->config, &worker->scan, part->base, part->scope,
+                              "(objectClass=person)", queue->attrs);
+        // A base-scope probe of a non-person base DN is expected to come back empty
+        if (rc == LDAP_NO_SUCH_OBJECT && part->scope == LDAP_SCOPE_BASE) {
+            rc = LDAP_SUCCESS;
+        }
         if (rc != LDAP_SUCCESS) {
-            // Fallback 2: Try base DN with BASE scope
-            rc = ldap_search_ext_s(ld,
-                                   config->base_dn,
-                                   LDAP_SCOPE_BASE,
-                                   "(objectClass=*)",
-                                   attrs,
-                                   0,
-                                   NULL,
-                                   NULL,
-                                   NULL,
-                                   LDAP_NO_LIMIT,
-                                   &result);
-            
-            if (rc != LDAP_SUCCESS) {
-                log_error("LDAP search failed: %s", ldap_err2string(rc));
-                ldap_unbind_ext_s(ld, NULL, NULL);
-                return NULL;
+            log_error("LDAP partition search failed for %s: %s", part->base, ldap_err2string(rc));
+            worker->rc = rc;
+            pthread_mutex_lock(&queue->lock);
+            queue->failed = 1;
+            pthread_mutex_unlock(&queue->lock);
+            break;
+        }
+    }
+
+    ldap_unbind_ext_s(ld, NULL, NULL);
+    return NULL;
+}
+
+// Scan each partition on its own connection and worker thread, then merge the
+// per-worker results into scan->users
+static int partitioned_scan(const Config *config, ScanContext *scan, char **attrs) {
+    LDAP *ld = connect_and_bind(config);
+    if (!ld) {
+        return LDAP_SERVER_DOWN;
+    }
+
+    ScanPartition *parts = NULL;
+    int part_count = 0;
+    int rc = discover_partitions(ld, config->base_dn, &parts, &part_count);
+    ldap_unbind_ext_s(ld, NULL, NULL);
+    if (rc != LDAP_SUCCESS) {
+        return rc;
+    }
+
+    int worker_count = config->scan_workers < part_count ? config->scan_workers : part_count;
+    PartitionWorker *workers = calloc((size_t)worker_count, sizeof(PartitionWorker));
+    if (!workers) {
+        free_partitions(parts, part_count);
+        return LDAP_NO_MEMORY;
+    }
+
+    PartitionQueue queue;
+    memset(&queue, 0, sizeof(queue));
+    queue.config = config;
+    queue.attrs = attrs;
+    queue.parts = parts;
+    queue.part_count = part_count;
+    pthread_mutex_init(&queue.lock, NULL);
+
+    int started = 0;
+    for (int i = 0; i < worker_count; i++) {
+        workers[i].queue = &queue;
+        workers[i].scan.stats = &workers[i].stats;
+        arena_init(&workers[i].scan.arena);
+        workers[i].scan.defer_scoring = scan->defer_scoring;
+        workers[i].scan.start = scan->start;
+        if (pthread_create(&workers[i].thread, NULL, partition_worker_main, &workers[i]) != 0) {
+            log_error("Failed to start partition worker %d.", i);
+            pthread_mutex_lock(&queue.lock);
+            queue.failed = 1;
+            pthread_mutex_unlock(&queue.lock);
+            rc = LDAP_LOCAL_ERROR;
+            break;
+        }
+        started++;
+    }
+
+    int total = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        if (workers[i].rc != LDAP_SUCCESS && rc == LDAP_SUCCESS) {
+            rc = workers[i].rc;
+        }
+        total += workers[i].scan.users.count;
+    }
+
+    if (rc == LDAP_SUCCESS && total > 0) {
+        scan->users.items = malloc((size_t)total * sizeof(ADUser));
+        if (!scan->users.items) {
+            rc = LDAP_NO_MEMORY;
+        } else {
+            scan->users.cap = total;
+        }
+    }
+
+    for (int i = 0; i < started; i++) {
+        PartitionWorker *worker = &workers[i];
+        if (rc == LDAP_SUCCESS && worker->scan.users.count > 0) {
+            memcpy(scan->users.items + scan->users.count,
+                   worker->scan.users.items,
+                   (size_t)worker->scan.users.count * sizeof(ADUser));
+            scan->users.count += worker->scan.users.count;
+        }
+        if (rc == LDAP_SUCCESS) {
+            arena_merge(&scan->arena, &worker->scan.arena);
+        }
+        if (rc == LDAP_SUCCESS && scan->stats) {
+            scan->stats->pages += worker->stats.pages;
+            scan->stats->security_descriptors += worker->stats.security_descriptors;
+            if (worker->scan.seen_first &&
+                (!scan->seen_first || worker->stats.first_result_seconds < scan->stats->first_result_seconds)) {
+                scan->stats->first_result_seconds = worker->stats.first_result_seconds;
             }
         }
+        if (worker->scan.seen_first) scan->seen_first = 1;
+        discard_scan(&worker->scan);
     }
 
-    // 5. Count results
-    int num_entries = ldap_count_entries(ld, result);
-    if (num_entries <= 0) {
-        ldap_msgfree(result);
-        ldap_unbind_ext_s(ld, NULL, NULL);
-        return NULL;
+    pthread_mutex_destroy(&queue.lock);
+    free(workers);
+    free_partitions(parts, part_count);
+    return rc;
+}
+
+#define LDAP_SERVER_SHOW_DELETED_OID "1.2.840.113556.1.4.417"
+
+// Read highestCommittedUSN, the default naming context (used to find
+// tombstones) and dsServiceName from the root DSE. USNs are local to one domain
+// controller, so dsServiceName identifies the server they count on. Returns -1
+// when the server publishes no USN, which is the case for non-AD directories.
+static long long read_root_dse(LDAP *ld, char **naming_context_out, char **server_out) {
+    char *attrs[] = {"highestCommittedUSN", "defaultNamingContext", "dsServiceName", NULL};
+    LDAPMessage *result = NULL;
+    long long usn = -1;
+
+    *naming_context_out = NULL;
+    *server_out = NULL;
+    int rc = ldap_search_ext_s(ld, "", LDAP_SCOPE_BASE, "(objectClass=*)", attrs, 0,
+                               NULL, NULL, NULL, LDAP_NO_LIMIT, &result);
+    if (rc != LDAP_SUCCESS) {
+        if (result) ldap_msgfree(result);
+        return -1;
+    }
+
+    LDAPMessage *entry = ldap_first_entry(ld, result);
+    if (entry) {
+        struct berval **vals = ldap_get_values_len(ld, entry, "highestCommittedUSN");
+        if (vals) {
+            char *text = strndup(vals[0]->bv_val, vals[0]->bv_len);
+            if (text) {
+                usn = strtoll(text, NULL, 10);
+                free(text);
+            }
+            ldap_value_free_len(vals);
+        }
+        vals = ldap_get_values_len(ld, entry, "defaultNamingContext");
+        if (vals) {
+            *naming_context_out = strndup(vals[0]->bv_val, vals[0]->bv_len);
+            ldap_value_free_len(vals);
+        }
+        vals = ldap_get_values_len(ld, entry, "dsServiceName");
+        if (vals) {
+            *server_out = strndup(vals[0]->bv_val, vals[0]->bv_len);
+            ldap_value_free_len(vals);
+        }
     }
 
-    ADUser *users = calloc(num_entries, sizeof(ADUser));
-    if (!users) {
-        log_error("Memory allocation failed for ADUser list.");
+    ldap_msgfree(result);
+    return usn;
+}
+
+// Collect objectGUIDs of objects deleted since the high-water mark. Tombstones
+// need the show-deleted control; directories that refuse it simply report none.
+static int fetch_deleted_guids(LDAP *ld, const char *naming_context, long long since,
+                               Arena *arena, char ***guids_out, int *count_out) {
+    char *attrs[] = {"objectGUID", NULL};
+    char filter[96];
+    LDAPControl *show_deleted = NULL;
+    LDAPMessage *result = NULL;
+
+    *guids_out = NULL;
+    *count_out = 0;
+    if (!naming_context) return LDAP_SUCCESS;
+
+    snprintf(filter, sizeof(filter), "(&(isDeleted=TRUE)(uSNChanged>=%lld))", since);
+    int rc = ldap_control_create(LDAP_SERVER_SHOW_DELETED_OID, 0, NULL, 0, &show_deleted);
+    if (rc != LDAP_SUCCESS) return rc;
+
+    LDAPControl *server_ctrls[] = {show_deleted, NULL};
+    rc = ldap_search_ext_s(ld, naming_context, LDAP_SCOPE_SUBTREE, filter, attrs, 0,
+                           server_ctrls, NULL, NULL, LDAP_NO_LIMIT, &result);
+    ldap_control_free(show_deleted);
+    if (rc != LDAP_SUCCESS) {
+        if (result) ldap_msgfree(result);
+        return rc;
+    }
+
+    int entries = ldap_count_entries(ld, result);
+    char **guids = calloc((size_t)(entries > 0 ? entries : 1), sizeof(char *));
+    if (!guids) {
         ldap_msgfree(result);
-        ldap_unbind_ext_s(ld, NULL, NULL);
-        return NULL;
+        return LDAP_NO_MEMORY;
     }
 
-    // 6. Extract CN and mail attributes
-    int i = 0;
-    for (entry = ldap_first_entry(ld, result);
-         entry != NULL && i < num_entries;
-         entry = ldap_next_entry(ld, entry), i++) {
+    int count = 0;
+    for (LDAPMessage *entry = ldap_first_entry(ld, result);
+         entry != NULL && count < entries;
+         entry = ldap_next_entry(ld, entry)) {
+        struct berval **vals = ldap_get_values_len(ld, entry, "objectGUID");
+        if (vals) {
+            char *guid = guid_to_hex(arena, vals[0]);
+            if (guid) guids[count++] = guid;
+            ldap_value_free_len(vals);
+        }
+    }
+    ldap_msgfree(result);
 
-        char *dn = ldap_get_dn(ld, entry);
-        if (dn) {
-            users[i].dn = strdup(dn);
-            ldap_memfree(dn);
-        }
-
-        BerElement *ber = NULL;
-        char *attr;
-        struct berval **vals;
-
-        for (attr = ldap_first_attribute(ld, entry, &ber);
-             attr != NULL;
-             attr = ldap_next_attribute(ld, entry, ber)) {
-
-            vals = ldap_get_values_len(ld, entry, attr);
-            if (vals) {
-                if (strcmp(attr, "cn") == 0) {
-                    users[i].cn = strndup(vals[0]->bv_val, vals[0]->bv_len);
-                } else if (strcmp(attr, "mail") == 0) {
-                    users[i].mail = strndup(vals[0]->bv_val, vals[0]->bv_len);
-                } else if (strcmp(attr, "sAMAccountName") == 0 || strcmp(attr, "uid") == 0) {
-                    // Use sAMAccountName for AD or uid for OpenLDAP
-                    if (!users[i].username) {  // Only set if not already set
-                        users[i].username = strndup(vals[0]->bv_val, vals[0]->bv_len);
-                    }
-                } else if (strcmp(attr, "memberOf") == 0) {
-                    // Handle multiple group memberships
-                    if (!users[i].memberOf) {
-                        users[i].memberOf = strndup(vals[0]->bv_val, vals[0]->bv_len);
-                    } else {
-                        // Append additional groups
-                        char *temp = malloc(strlen(users[i].memberOf) + vals[0]->bv_len + 2);
-                        sprintf(temp, "%s,%s", users[i].memberOf, vals[0]->bv_val);
-                        free(users[i].memberOf);
-                        users[i].memberOf = temp;
-                    }
+    *guids_out = guids;
+    *count_out = count;
+    return LDAP_SUCCESS;
+}
+
+// Trustee SIDs per directory search when resolving ACE trustees
+#define SID_LOOKUP_BATCH 64
+
+static PrincipalKind principal_kind(LDAP *ld, LDAPMessage *entry) {
+    struct berval **classes = ldap_get_values_len(ld, entry, "objectClass");
+    PrincipalKind kind = PRINCIPAL_OTHER;
+    // computer derives from user, so it is checked first
+    for (int i = 0; classes && classes[i]; i++) {
+        const char *value = classes[i]->bv_val;
+        if (strcasecmp(value, "computer") == 0) {
+            kind = PRINCIPAL_COMPUTER;
+            break;
+        } else if (strcasecmp(value, "group") == 0) {
+            kind = PRINCIPAL_GROUP;
+        } else if (kind == PRINCIPAL_OTHER &&
+                   (strcasecmp(value, "user") == 0 || strcasecmp(value, "person") == 0)) {
+            kind = PRINCIPAL_USER;
+        }
+    }
+    if (classes) ldap_value_free_len(classes);
+    return kind;
+}
+
+// Append (objectSid=\xx\xx...) for one textual SID; returns the new length
+static size_t append_sid_filter(char *filter, size_t len, const char *sid) {
+    static const char digits[] = "0123456789abcdef";
+    uint8_t bin[68];
+    int bin_len = sid_from_string(sid, bin, sizeof(bin));
+    if (bin_len < 0) return len;
+
+    len += (size_t)sprintf(filter + len, "(objectSid=");
+    for (int i = 0; i < bin_len; i++) {
+        filter[len++] = '\\';
+        filter[len++] = digits[bin[i] >> 4];
+        filter[len++] = digits[bin[i] & 0x0f];
+    }
+    filter[len++] = ')';
+    filter[len] = '\0';
+    return len;
+}
+
+// Called for each entry of a paged_search(); returns an LDAP result code,
+// anything but LDAP_SUCCESS ends the search
+typedef int (*EntryVisitor)(LDAP *ld, LDAPMessage *entry, void *ctx);
+
+// Subtree search under the base DN, paged like the user search, that hands
+// every entry to visit. extra_ctrl (may be NULL) is sent with each page.
+static int paged_search(LDAP *ld, const Config *config, const char *filter, char **attrs,
+                        LDAPControl *extra_ctrl, EntryVisitor visit, void *ctx) {
+    struct berval cookie = {0, NULL};
+    int rc;
+
+    do {
+        LDAPControl *page_ctrl = NULL;
+        if (config->page_size > 0) {
+            rc = ldap_create_page_control(ld, config->page_size, &cookie, 0, &page_ctrl);
+            if (rc != LDAP_SUCCESS) break;
+        }
+        if (cookie.bv_val) {
+            ber_memfree(cookie.bv_val);
+            cookie.bv_val = NULL;
+            cookie.bv_len = 0;
+        }
+
+        LDAPControl *server_ctrls[3] = {NULL, NULL, NULL};
+        int ctrl_count = 0;
+        if (page_ctrl) server_ctrls[ctrl_count++] = page_ctrl;
+        if (extra_ctrl) server_ctrls[ctrl_count++] = extra_ctrl;
+        LDAPMessage *result = NULL;
+        rc = ldap_search_ext_s(ld, config->base_dn, LDAP_SCOPE_SUBTREE, filter, attrs, 0,
+                               ctrl_count > 0 ? server_ctrls : NULL, NULL, NULL, LDAP_NO_LIMIT, &result);
+        if (page_ctrl) {
+            ldap_control_free(page_ctrl);
+        }
+
+        for (LDAPMessage *entry = rc == LDAP_SUCCESS ? ldap_first_entry(ld, result) : NULL;
+             entry != NULL && rc == LDAP_SUCCESS;
+             entry = ldap_next_entry(ld, entry)) {
+            rc = visit(ld, entry, ctx);
+        }
+
+        if (rc == LDAP_SUCCESS) {
+            int err = LDAP_SUCCESS;
+            LDAPControl **resp_ctrls = NULL;
+            rc = ldap_parse_result(ld, result, &err, NULL, NULL, NULL, &resp_ctrls, 0);
+            if (rc == LDAP_SUCCESS) rc = err;
+
+            // An absent or empty cookie ends the search
+            LDAPControl *page_resp = ldap_control_find(LDAP_CONTROL_PAGEDRESULTS, resp_ctrls, NULL);
+            if (rc == LDAP_SUCCESS && page_resp) {
+                ber_int_t estimate = 0;
+                rc = ldap_parse_pageresponse_control(ld, page_resp, &estimate, &cookie);
+            }
+            if (resp_ctrls) {
+                ldap_controls_free(resp_ctrls);
+            }
+        }
+        if (result) {
+            ldap_msgfree(result);
+        }
+    } while (rc == LDAP_SUCCESS && cookie.bv_val != NULL && cookie.bv_len > 0);
+
+    if (cookie.bv_val) {
+        ber_memfree(cookie.bv_val);
+    }
+    return rc;
+}
+
+// The memberOf of a group names the groups it is nested in; its descriptor
+// names who controls it
+static int visit_group(LDAP *ld, LDAPMessage *entry, void *ctx) {
+    ScanContext *scan = ctx;
+    int rc = LDAP_SUCCESS;
+    char *dn = ldap_get_dn(ld, entry);
+    struct berval **vals = ldap_get_values_len(ld, entry, "memberOf");
+    struct berval **sd = ldap_get_values_len(ld, entry, "nTSecurityDescriptor");
+    AceGrant *grants = NULL;
+    int grant_count = 0;
+    int is_protected = 0;
+    if (sd) {
+        grant_count = sd_cache_intern(sd[0]->bv_val, sd[0]->bv_len, &grants, &is_protected);
+        if (grant_count == SD_NO_MEMORY) rc = LDAP_NO_MEMORY;
+        if (scan->stats) scan->stats->security_descriptors++;
+    }
+    // Groups neither nested, granting rights nor holding a scanned user stay
+    // out of the table
+    int member = -1;
+    if (dn && (vals || grant_count > 0)) {
+        member = group_table_intern(dn, strlen(dn));
+        if (member < 0) rc = LDAP_NO_MEMORY;
+    } else if (dn) {
+        member = group_table_find(dn, strlen(dn));
+    }
+    if (member >= 0 && (grant_count > 0 || is_protected) &&
+        group_rights_set(member, grants, grant_count > 0 ? grant_count : 0, is_protected) != 0) {
+        rc = LDAP_NO_MEMORY;
+    }
+    for (int v = 0; member >= 0 && vals && vals[v]; v++) {
+        int parent = group_table_intern(vals[v]->bv_val, vals[v]->bv_len);
+        if (parent < 0 || group_graph_add_edge(member, parent) != 0) rc = LDAP_NO_MEMORY;
+    }
+    if (sd) ldap_value_free_len(sd);
+    if (vals) ldap_value_free_len(vals);
+    if (dn) ldap_memfree(dn);
+    return rc;
+}
+
+// Read the nesting edges and the descriptor of every group once. Builds the
+// group graph and returns the number of nested groups, 0 if they could not be
+// read (only direct memberships count then and groups grant nothing), -1 on
+// allocation failure.
+static int load_groups(LDAP *ld, const Config *config, ScanContext *scan) {
+    char *attrs[] = {"memberOf", "nTSecurityDescriptor", NULL};
+
+    group_graph_reset();
+    group_rights_reset();
+    LDAPControl *sd_ctrl = create_sd_flags_control();
+    int rc = paged_search(ld, config, "(objectClass=group)", attrs, sd_ctrl, visit_group, scan);
+    if (sd_ctrl) {
+        ldap_control_free(sd_ctrl);
+    }
+    if (rc == LDAP_NO_MEMORY) {
+        group_graph_reset();
+        group_rights_reset();
+        return -1;
+    }
+    if (rc != LDAP_SUCCESS) {
+        log_error("Group lookup failed (%s); scoring direct memberships only, without group ACEs.",
+                  ldap_err2string(rc));
+        group_graph_reset();
+        group_rights_reset();
+        return 0;
+    }
+    return group_graph_build();
+}
+
+// Record one container with its class (the last objectClass value is the most
+// specific) and descriptor; containers without a readable descriptor are left out
+static int visit_container(LDAP *ld, LDAPMessage *entry, void *ctx) {
+    (void)ctx;
+    int rc = LDAP_SUCCESS;
+    char *dn = ldap_get_dn(ld, entry);
+    struct berval **classes = ldap_get_values_len(ld, entry, "objectClass");
+    struct berval **sd = ldap_get_values_len(ld, entry, "nTSecurityDescriptor");
+    int class_count = classes ? ldap_count_values_len(classes) : 0;
+    if (dn && sd) {
+        const char *object_class = class_count > 0 ? classes[class_count - 1]->bv_val : NULL;
+        if (effective_rights_add_container(dn, object_class, sd[0]->bv_val, sd[0]->bv_len) < 0) {
+            rc = LDAP_NO_MEMORY;
+        }
+    }
+    if (sd) ldap_value_free_len(sd);
+    if (classes) ldap_value_free_len(classes);
+    if (dn) ldap_memfree(dn);
+    return rc;
+}
+
+// Read the descriptor of every container (domain root, OUs, containers) and
+// compute effective rights down the tree, replacing the inherited grants of
+// the users inside recorded containers. Returns the number of containers
+// read, 0 if they could not be read (every object keeps the inherited ACEs
+// its own descriptor carries), -1 on allocation failure.
+static int load_containers(LDAP *ld, const Config *config, ScanContext *scan) {
+    char *attrs[] = {"objectClass", "nTSecurityDescriptor", NULL};
+
+    effective_rights_reset();
+    LDAPControl *sd_ctrl = create_sd_flags_control();
+    int rc = paged_search(ld, config,
+                          "(|(objectClass=domain)(objectClass=organizationalUnit)(objectClass=container))",
+                          attrs, sd_ctrl, visit_container, NULL);
+    if (sd_ctrl) {
+        ldap_control_free(sd_ctrl);
+    }
+    if (rc == LDAP_NO_MEMORY) {
+        effective_rights_reset();
+        return -1;
+    }
+    if (rc != LDAP_SUCCESS) {
+        log_error("Container descriptor lookup failed (%s); using the ACEs each object carries.",
+                  ldap_err2string(rc));
+        effective_rights_reset();
+        return 0;
+    }
+    if (effective_rights_build(scan->users.items, scan->users.count, &scan->arena) < 0) return -1;
+    return effective_rights_containers();
+}
+
+// Map every ACE trustee to a principal before the grants are credited: scanned
+// users are known from their objectSid, well-known SIDs from the built-in
+// table, and the rest are fetched SID_LOOKUP_BATCH at a time with one OR filter
+// per search. Without a connection (ld NULL) or when a lookup fails the
+// trustees stay unresolved.
+static int resolve_trustees(LDAP *ld, const Config *config, ADUser *users, int count) {
+    sid_resolver_reset();
+    if (sid_resolver_add_users(users, count) != 0) return -1;
+
+    const char **pending = NULL;
+    int pending_count = sid_resolver_pending(users, count, &pending);
+    if (pending_count <= 0) {
+        free(pending);
+        return pending_count < 0 ? -1 : 0;
+    }
+
+    if (!ld) {
+        log_error("No connection to resolve %d ACE trustees.", pending_count);
+        free(pending);
+        return 0;
+    }
+
+    // "(objectSid=" + 68 escaped bytes + ")" per SID, plus "(|" ")"
+    char *filter = malloc(SID_LOOKUP_BATCH * (12 + 68 * 3 + 1) + 4);
+    if (!filter) {
+        free(pending);
+        return -1;
+    }
+
+    char *attrs[] = {"objectSid", "objectClass", NULL};
+    for (int start = 0; start < pending_count; start += SID_LOOKUP_BATCH) {
+        int end = start + SID_LOOKUP_BATCH < pending_count ? start + SID_LOOKUP_BATCH : pending_count;
+        size_t len = (size_t)sprintf(filter, "(|");
+        for (int i = start; i < end; i++) {
+            len = append_sid_filter(filter, len, pending[i]);
+        }
+        strcpy(filter + len, ")");
+
+        LDAPMessage *result = NULL;
+        sid_resolver_record_batch();
+        int rc = ldap_search_ext_s(ld, config->base_dn, LDAP_SCOPE_SUBTREE, filter, attrs, 0,
+                                   NULL, NULL, NULL, LDAP_NO_LIMIT, &result);
+        if (rc != LDAP_SUCCESS) {
+            log_error("ACE trustee lookup failed: %s", ldap_err2string(rc));
+            if (result) ldap_msgfree(result);
+            continue;
+        }
+
+        for (LDAPMessage *entry = ldap_first_entry(ld, result); entry != NULL;
+             entry = ldap_next_entry(ld, entry)) {
+            struct berval **vals = ldap_get_values_len(ld, entry, "objectSid");
+            char sid[SID_STRING_MAX];
+            if (vals && sid_to_string((const uint8_t *)vals[0]->bv_val, vals[0]->bv_len, sid, sizeof(sid)) > 0) {
+                char *dn = ldap_get_dn(ld, entry);
+                if (dn) {
+                    sid_resolver_add(sid, dn, principal_kind(ld, entry), -1);
+                    ldap_memfree(dn);
                 }
-                ldap_value_free_len(vals);
             }
-            ldap_memfree(attr);
+            if (vals) ldap_value_free_len(vals);
         }
+        ldap_msgfree(result);
+    }
+
+    free(filter);
+    free(pending);
+    return 0;
+}
+
+// Groups changed since the high-water mark, filled by visit_changed_group
+typedef struct {
+    Arena *arena;          // Owns the canonical member DNs
+    unsigned char *flags;  // flags[id] is set for every changed group ID
+    int flag_count;
+    int group_count;
+    char **members;        // Canonical DNs of their current members
+    int member_count;
+    int member_cap;
+} ChangedGroups;
 
-        if (ber) {
-            ber_free(ber, 0);
+static int visit_changed_group(LDAP *ld, LDAPMessage *entry, void *ctx) {
+    ChangedGroups *groups = ctx;
+    char *dn = ldap_get_dn(ld, entry);
+    int id = dn ? group_table_intern(dn, strlen(dn)) : -1;
+    if (dn) ldap_memfree(dn);
+    if (id < 0) return dn ? LDAP_NO_MEMORY : LDAP_SUCCESS;
+
+    if (id >= groups->flag_count) {
+        int new_count = id + 64;
+        unsigned char *flags = realloc(groups->flags, (size_t)new_count);
+        if (!flags) return LDAP_NO_MEMORY;
+        memset(flags + groups->flag_count, 0, (size_t)(new_count - groups->flag_count));
+        groups->flags = flags;
+        groups->flag_count = new_count;
+    }
+    groups->flags[id] = 1;
+    groups->group_count++;
+
+    int rc = LDAP_SUCCESS;
+    struct berval **vals = ldap_get_values_len(ld, entry, "member");
+    for (int v = 0; vals && vals[v] && rc == LDAP_SUCCESS; v++) {
+        if (groups->member_count == groups->member_cap) {
+            int new_cap = groups->member_cap == 0 ? 64 : groups->member_cap * 2;
+            char **members = realloc(groups->members, (size_t)new_cap * sizeof(char *));
+            if (!members) {
+                rc = LDAP_NO_MEMORY;
+                break;
+            }
+            groups->members = members;
+            groups->member_cap = new_cap;
+        }
+        char *canonical = arena_alloc(groups->arena, 2 * vals[v]->bv_len + 1);
+        if (!canonical) {
+            rc = LDAP_NO_MEMORY;
+            break;
         }
-        
-        // Analyze user permissions based on group memberships
-        analyze_user_permissions(&users[i]);
+        dn_canonicalize(vals[v]->bv_val, vals[v]->bv_len, canonical);
+        groups->members[groups->member_count++] = canonical;
+    }
+    if (vals) ldap_value_free_len(vals);
+    return rc;
+}
+
+static int canonical_dn_cmp(const void *a, const void *b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+// A stored user is affected when it holds a changed group or is listed in the
+// member of one (a membership added since the last run)
+static int user_in_changed_group(const ADUser *user, const ChangedGroups *groups,
+                                 char **canonical, size_t *canonical_cap) {
+    for (int g = 0; g < user->group_count; g++) {
+        int id = user->group_ids[g];
+        if (id >= 0 && id < groups->flag_count && groups->flags[id]) return 1;
+    }
+    if (groups->member_count == 0 || !user->dn) return 0;
+
+    size_t len = strlen(user->dn);
+    if (2 * len + 1 > *canonical_cap) {
+        char *next = realloc(*canonical, 2 * len + 1);
+        if (!next) return -1;
+        *canonical = next;
+        *canonical_cap = 2 * len + 1;
+    }
+    dn_canonicalize(user->dn, len, *canonical);
+    return bsearch(canonical, groups->members, (size_t)groups->member_count, sizeof(char *),
+                   canonical_dn_cmp) != NULL;
+}
+
+// memberOf is a back-link: adding or removing a member bumps the uSNChanged of
+// the group, not of the user, so the changed-user search misses it. Read the
+// member of every group changed since the high-water mark and fetch the stored
+// users it affects again; they are appended to scan->users and replace their
+// stored entry on merge.
+static int refetch_changed_members(LDAP *ld, const Config *config, ScanContext *scan,
+                                   const DeltaState *state, long long since, char **attrs) {
+    char *group_attrs[] = {"member", NULL};
+    char filter[96];
+    ChangedGroups groups;
+
+    memset(&groups, 0, sizeof(groups));
+    groups.arena = &scan->arena;
+    snprintf(filter, sizeof(filter), "(&(objectClass=group)(uSNChanged>=%lld))", since);
+    int rc = paged_search(ld, config, filter, group_attrs, NULL, visit_changed_group, &groups);
+    if (rc == LDAP_SUCCESS && groups.member_count > 1) {
+        qsort(groups.members, (size_t)groups.member_count, sizeof(char *), canonical_dn_cmp);
+    }
+
+    char *canonical = NULL;
+    size_t canonical_cap = 0;
+    for (int i = 0; rc == LDAP_SUCCESS && groups.group_count > 0 && i < state->count; i++) {
+        const ADUser *user = &state->users[i];
+        int affected = user_in_changed_group(user, &groups, &canonical, &canonical_cap);
+        if (affected < 0) {
+            rc = LDAP_NO_MEMORY;
+        } else if (affected && user->dn) {
+            rc = search_users(ld, config, scan, user->dn, LDAP_SCOPE_BASE, "(objectClass=person)", attrs);
+            // A member deleted since the last run is dropped by the tombstone search
+            if (rc == LDAP_NO_SUCH_OBJECT) rc = LDAP_SUCCESS;
+        }
+    }
+
+    free(canonical);
+    free(groups.members);
+    free(groups.flags);
+    return rc;
+}
+
+// Stored state counts USNs on the server that produced it; a missing
+// dsServiceName on both sides is taken as the same server
+static int same_server(const char *stored, const char *current) {
+    if (!stored || !current) return stored == current;
+    return strcasecmp(stored, current) == 0;
+}
+
+// Incremental scan: read the current highestCommittedUSN, fetch only objects whose
+// uSNChanged is past the stored high-water mark and overlay them on the stored
+// result set. Without stored state, or when the state was recorded against
+// another domain controller, this is a full scan that seeds the state.
+// Any error is returned so the caller can fall back to a regular full scan.
+static int delta_scan(const Config *config, ScanContext *scan, char **attrs) {
+    char *state_path = delta_state_path(config);
+    if (!state_path) return LDAP_NO_MEMORY;
+
+    LDAP *ld = connect_and_bind(config);
+    if (!ld) {
+        free(state_path);
+        return LDAP_SERVER_DOWN;
+    }
+
+    char *naming_context = NULL;
+    char *server = NULL;
+    long long usn_now = read_root_dse(ld, &naming_context, &server);
+    if (usn_now < 0) {
+        log_error("Directory does not publish highestCommittedUSN; delta scan unavailable.");
+        ldap_unbind_ext_s(ld, NULL, NULL);
+        free(naming_context);
+        free(server);
+        free(state_path);
+        return LDAP_OTHER;
+    }
+
+    DeltaState state;
+    int rc;
+    int have_state = delta_state_load(state_path, &state, &scan->arena) == 0 && state.highest_usn > 0;
+    if (have_state && !same_server(state.server, server)) {
+        log_error("Delta state was recorded on %s, now connected to %s; running a full scan to re-seed it.",
+                  state.server ? state.server : "an unnamed server", server ? server : "an unnamed server");
+        have_state = 0;
+    }
+    if (have_state) {
+        char filter[96];
+        snprintf(filter, sizeof(filter), "(&(objectClass=person)(uSNChanged>=%lld))", state.highest_usn + 1);
+        rc = search_users(ld, config, scan, config->base_dn, LDAP_SCOPE_SUBTREE, filter, attrs);
+        if (rc == LDAP_SUCCESS) {
+            rc = refetch_changed_members(ld, config, scan, &state, state.highest_usn + 1, attrs);
+        }
+
+        if (rc == LDAP_SUCCESS) {
+            char **deleted = NULL;
+            int deleted_count = 0;
+            fetch_deleted_guids(ld, naming_context, state.highest_usn + 1, &scan->arena,
+                                &deleted, &deleted_count);
+
+            int merged_count = 0;
+            ADUser *merged = delta_merge(&state, scan->users.items, scan->users.count,
+                                         deleted, deleted_count, &merged_count);
+            free(deleted);
+
+            scan->users.items = merged;
+            scan->users.count = merged ? merged_count : 0;
+            scan->users.cap = scan->users.count;
+            if (!merged) {
+                rc = LDAP_NO_MEMORY;
+            }
+
+            // Stored entries are re-scored so rule changes apply to the whole set,
+            // with group nesting and group and container descriptors read afresh
+            // and their stored ACE grants credited again
+            if (load_groups(ld, config, scan) < 0 || load_containers(ld, config, scan) < 0 ||
+                resolve_trustees(ld, config, scan->users.items, scan->users.count) != 0 ||
+                sd_resolve_grants(scan->users.items, scan->users.count) < 0 ||
+                risk_score_batch(scan->users.items, scan->users.count, risk_model_active()) != 0) {
+                rc = LDAP_NO_MEMORY;
+            }
+            scan->scored = 1;
+        } else {
+            free(state.users);
+        }
+    } else {
+        free(state.users);
+        rc = search_users(ld, config, scan, config->base_dn, LDAP_SCOPE_SUBTREE,
+                          "(objectClass=person)", attrs);
     }
 
-    ldap_msgfree(result);
     ldap_unbind_ext_s(ld, NULL, NULL);
 
-    *count_out = num_entries;
-    return users;
-}
\ No newline at end of file
+    if (rc == LDAP_SUCCESS) {
+        delta_state_save(state_path, config, server, usn_now, scan->users.items, scan->users.count);
+    }
+
+    free(naming_context);
+    free(server);
+    free(state_path);
+    return rc;
+}
+
+// Users returned by fetch_real_users, allocated together with the arena that
+// owns their strings and group IDs
+typedef struct {
+    Arena arena;
+    ADUser users[];
+} ScanResult;
+
+// Deterministic result order, independent of server order and worker count
+static int user_dn_cmp(const void *a, const void *b) {
+    const ADUser *ua = a;
+    const ADUser *ub = b;
+    int rc = strcasecmp(ua->dn ? ua->dn : "", ub->dn ? ub->dn : "");
+    if (rc != 0) return rc;
+    return strcmp(ua->username ? ua->username : "", ub->username ? ub->username : "");
+}
+
+ADUser *fetch_real_users(const Config *config, int *count_out, ScanStats *stats) {
+    char *attrs[] = {"cn", "mail", "sAMAccountName", "uid", "memberOf", "objectGUID",
+                     "objectSid", "nTSecurityDescriptor", NULL};
+    ScanContext scan;
+    int rc = LDAP_OTHER;
+
+    *count_out = 0;
+    memset(&scan, 0, sizeof(scan));
+    arena_init(&scan.arena);
+    scan.stats = stats;
+    // With a thread pool the download only decodes; scoring runs in parallel after it
+    scan.defer_scoring = thread_pool_size() > 1;
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &scan.start);
+    classifier_reset_cache();
+    group_graph_reset();
+    group_rights_reset();
+    effective_rights_reset();
+    SdCacheStats sd_before;
+    sd_cache_stats(&sd_before);
+    long wellknown_hits_before, wellknown_misses_before;
+    wellknown_stats(&wellknown_hits_before, &wellknown_misses_before);
+
+    if (config->delta_scan) {
+        rc = delta_scan(config, &scan, attrs);
+        if (rc != LDAP_SUCCESS) {
+            log_error("Delta scan failed (%s); running a full scan.", ldap_err2string(rc));
+            discard_scan(&scan);
+            scan.seen_first = 0;
+            scan.scored = 0;
+            if (stats) {
+                memset(stats, 0, sizeof(*stats));
+            }
+        }
+    }
+
+    if (rc != LDAP_SUCCESS && config->scan_workers > 1) {
+        rc = partitioned_scan(config, &scan, attrs);
+        if (rc != LDAP_SUCCESS) {
+            log_error("Partitioned scan failed (%s); retrying on a single connection.", ldap_err2string(rc));
+            discard_scan(&scan);
+            scan.seen_first = 0;
+            scan.scored = 0;
+            if (stats) {
+                memset(stats, 0, sizeof(*stats));
+            }
+        }
+    }
+
+    if (rc != LDAP_SUCCESS) {
+        rc = single_scan(config, &scan, attrs);
+        if (rc != LDAP_SUCCESS) {
+            discard_scan(&scan);
+            return NULL;
+        }
+    }
+
+    // Groups, container descriptors and ACE trustees are only known once
+    // every object is in, so they are read over one more connection after the download
+    if (!scan.scored) {
+        LDAP *ld = connect_and_bind(config);
+        int nested = ld ? load_groups(ld, config, &scan) : 0;
+        int containers = ld && nested >= 0 ? load_containers(ld, config, &scan) : 0;
+        int holders = -1;
+        if (nested >= 0 && containers >= 0 && resolve_trustees(ld, config, scan.users.items, scan.users.count) == 0) {
+            holders = sd_resolve_grants(scan.users.items, scan.users.count);
+        }
+        if (ld) {
+            ldap_unbind_ext_s(ld, NULL, NULL);
+        }
+        if (holders < 0) {
+            log_error("Memory allocation failed while resolving group nesting, container rights and ACE trustees.");
+            discard_scan(&scan);
+            return NULL;
+        }
+
+        // Users scored during the download saw direct memberships only
+        if (nested > 0 && !scan.defer_scoring) {
+            if (risk_score_batch(scan.users.items, scan.users.count, risk_model_active()) != 0) {
+                log_error("Memory allocation failed while scoring users.");
+                discard_scan(&scan);
+                return NULL;
+            }
+            scan.scored = 1;
+        } else if (holders > 0 && !scan.defer_scoring) {
+            for (int i = 0; i < scan.users.count; i++) {
+                if (scan.users.items[i].acl_perms && risk_score_user(&scan.users.items[i], risk_model_active()) != 0) {
+                    log_error("Memory allocation failed while scoring users.");
+                    discard_scan(&scan);
+                    return NULL;
+                }
+            }
+        }
+    }
+
+    if (scan.defer_scoring && !scan.scored &&
+        risk_score_batch(scan.users.items, scan.users.count, risk_model_active()) != 0) {
+        log_error("Memory allocation failed while scoring users.");
+        discard_scan(&scan);
+        return NULL;
+    }
+
+    if (scan.users.count > 1) {
+        qsort(scan.users.items, (size_t)scan.users.count, sizeof(ADUser), user_dn_cmp);
+    }
+
+    // One line per scan, however many objects carry a malformed descriptor
+    SdCacheStats sd_after;
+    sd_cache_stats(&sd_after);
+    if (sd_after.malformed > sd_before.malformed) {
+        log_error("Ignored %ld malformed nTSecurityDescriptor value(s); those objects grant no ACE rights.",
+                  sd_after.malformed - sd_before.malformed);
+    }
+
+    if (stats) {
+        stats->total_seconds = seconds_since(&scan.start);
+        classifier_cache_stats(&stats->group_cache_hits, &stats->group_cache_misses);
+        stats->arena_bytes = scan.arena.bytes_used;
+        stats->arena_allocations = scan.arena.allocations;
+        stats->arena_chunks = scan.arena.chunks;
+
+        stats->unique_security_descriptors = sd_after.unique - sd_before.unique;
+        stats->malformed_security_descriptors = sd_after.malformed - sd_before.malformed;
+        stats->security_descriptor_bytes = sd_after.bytes - sd_before.bytes;
+        stats->security_descriptor_bytes_saved = sd_after.bytes_saved - sd_before.bytes_saved;
+
+        GroupGraphStats graph_stats;
+        group_graph_stats(&graph_stats);
+        stats->group_nesting_edges = graph_stats.edges;
+        stats->nested_groups = graph_stats.nested_groups;
+        stats->group_nesting_cycles = graph_stats.cycles;
+
+        EffectiveRightsStats rights_stats;
+        effective_rights_stats(&rights_stats);
+        stats->containers = rights_stats.containers;
+        stats->inheritable_aces = rights_stats.inheritable_aces;
+        stats->inherit_chain_links = rights_stats.chain_links;
+        stats->inherit_chains_shared = rights_stats.shared_chains;
+        stats->users_inheriting = rights_stats.users_inherited;
+
+        SidResolverStats sid_stats;
+        sid_resolver_stats(&sid_stats);
+        stats->sid_cache_hits = sid_stats.hits;
+        stats->sid_cache_misses = sid_stats.misses;
+        stats->sid_wellknown_hits = sid_stats.wellknown_hits;
+        stats->sid_lookup_batches = sid_stats.batches;
+        stats->sid_unresolved = sid_stats.unresolved;
+        long wellknown_hits, wellknown_misses;
+        wellknown_stats(&wellknown_hits, &wellknown_misses);
+        stats->wellknown_hits = wellknown_hits - wellknown_hits_before;
+        stats->wellknown_misses = wellknown_misses - wellknown_misses_before;
+    }
+
+    if (scan.users.count <= 0) {
+        discard_scan(&scan);
+        return NULL;
+    }
+
+    // Hand the users out in one block that also carries their arena, so
+    // release_real_users() can tear the whole scan down in one call
+    ScanResult *result = malloc(sizeof(ScanResult) + (size_t)scan.users.count * sizeof(ADUser));
+    if (!result) {
+        discard_scan(&scan);
+        return NULL;
+    }
+    result->arena = scan.arena;
+    memcpy(result->users, scan.users.items, (size_t)scan.users.count * sizeof(ADUser));
+    *count_out = scan.users.count;
+    discard_users(&scan.users);
+    return result->users;
+}
+
+void release_real_users(ADUser *users) {
+    if (!users) return;
+    ScanResult *result = (ScanResult *)((char *)users - offsetof(ScanResult, users));
+    arena_destroy(&result->arena);
+    free(result);
+}
@@ -1,77 +1,27 @@
 #include "ldap_insights.h"
-#include <ctype.h>
+#include "attack_graph.h"
+#include "classifier.h"
+#include "effective_rights.h"
+#include "error_handler.h"
+#include "group_graph.h"
+#include "group_rights.h"
+#include "group_table.h"
+#include "json_writer.h"
+#include "report.h"
+#include "risk_engine.h"
+#include "snapshot.h"
+#include "sid_resolver.h"
+#include "thread_pool.h"
+#include "user_store.h"
 #include <errno.h>
 #include <json-c/json.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
 
-typedef struct {
-    char **items;
-    size_t count;
-    size_t cap;
-} StringList;
-
-static void list_init(StringList *list) {
-    list->items = NULL;
-    list->count = 0;
-    list->cap = 0;
-}
-
-static void list_push(StringList *list, const char *value) {
-    if (!value) return;
-    if (list->count + 1 > list->cap) {
-        size_t new_cap = list->cap == 0 ? 4 : list->cap * 2;
-        char **next = realloc(list->items, new_cap * sizeof(char *));
-        if (!next) return;
-        list->items = next;
-        list->cap = new_cap;
-    }
-    list->items[list->count++] = strdup(value);
-}
-
-static void list_free(StringList *list) {
-    if (!list) return;
-    for (size_t i = 0; i < list->count; i++) {
-        free(list->items[i]);
-    }
-    free(list->items);
-    list->items = NULL;
-    list->count = 0;
-    list->cap = 0;
-}
-
-static int ci_contains(const char *haystack, const char *needle) {
-    if (!haystack || !needle) return 0;
-    size_t hlen = strlen(haystack);
-    size_t nlen = strlen(needle);
-    if (nlen == 0 || hlen < nlen) return 0;
-    for (size_t i = 0; i <= hlen - nlen; i++) {
-        size_t j = 0;
-        while (j < nlen && tolower((unsigned char)haystack[i + j]) == tolower((unsigned char)needle[j])) {
-            j++;
-        }
-        if (j == nlen) return 1;
-    }
-    return 0;
-}
-
-static int starts_with_ci(const char *str, const char *prefix) {
-    if (!str || !prefix) return 0;
-    size_t len = strlen(prefix);
-    return strncasecmp(str, prefix, len) == 0;
-}
-
-static int count_groups(const char *memberOf) {
-    if (!memberOf || memberOf[0] == '\0') return 0;
-    int count = 1;
-    for (const char *p = memberOf; *p; p++) {
-        if (*p == ',') count++;
-    }
-    return count;
-}
-
 static const char *user_key(const ADUser *u) {
     if (u->username && u->username[0] != '\0') return u->username;
     if (u->cn && u->cn[0] != '\0') return u->cn;
@@ -115,507 +65,652 @@ static void update_counts(struct json_object *counts, const char *severity) {
     json_object_object_add(counts, severity, json_object_new_int(next));
 }
 
-static void add_alert(struct json_object *recent,
-                      struct json_object *counts,
-                      const char *id,
-                      const char *type,
-                      const char *severity,
-                      const char *time,
-                      const char *user,
-                      const char *host,
-                      const char *details) {
-    struct json_object *alert = json_object_new_object();
-    json_object_object_add(alert, "id", json_object_new_string(id));
-    json_object_object_add(alert, "type", json_object_new_string(type));
-    json_object_object_add(alert, "severity", json_object_new_string(severity));
-    json_object_object_add(alert, "time", json_object_new_string(time));
-    json_object_object_add(alert, "user", json_object_new_string(user));
-    json_object_object_add(alert, "host", json_object_new_string(host));
-    json_object_object_add(alert, "details", json_object_new_string(details));
-    json_object_array_add(recent, alert);
-    update_counts(counts, severity);
-}
-
-static struct json_object *build_alerts(ADUser *users,
-                                        int count,
-                                        struct json_object **counts_out,
-                                        StringList *kerb_ids,
-                                        StringList *admin_ids,
-                                        StringList *enum_ids) {
-    struct json_object *recent = json_object_new_array();
-    struct json_object *counts = json_object_new_object();
-    json_object_object_add(counts, "critical", json_object_new_int(0));
-    json_object_object_add(counts, "high", json_object_new_int(0));
-    json_object_object_add(counts, "medium", json_object_new_int(0));
-    json_object_object_add(counts, "low", json_object_new_int(0));
+// Per-user detector results
+#define DETECT_SERVICE     0x1
+#define DETECT_PRIVILEGED  0x2
+#define DETECT_ENUMERATION 0x4
 
+typedef struct {
+    ADUser **users;
+    unsigned char *detections;
+    const RiskModel *model; // Detectors share the risk engine's factor definitions
+} DetectContext;
+
+static void detect_range(void *arg, int begin, int end) {
+    DetectContext *detect = arg;
+    for (int i = begin; i < end; i++) {
+        const ADUser *u = detect->users[i];
+        unsigned int factors = risk_user_factors(u, detect->model);
+        unsigned char flags = 0;
+        if (u->perms.hasServiceAcct || (factors & RISK_FACTOR_SERVICE_NAME)) flags |= DETECT_SERVICE;
+        if (u->perms.isAdmin || u->perms.isPrivileged) flags |= DETECT_PRIVILEGED;
+        if (factors & RISK_FACTOR_GROUP_VOLUME) flags |= DETECT_ENUMERATION;
+        detect->detections[i] = flags;
+    }
+}
+
+// Alert kinds, in the order one user's alerts are numbered
+enum {
+    ALERT_KERBEROASTING,
+    ALERT_PRIVILEGED,
+    ALERT_ENUMERATION,
+    ALERT_KINDS
+};
+
+static const struct {
+    unsigned char detection;
+    const char *type;
+    const char *severity;
+    const char *details;
+} alert_kinds[ALERT_KINDS] = {
+    { DETECT_SERVICE, "Kerberoasting", "high", "Service account shows elevated risk for ticket abuse." },
+    { DETECT_PRIVILEGED, "Privileged Group Change", "high", "Privileged group membership detected." },
+    { DETECT_ENUMERATION, "Unusual LDAP Enumeration", "medium", "High volume group membership detected." },
+};
+
+static const char *alert_severity(int kind, int risk) {
+    if (kind == ALERT_KERBEROASTING && risk >= 60) return "critical";
+    return alert_kinds[kind].severity;
+}
+
+// Incidents and the correlations they back, raised when their alert kind fired
+typedef struct {
+    const char *id;
+    const char *title;
+    const char *severity;
+    int kind;
+    const char *findings[3];
+    const char *recommendations[3];
+    const char *attack;
+    double confidence;
+    const char *signals[3];
+    const char *impact;
+    const char *summary;
+} IncidentSpec;
+
+static const IncidentSpec incident_specs[] = {
+    {
+        "INC-LDAP-0001", "Suspicious Service Ticket Burst", "high", ALERT_KERBEROASTING,
+        { "Service accounts flagged with elevated ticket abuse risk.", "Kerberos-related groups detected in memberships.", NULL },
+        { "Rotate service account credentials.", "Review SPN usage and enforce AES-only tickets.", NULL },
+        "kerberoasting", 0.85,
+        { "Service account membership", "Elevated risk score", NULL },
+        "Potential credential exposure",
+        "Service accounts show patterns consistent with kerberoasting risk.",
+    },
+    {
+        "INC-LDAP-0002", "Privileged Group Membership Drift", "medium", ALERT_PRIVILEGED,
+        { "Privileged group memberships detected in LDAP.", NULL, NULL },
+        { "Review privileged memberships for approval.", NULL, NULL },
+        "privilege_escalation", 0.78,
+        { "Admin group membership", "Privileged permissions detected", NULL },
+        "Elevated privileges without clear change record",
+        "Privileged membership patterns suggest escalation risk.",
+    },
+};
+
+#define INCIDENT_SPECS ((int)(sizeof(incident_specs) / sizeof(incident_specs[0])))
+
+// Alerts, incidents and correlations derived from one scan. Every subcommand
+// and every report section reads the same set, built once. Alerts are not
+// stored: the detector flags are kept per user and an AlertCursor replays
+// them in numbering order whenever they are written, so output streams
+// without a document tree however many alerts fire. A saved scan (snapshot.h)
+// supplies the users, already in alert order, and their flags directly.
+typedef struct {
+    ADUser **sorted;              // Users in alert order (live scan)
+    const UserStore *store;       // Users in alert order (snapshot)
+    const unsigned char *detections; // DETECT_* flags per user in alert order
+    unsigned char *detect_buf;    // Flags computed for a live scan
+    int user_count;
+    int kind_counts[ALERT_KINDS];
+    int alert_count;              // Detector alerts plus external ones
+    struct json_object *external; // ACLGUARD_ALERTS_FILE document, if any
+    struct json_object *external_recent; // Its alert array, borrowed
+    struct json_object *counts;   // Alerts per severity
+    int incident_count;
+    const char *latest_id;
     char time_buf[32];
-    current_time_rfc3339(time_buf, sizeof(time_buf));
+} Insights;
 
-    ADUser **sorted = calloc((size_t)count, sizeof(ADUser *));
-    if (!sorted) {
-        if (counts_out) *counts_out = counts;
-        return recent;
-    }
-    for (int i = 0; i < count; i++) sorted[i] = &users[i];
-    qsort(sorted, (size_t)count, sizeof(ADUser *), user_cmp);
+typedef struct {
+    const Insights *in;
+    int user;
+    int kind;
+    int number;
+} AlertCursor;
 
-    int alert_index = 1;
-    for (int i = 0; i < count; i++) {
-        ADUser *u = sorted[i];
-        const char *username = u->username ? u->username : "unknown";
-        int groups = count_groups(u->memberOf);
-
-        int is_service = u->perms.hasServiceAcct ||
-                         starts_with_ci(username, "svc") ||
-                         ci_contains(username, "service");
-        int is_privileged = u->perms.isAdmin || u->perms.isPrivileged;
-        int is_enum = groups >= 10;
-
-        if (is_service) {
-            char id[32];
-            snprintf(id, sizeof(id), "AL-LDAP-%04d", alert_index++);
-            const char *sev = u->risk >= 60 ? "critical" : "high";
-            add_alert(recent, counts, id, "Kerberoasting", sev, time_buf, username, "ldap", "Service account shows elevated risk for ticket abuse.");
-            list_push(kerb_ids, id);
-        }
+typedef struct {
+    char id[32];
+    int kind;
+    const char *user;
+    int risk;
+} Alert;
+
+// Username and risk of user i in alert order
+static const char *insights_user(const Insights *in, int i) {
+    const char *name = in->store ? user_store_string(in->store, USER_COL_USERNAME, i) : in->sorted[i]->username;
+    return name ? name : "unknown";
+}
 
-        if (is_privileged) {
-            char id[32];
-            snprintf(id, sizeof(id), "AL-LDAP-%04d", alert_index++);
-            add_alert(recent, counts, id, "Privileged Group Change", "high", time_buf, username, "ldap", "Privileged group membership detected.");
-            list_push(admin_ids, id);
-        }
+static int insights_risk(const Insights *in, int i) {
+    return in->store ? in->store->risk[i] : in->sorted[i]->risk;
+}
+
+static void alert_cursor_init(AlertCursor *cursor, const Insights *in) {
+    cursor->in = in;
+    cursor->user = 0;
+    cursor->kind = 0;
+    cursor->number = 1;
+}
 
-        if (is_enum) {
-            char id[32];
-            snprintf(id, sizeof(id), "AL-LDAP-%04d", alert_index++);
-            add_alert(recent, counts, id, "Unusual LDAP Enumeration", "medium", time_buf, username, "ldap", "High volume group membership detected.");
-            list_push(enum_ids, id);
+// Next detector alert in numbering order; 0 when done
+static int alert_cursor_next(AlertCursor *cursor, Alert *alert) {
+    const Insights *in = cursor->in;
+    for (; cursor->user < in->user_count; cursor->user++, cursor->kind = 0) {
+        unsigned char flags = in->detections[cursor->user];
+        while (cursor->kind < ALERT_KINDS) {
+            int kind = cursor->kind++;
+            if (!(flags & alert_kinds[kind].detection)) continue;
+            snprintf(alert->id, sizeof(alert->id), "AL-LDAP-%04d", cursor->number++);
+            alert->kind = kind;
+            alert->user = insights_user(in, cursor->user);
+            alert->risk = insights_risk(in, cursor->user);
+            return 1;
         }
     }
-    free(sorted);
-
-    struct json_object *external = load_external_alerts();
-    if (external) {
-        struct json_object *ext_recent = NULL;
-        if (json_object_is_type(external, json_type_object)) {
-            json_object_object_get_ex(external, "data", &ext_recent);
-            if (ext_recent && json_object_is_type(ext_recent, json_type_object)) {
-                struct json_object *tmp = NULL;
-                if (json_object_object_get_ex(ext_recent, "recent", &tmp) && json_object_is_type(tmp, json_type_array)) {
-                    ext_recent = tmp;
-                } else {
-                    ext_recent = NULL;
-                }
-            } else {
-                ext_recent = NULL;
+    return 0;
+}
+
+// Alert objects of the external file, either {"data": {"recent": [...]}} or a bare array
+static struct json_object *external_recent(struct json_object *external) {
+    if (json_object_is_type(external, json_type_array)) return external;
+    struct json_object *data = NULL;
+    struct json_object *recent = NULL;
+    if (json_object_is_type(external, json_type_object) &&
+        json_object_object_get_ex(external, "data", &data) && json_object_is_type(data, json_type_object) &&
+        json_object_object_get_ex(data, "recent", &recent) && json_object_is_type(recent, json_type_array)) {
+        return recent;
+    }
+    return NULL;
+}
+
+// Alert, severity and incident counts over the detector flags, plus the
+// external alerts file
+static void insights_tally(Insights *in) {
+    int severity_counts[4] = {0, 0, 0, 0};
+    static const char *severities[4] = {"critical", "high", "medium", "low"};
+    for (int i = 0; i < in->user_count; i++) {
+        for (int kind = 0; kind < ALERT_KINDS; kind++) {
+            if (!(in->detections[i] & alert_kinds[kind].detection)) continue;
+            const char *severity = alert_severity(kind, insights_risk(in, i));
+            for (int s = 0; s < 4; s++) {
+                if (strcmp(severity, severities[s]) == 0) severity_counts[s]++;
             }
-        } else if (json_object_is_type(external, json_type_array)) {
-            ext_recent = external;
+            in->kind_counts[kind]++;
+            in->alert_count++;
         }
+    }
+    in->counts = json_object_new_object();
+    for (int s = 0; s < 4; s++) {
+        json_object_object_add(in->counts, severities[s], json_object_new_int(severity_counts[s]));
+    }
 
-        if (ext_recent && json_object_is_type(ext_recent, json_type_array)) {
-            size_t ext_count = json_object_array_length(ext_recent);
-            for (size_t i = 0; i < ext_count; i++) {
-                struct json_object *item = json_object_array_get_idx(ext_recent, i);
-                if (!item || !json_object_is_type(item, json_type_object)) continue;
-                struct json_object *sev = NULL;
-                if (json_object_object_get_ex(item, "severity", &sev) && json_object_is_type(sev, json_type_string)) {
-                    update_counts(counts, json_object_get_string(sev));
-                }
-                json_object_array_add(recent, json_object_get(item));
-            }
+    in->external = load_external_alerts();
+    in->external_recent = in->external ? external_recent(in->external) : NULL;
+    size_t ext_count = in->external_recent ? json_object_array_length(in->external_recent) : 0;
+    for (size_t i = 0; i < ext_count; i++) {
+        struct json_object *item = json_object_array_get_idx(in->external_recent, i);
+        if (!item || !json_object_is_type(item, json_type_object)) continue;
+        struct json_object *sev = NULL;
+        if (json_object_object_get_ex(item, "severity", &sev) && json_object_is_type(sev, json_type_string)) {
+            update_counts(in->counts, json_object_get_string(sev));
         }
-        json_object_put(external);
+        in->alert_count++;
     }
 
-    if (counts_out) {
-        *counts_out = counts;
+    for (int i = 0; i < INCIDENT_SPECS; i++) {
+        if (in->kind_counts[incident_specs[i].kind] == 0) continue;
+        if (in->incident_count++ == 0) in->latest_id = incident_specs[i].id;
     }
-    return recent;
 }
 
-static struct json_object *build_incidents(StringList *kerb_ids,
-                                           StringList *admin_ids,
-                                           const char *time_buf,
-                                           const char **latest_id_out,
-                                           struct json_object **correlations_out) {
-    struct json_object *incidents = json_object_new_array();
-    struct json_object *correlations = json_object_new_array();
-    const char *latest = "";
+static void insights_build(Insights *in, ADUser *users, int count) {
+    memset(in, 0, sizeof(*in));
+    in->latest_id = "";
+    current_time_rfc3339(in->time_buf, sizeof(in->time_buf));
+
+    in->sorted = calloc((size_t)(count > 0 ? count : 1), sizeof(ADUser *));
+    in->detect_buf = calloc((size_t)(count > 0 ? count : 1), 1);
+    if (in->sorted && in->detect_buf) {
+        for (int i = 0; i < count; i++) in->sorted[i] = &users[i];
+        qsort(in->sorted, (size_t)count, sizeof(ADUser *), user_cmp);
+
+        // Run the per-user detectors in parallel; alerts are numbered in sorted
+        // order so IDs match the single-threaded numbering
+        DetectContext detect = {in->sorted, in->detect_buf, risk_model_active()};
+        parallel_for(count, PARALLEL_CHUNK, detect_range, &detect);
+        in->detections = in->detect_buf;
+        in->user_count = count;
+    }
+    insights_tally(in);
+}
 
-    if (kerb_ids->count > 0) {
-        struct json_object *inc = json_object_new_object();
-        json_object_object_add(inc, "id", json_object_new_string("INC-LDAP-0001"));
-        json_object_object_add(inc, "title", json_object_new_string("Suspicious Service Ticket Burst"));
-        json_object_object_add(inc, "status", json_object_new_string("open"));
-        json_object_object_add(inc, "severity", json_object_new_string("high"));
-        json_object_object_add(inc, "started", json_object_new_string(time_buf));
-        json_object_object_add(inc, "last_update", json_object_new_string(time_buf));
+// Insights of a saved scan: users, flags and scan time come from the mapping
+static void insights_from_snapshot(Insights *in, const Snapshot *snap) {
+    memset(in, 0, sizeof(*in));
+    in->latest_id = "";
+    snprintf(in->time_buf, sizeof(in->time_buf), "%s", snap->scan_time);
+    in->store = &snap->store;
+    in->detections = snap->detections;
+    in->user_count = snap->store.count;
+    insights_tally(in);
+}
 
-        struct json_object *related = json_object_new_array();
-        for (size_t i = 0; i < kerb_ids->count; i++) {
-            json_object_array_add(related, json_object_new_string(kerb_ids->items[i]));
-        }
-        json_object_object_add(inc, "related_alerts", related);
-
-        struct json_object *findings = json_object_new_array();
-        json_object_array_add(findings, json_object_new_string("Service accounts flagged with elevated ticket abuse risk."));
-        json_object_array_add(findings, json_object_new_string("Kerberos-related groups detected in memberships."));
-        json_object_object_add(inc, "findings", findings);
-
-        struct json_object *reco = json_object_new_array();
-        json_object_array_add(reco, json_object_new_string("Rotate service account credentials."));
-        json_object_array_add(reco, json_object_new_string("Review SPN usage and enforce AES-only tickets."));
-        json_object_object_add(inc, "recommendations", reco);
-
-        json_object_array_add(incidents, inc);
-        latest = "INC-LDAP-0001";
-
-        struct json_object *corr = json_object_new_object();
-        json_object_object_add(corr, "attack", json_object_new_string("kerberoasting"));
-        json_object_object_add(corr, "incident_id", json_object_new_string("INC-LDAP-0001"));
-        json_object_object_add(corr, "confidence", json_object_new_double(0.85));
-        struct json_object *signals = json_object_new_array();
-        json_object_array_add(signals, json_object_new_string("Service account membership"));
-        json_object_array_add(signals, json_object_new_string("Elevated risk score"));
-        json_object_object_add(corr, "signals", signals);
-        json_object_object_add(corr, "impact", json_object_new_string("Potential credential exposure"));
-        json_object_object_add(corr, "summary", json_object_new_string("Service accounts show patterns consistent with kerberoasting risk."));
-        json_object_array_add(correlations, corr);
-    }
-
-    if (admin_ids->count > 0) {
-        struct json_object *inc = json_object_new_object();
-        json_object_object_add(inc, "id", json_object_new_string("INC-LDAP-0002"));
-        json_object_object_add(inc, "title", json_object_new_string("Privileged Group Membership Drift"));
-        json_object_object_add(inc, "status", json_object_new_string("open"));
-        json_object_object_add(inc, "severity", json_object_new_string("medium"));
-        json_object_object_add(inc, "started", json_object_new_string(time_buf));
-        json_object_object_add(inc, "last_update", json_object_new_string(time_buf));
-
-        struct json_object *related = json_object_new_array();
-        for (size_t i = 0; i < admin_ids->count; i++) {
-            json_object_array_add(related, json_object_new_string(admin_ids->items[i]));
-        }
-        json_object_object_add(inc, "related_alerts", related);
+static void insights_free(Insights *in) {
+    json_object_put(in->counts);
+    json_object_put(in->external);
+    free(in->sorted);
+    free(in->detect_buf);
+}
 
-        struct json_object *findings = json_object_new_array();
-        json_object_array_add(findings, json_object_new_string("Privileged group memberships detected in LDAP."));
-        json_object_object_add(inc, "findings", findings);
+// Incident with the given ID (or correlation with the given attack) raised by this scan
+static const IncidentSpec *find_incident(const Insights *in, const char *id, const char *attack) {
+    for (int i = 0; i < INCIDENT_SPECS; i++) {
+        const IncidentSpec *spec = &incident_specs[i];
+        if (in->kind_counts[spec->kind] == 0) continue;
+        if (id && strcasecmp(spec->id, id) == 0) return spec;
+        if (attack && strcasecmp(spec->attack, attack) == 0) return spec;
+    }
+    return NULL;
+}
 
-        struct json_object *reco = json_object_new_array();
-        json_object_array_add(reco, json_object_new_string("Review privileged memberships for approval."));
-        json_object_object_add(inc, "recommendations", reco);
+#define LDAP_DETECTORS 4
 
-        json_object_array_add(incidents, inc);
-        if (latest[0] == '\0') latest = "INC-LDAP-0002";
+static void write_strings(JsonWriter *w, const char *const *items) {
+    json_writer_begin_array(w);
+    for (int i = 0; i < 3 && items[i]; i++) json_writer_string(w, items[i]);
+    json_writer_end_array(w);
+}
 
-        struct json_object *corr = json_object_new_object();
-        json_object_object_add(corr, "attack", json_object_new_string("privilege_escalation"));
-        json_object_object_add(corr, "incident_id", json_object_new_string("INC-LDAP-0002"));
-        json_object_object_add(corr, "confidence", json_object_new_double(0.78));
-        struct json_object *signals = json_object_new_array();
-        json_object_array_add(signals, json_object_new_string("Admin group membership"));
-        json_object_array_add(signals, json_object_new_string("Privileged permissions detected"));
-        json_object_object_add(corr, "signals", signals);
-        json_object_object_add(corr, "impact", json_object_new_string("Elevated privileges without clear change record"));
-        json_object_object_add(corr, "summary", json_object_new_string("Privileged membership patterns suggest escalation risk."));
-        json_object_array_add(correlations, corr);
-    }
+static void write_status_data(JsonWriter *w, const Insights *in) {
+    json_writer_begin_object(w);
+    json_writer_key(w, "mode");
+    json_writer_string(w, "ldap");
+    json_writer_key(w, "fixtures_version");
+    json_writer_string(w, "live");
+    json_writer_key(w, "alerts_total");
+    json_writer_int(w, in->alert_count);
+    json_writer_key(w, "incidents_open");
+    json_writer_int(w, in->incident_count);
+    json_writer_key(w, "detectors");
+    json_writer_int(w, LDAP_DETECTORS);
+    json_writer_key(w, "last_refresh");
+    json_writer_string(w, in->time_buf);
+    json_writer_end_object(w);
+}
 
-    if (latest_id_out) {
-        *latest_id_out = latest;
+static void write_alert(JsonWriter *w, const Insights *in, const Alert *alert) {
+    json_writer_begin_object(w);
+    json_writer_key(w, "id");
+    json_writer_string(w, alert->id);
+    json_writer_key(w, "type");
+    json_writer_string(w, alert_kinds[alert->kind].type);
+    json_writer_key(w, "severity");
+    json_writer_string(w, alert_severity(alert->kind, alert->risk));
+    json_writer_key(w, "time");
+    json_writer_string(w, in->time_buf);
+    json_writer_key(w, "user");
+    json_writer_string(w, alert->user);
+    json_writer_key(w, "host");
+    json_writer_string(w, "ldap");
+    json_writer_key(w, "details");
+    json_writer_string(w, alert_kinds[alert->kind].details);
+    json_writer_end_object(w);
+}
+
+// Detector alerts, then external ones; as array elements, or one record per
+// line when lines is set
+static void write_recent(JsonWriter *w, const Insights *in, int lines) {
+    AlertCursor cursor;
+    Alert alert;
+    alert_cursor_init(&cursor, in);
+    while (alert_cursor_next(&cursor, &alert)) {
+        write_alert(w, in, &alert);
+        if (lines) json_writer_raw(w, "\n", 1);
     }
-    if (correlations_out) {
-        *correlations_out = correlations;
+    size_t ext_count = in->external_recent ? json_object_array_length(in->external_recent) : 0;
+    for (size_t i = 0; i < ext_count; i++) {
+        struct json_object *item = json_object_array_get_idx(in->external_recent, i);
+        if (!item || !json_object_is_type(item, json_type_object)) continue;
+        json_writer_json(w, item);
+        if (lines) json_writer_raw(w, "\n", 1);
     }
-    return incidents;
 }
 
-int ldap_status_output(ADUser *users, int count, int json_output) {
-    StringList kerb_ids, admin_ids, enum_ids;
-    list_init(&kerb_ids);
-    list_init(&admin_ids);
-    list_init(&enum_ids);
-    struct json_object *counts = NULL;
-    struct json_object *recent = build_alerts(users, count, &counts, &kerb_ids, &admin_ids, &enum_ids);
+static void write_alerts_data(JsonWriter *w, const Insights *in) {
+    json_writer_begin_object(w);
+    json_writer_key(w, "window");
+    json_writer_string(w, "scan");
+    json_writer_key(w, "recent");
+    json_writer_begin_array(w);
+    write_recent(w, in, 0);
+    json_writer_end_array(w);
+    json_writer_key(w, "counts");
+    json_writer_json(w, in->counts);
+    json_writer_end_object(w);
+}
 
-    char time_buf[32];
-    current_time_rfc3339(time_buf, sizeof(time_buf));
+static void write_incident(JsonWriter *w, const Insights *in, const IncidentSpec *spec) {
+    json_writer_begin_object(w);
+    json_writer_key(w, "id");
+    json_writer_string(w, spec->id);
+    json_writer_key(w, "title");
+    json_writer_string(w, spec->title);
+    json_writer_key(w, "status");
+    json_writer_string(w, "open");
+    json_writer_key(w, "severity");
+    json_writer_string(w, spec->severity);
+    json_writer_key(w, "started");
+    json_writer_string(w, in->time_buf);
+    json_writer_key(w, "last_update");
+    json_writer_string(w, in->time_buf);
+    json_writer_key(w, "related_alerts");
+    json_writer_begin_array(w);
+    AlertCursor cursor;
+    Alert alert;
+    alert_cursor_init(&cursor, in);
+    while (alert_cursor_next(&cursor, &alert)) {
+        if (alert.kind == spec->kind) json_writer_string(w, alert.id);
+    }
+    json_writer_end_array(w);
+    json_writer_key(w, "findings");
+    write_strings(w, spec->findings);
+    json_writer_key(w, "recommendations");
+    write_strings(w, spec->recommendations);
+    json_writer_end_object(w);
+}
 
-    const char *latest_id = "";
-    struct json_object *correlations = NULL;
-    struct json_object *incidents = build_incidents(&kerb_ids, &admin_ids, time_buf, &latest_id, &correlations);
+static void write_correlation(JsonWriter *w, const IncidentSpec *spec) {
+    json_writer_begin_object(w);
+    json_writer_key(w, "attack");
+    json_writer_string(w, spec->attack);
+    json_writer_key(w, "incident_id");
+    json_writer_string(w, spec->id);
+    json_writer_key(w, "confidence");
+    json_writer_double(w, spec->confidence);
+    json_writer_key(w, "signals");
+    write_strings(w, spec->signals);
+    json_writer_key(w, "impact");
+    json_writer_string(w, spec->impact);
+    json_writer_key(w, "summary");
+    json_writer_string(w, spec->summary);
+    json_writer_end_object(w);
+}
 
-    int incident_count = (int)json_object_array_length(incidents);
-    int alert_count = (int)json_object_array_length(recent);
-    int detectors = 4;
+// {"summary": ..., "data": <written by the caller>}; the caller closes the root
+static void begin_document(JsonWriter *w, const char *summary) {
+    json_writer_init(w, stdout, JSON_WRITER_PRETTY);
+    json_writer_begin_object(w);
+    json_writer_key(w, "summary");
+    json_writer_string(w, summary);
+}
 
-    struct json_object *root = json_object_new_object();
-    char summary[256];
-    snprintf(summary, sizeof(summary), "LDAP status OK. %d alerts, %d incidents, %d detectors.", alert_count, incident_count, detectors);
-    json_object_object_add(root, "summary", json_object_new_string(summary));
+static int finish_output(JsonWriter *w) {
+    if (json_writer_finish(w, NULL) != 0) {
+        fprintf(stderr, "Failed to write JSON output.\n");
+        return 1;
+    }
+    return 0;
+}
 
-    struct json_object *data = json_object_new_object();
-    json_object_object_add(data, "mode", json_object_new_string("ldap"));
-    json_object_object_add(data, "fixtures_version", json_object_new_string("live"));
-    json_object_object_add(data, "alerts_total", json_object_new_int(alert_count));
-    json_object_object_add(data, "incidents_open", json_object_new_int(incident_count));
-    json_object_object_add(data, "detectors", json_object_new_int(detectors));
-    json_object_object_add(data, "last_refresh", json_object_new_string(time_buf));
-    json_object_object_add(root, "data", data);
+static int end_document(JsonWriter *w) {
+    json_writer_end_object(w);
+    json_writer_raw(w, "\n", 1);
+    return finish_output(w);
+}
 
+static int status_output(Insights *in, int json_output) {
+    char summary[256];
+    snprintf(summary, sizeof(summary), "LDAP status OK. %d alerts, %d incidents, %d detectors.", in->alert_count,
+             in->incident_count, LDAP_DETECTORS);
+
+    int rc = 0;
     if (json_output) {
-        printf("%s\n", json_object_to_json_string_ext(root, JSON_C_TO_STRING_PRETTY));
+        JsonWriter w;
+        begin_document(&w, summary);
+        json_writer_key(&w, "data");
+        write_status_data(&w, in);
+        rc = end_document(&w);
     } else {
         printf("LDAP Status: OK\n");
         printf("Summary: %s\n", summary);
-        printf("Alerts total: %d\n", alert_count);
-        printf("Open incidents: %d\n", incident_count);
-        printf("Detectors: %d\n", detectors);
-        printf("Last refresh: %s\n", time_buf);
+        printf("Alerts total: %d\n", in->alert_count);
+        printf("Open incidents: %d\n", in->incident_count);
+        printf("Detectors: %d\n", LDAP_DETECTORS);
+        printf("Last refresh: %s\n", in->time_buf);
     }
 
-    json_object_put(recent);
-    json_object_put(counts);
-    json_object_put(incidents);
-    json_object_put(correlations);
-    json_object_put(root);
-    list_free(&kerb_ids);
-    list_free(&admin_ids);
-    list_free(&enum_ids);
-    return 0;
+    return rc;
 }
 
-int ldap_alerts_recent_output(ADUser *users, int count, int json_output) {
-    StringList kerb_ids, admin_ids, enum_ids;
-    list_init(&kerb_ids);
-    list_init(&admin_ids);
-    list_init(&enum_ids);
-    struct json_object *counts = NULL;
-    struct json_object *recent = build_alerts(users, count, &counts, &kerb_ids, &admin_ids, &enum_ids);
+static const char *external_field(struct json_object *item, const char *key) {
+    struct json_object *val = NULL;
+    return json_object_object_get_ex(item, key, &val) ? json_object_get_string(val) : "N/A";
+}
 
-    struct json_object *root = json_object_new_object();
-    int total = (int)json_object_array_length(recent);
+static int alerts_recent_output(Insights *in, int json_output) {
     char summary[256];
-    snprintf(summary, sizeof(summary), "%d recent alerts derived from LDAP scan.", total);
-    json_object_object_add(root, "summary", json_object_new_string(summary));
-
-    struct json_object *data = json_object_new_object();
-    json_object_object_add(data, "window", json_object_new_string("scan"));
-    json_object_object_add(data, "recent", json_object_get(recent));
-    json_object_object_add(data, "counts", json_object_get(counts));
-    json_object_object_add(root, "data", data);
-
-    if (json_output) {
-        printf("%s\n", json_object_to_json_string_ext(root, JSON_C_TO_STRING_PRETTY));
+    snprintf(summary, sizeof(summary), "%d recent alerts derived from LDAP scan.", in->alert_count);
+
+    int rc = 0;
+    if (json_output == OUTPUT_NDJSON) {
+        JsonWriter w;
+        json_writer_init(&w, stdout, 0);
+        write_recent(&w, in, 1);
+        rc = finish_output(&w);
+    } else if (json_output) {
+        JsonWriter w;
+        begin_document(&w, summary);
+        json_writer_key(&w, "data");
+        write_alerts_data(&w, in);
+        rc = end_document(&w);
     } else {
         printf("Recent Alerts\n");
         printf("Summary: %s\n", summary);
-        printf("Count: %d\n", total);
-        for (int i = 0; i < total; i++) {
-            struct json_object *item = json_object_array_get_idx(recent, i);
-            if (!item) continue;
-            struct json_object *id = NULL;
-            struct json_object *type = NULL;
-            struct json_object *severity = NULL;
-            struct json_object *time = NULL;
-            struct json_object *user = NULL;
-            json_object_object_get_ex(item, "id", &id);
-            json_object_object_get_ex(item, "type", &type);
-            json_object_object_get_ex(item, "severity", &severity);
-            json_object_object_get_ex(item, "time", &time);
-            json_object_object_get_ex(item, "user", &user);
-            printf("- %s [%s] %s (%s) user=%s\n",
-                   id ? json_object_get_string(id) : "N/A",
-                   severity ? json_object_get_string(severity) : "N/A",
-                   type ? json_object_get_string(type) : "N/A",
-                   time ? json_object_get_string(time) : "N/A",
-                   user ? json_object_get_string(user) : "N/A");
+        printf("Count: %d\n", in->alert_count);
+        AlertCursor cursor;
+        Alert alert;
+        alert_cursor_init(&cursor, in);
+        while (alert_cursor_next(&cursor, &alert)) {
+            printf("- %s [%s] %s (%s) user=%s\n", alert.id, alert_severity(alert.kind, alert.risk),
+                   alert_kinds[alert.kind].type, in->time_buf, alert.user);
+        }
+        size_t ext_count = in->external_recent ? json_object_array_length(in->external_recent) : 0;
+        for (size_t i = 0; i < ext_count; i++) {
+            struct json_object *item = json_object_array_get_idx(in->external_recent, i);
+            if (!item || !json_object_is_type(item, json_type_object)) continue;
+            printf("- %s [%s] %s (%s) user=%s\n", external_field(item, "id"), external_field(item, "severity"),
+                   external_field(item, "type"), external_field(item, "time"), external_field(item, "user"));
         }
     }
 
-    json_object_put(recent);
-    json_object_put(counts);
-    json_object_put(root);
-    list_free(&kerb_ids);
-    list_free(&admin_ids);
-    list_free(&enum_ids);
-    return 0;
+    return rc;
 }
 
-int ldap_correlate_attack_output(ADUser *users, int count, const char *attack, int json_output) {
-    StringList kerb_ids, admin_ids, enum_ids;
-    list_init(&kerb_ids);
-    list_init(&admin_ids);
-    list_init(&enum_ids);
-    struct json_object *counts = NULL;
-    struct json_object *recent = build_alerts(users, count, &counts, &kerb_ids, &admin_ids, &enum_ids);
-    char time_buf[32];
-    current_time_rfc3339(time_buf, sizeof(time_buf));
-
-    const char *latest_id = "";
-    struct json_object *correlations = NULL;
-    struct json_object *incidents = build_incidents(&kerb_ids, &admin_ids, time_buf, &latest_id, &correlations);
-
-    struct json_object *match = NULL;
-    size_t corr_count = json_object_array_length(correlations);
-    for (size_t i = 0; i < corr_count; i++) {
-        struct json_object *entry = json_object_array_get_idx(correlations, i);
-        if (!entry) continue;
-        struct json_object *attack_name = NULL;
-        if (json_object_object_get_ex(entry, "attack", &attack_name) &&
-            json_object_is_type(attack_name, json_type_string) &&
-            strcasecmp(json_object_get_string(attack_name), attack) == 0) {
-            match = entry;
-            break;
-        }
-    }
-
+static int correlate_attack_output(Insights *in, const char *attack, int json_output) {
+    const IncidentSpec *match = find_incident(in, NULL, attack);
     if (!match) {
         fprintf(stderr, "Attack '%s' not found in LDAP correlations.\n", attack);
-        json_object_put(recent);
-        json_object_put(counts);
-        json_object_put(incidents);
-        json_object_put(correlations);
-        list_free(&kerb_ids);
-        list_free(&admin_ids);
-        list_free(&enum_ids);
         return 1;
     }
 
+    int rc = 0;
     if (json_output) {
-        struct json_object *out = json_object_new_object();
         char summary[256];
         snprintf(summary, sizeof(summary), "Correlation ready for %s.", attack);
-        json_object_object_add(out, "summary", json_object_new_string(summary));
-        json_object_object_add(out, "data", json_object_get(match));
-        printf("%s\n", json_object_to_json_string_ext(out, JSON_C_TO_STRING_PRETTY));
-        json_object_put(out);
+        JsonWriter w;
+        begin_document(&w, summary);
+        json_writer_key(&w, "data");
+        write_correlation(&w, match);
+        rc = end_document(&w);
     } else {
-        struct json_object *incident_id = NULL;
-        struct json_object *confidence = NULL;
-        json_object_object_get_ex(match, "incident_id", &incident_id);
-        json_object_object_get_ex(match, "confidence", &confidence);
         printf("Correlation\n");
         printf("Summary: Correlation ready for %s.\n", attack);
-        printf("Incident: %s\n", incident_id ? json_object_get_string(incident_id) : "N/A");
-        printf("Confidence: %.2f\n", confidence ? json_object_get_double(confidence) : 0.0);
+        printf("Incident: %s\n", match->id);
+        printf("Confidence: %.2f\n", match->confidence);
     }
 
-    json_object_put(recent);
-    json_object_put(counts);
-    json_object_put(incidents);
-    json_object_put(correlations);
-    list_free(&kerb_ids);
-    list_free(&admin_ids);
-    list_free(&enum_ids);
-    return 0;
+    return rc;
 }
 
-int ldap_analyze_incident_output(ADUser *users, int count, const char *incident_id, int json_output) {
-    StringList kerb_ids, admin_ids, enum_ids;
-    list_init(&kerb_ids);
-    list_init(&admin_ids);
-    list_init(&enum_ids);
-    struct json_object *counts = NULL;
-    struct json_object *recent = build_alerts(users, count, &counts, &kerb_ids, &admin_ids, &enum_ids);
-    char time_buf[32];
-    current_time_rfc3339(time_buf, sizeof(time_buf));
-
-    const char *latest_id = "";
-    struct json_object *correlations = NULL;
-    struct json_object *incidents = build_incidents(&kerb_ids, &admin_ids, time_buf, &latest_id, &correlations);
+static int analyze_incident_output(Insights *in, const char *incident_id, int json_output) {
+    // Every incident the scan raised, one per line
+    if (json_output == OUTPUT_NDJSON && strcasecmp(incident_id, "all") == 0) {
+        JsonWriter w;
+        json_writer_init(&w, stdout, 0);
+        for (int i = 0; i < INCIDENT_SPECS; i++) {
+            if (in->kind_counts[incident_specs[i].kind] == 0) continue;
+            write_incident(&w, in, &incident_specs[i]);
+            json_writer_raw(&w, "\n", 1);
+        }
+        return finish_output(&w);
+    }
 
     const char *target = incident_id;
     if (strcasecmp(incident_id, "latest") == 0) {
-        target = latest_id;
+        target = in->latest_id;
     }
 
     if (!target || target[0] == '\0') {
         fprintf(stderr, "No incidents available for analysis.\n");
-        json_object_put(recent);
-        json_object_put(counts);
-        json_object_put(incidents);
-        json_object_put(correlations);
-        list_free(&kerb_ids);
-        list_free(&admin_ids);
-        list_free(&enum_ids);
         return 1;
     }
 
-    struct json_object *match = NULL;
-    size_t inc_count = json_object_array_length(incidents);
-    for (size_t i = 0; i < inc_count; i++) {
-        struct json_object *entry = json_object_array_get_idx(incidents, i);
-        if (!entry) continue;
-        struct json_object *id = NULL;
-        if (json_object_object_get_ex(entry, "id", &id) &&
-            json_object_is_type(id, json_type_string) &&
-            strcasecmp(json_object_get_string(id), target) == 0) {
-            match = entry;
-            break;
-        }
-    }
-
+    const IncidentSpec *match = find_incident(in, target, NULL);
     if (!match) {
         fprintf(stderr, "Incident '%s' not found.\n", target);
-        json_object_put(recent);
-        json_object_put(counts);
-        json_object_put(incidents);
-        json_object_put(correlations);
-        list_free(&kerb_ids);
-        list_free(&admin_ids);
-        list_free(&enum_ids);
         return 1;
     }
 
-    if (json_output) {
-        struct json_object *out = json_object_new_object();
+    int rc = 0;
+    if (json_output == OUTPUT_NDJSON) {
+        JsonWriter w;
+        json_writer_init(&w, stdout, 0);
+        write_incident(&w, in, match);
+        json_writer_raw(&w, "\n", 1);
+        rc = finish_output(&w);
+    } else if (json_output) {
         char summary[256];
         snprintf(summary, sizeof(summary), "Incident %s analyzed.", target);
-        json_object_object_add(out, "summary", json_object_new_string(summary));
-        json_object_object_add(out, "data", json_object_get(match));
-        printf("%s\n", json_object_to_json_string_ext(out, JSON_C_TO_STRING_PRETTY));
-        json_object_put(out);
+        JsonWriter w;
+        begin_document(&w, summary);
+        json_writer_key(&w, "data");
+        write_incident(&w, in, match);
+        rc = end_document(&w);
     } else {
-        struct json_object *title = NULL;
-        struct json_object *severity = NULL;
-        struct json_object *status = NULL;
-        json_object_object_get_ex(match, "title", &title);
-        json_object_object_get_ex(match, "severity", &severity);
-        json_object_object_get_ex(match, "status", &status);
         printf("Incident Analysis\n");
         printf("Summary: Incident %s analyzed.\n", target);
-        printf("Title: %s\n", title ? json_object_get_string(title) : "N/A");
-        printf("Severity: %s\n", severity ? json_object_get_string(severity) : "N/A");
-        printf("Status: %s\n", status ? json_object_get_string(status) : "N/A");
-    }
-
-    json_object_put(recent);
-    json_object_put(counts);
-    json_object_put(incidents);
-    json_object_put(correlations);
-    list_free(&kerb_ids);
-    list_free(&admin_ids);
-    list_free(&enum_ids);
-    return 0;
+        printf("Title: %s\n", match->title);
+        printf("Severity: %s\n", match->severity);
+        printf("Status: open\n");
+    }
+
+    return rc;
+}
+
+int ldap_status_output(ADUser *users, int count, int json_output) {
+    Insights in;
+    insights_build(&in, users, count);
+    int rc = status_output(&in, json_output);
+    insights_free(&in);
+    return rc;
+}
+
+int ldap_alerts_recent_output(ADUser *users, int count, int json_output) {
+    Insights in;
+    insights_build(&in, users, count);
+    int rc = alerts_recent_output(&in, json_output);
+    insights_free(&in);
+    return rc;
 }
 
-int ldap_metrics_output(ADUser *users, int count, double scan_seconds, const char *metric, int json_output) {
+int ldap_correlate_attack_output(ADUser *users, int count, const char *attack, int json_output) {
+    Insights in;
+    insights_build(&in, users, count);
+    int rc = correlate_attack_output(&in, attack, json_output);
+    insights_free(&in);
+    return rc;
+}
+
+int ldap_analyze_incident_output(ADUser *users, int count, const char *incident_id, int json_output) {
+    Insights in;
+    insights_build(&in, users, count);
+    int rc = analyze_incident_output(&in, incident_id, json_output);
+    insights_free(&in);
+    return rc;
+}
+
+int snapshot_status_output(const Snapshot *snap, int json_output) {
+    Insights in;
+    insights_from_snapshot(&in, snap);
+    int rc = status_output(&in, json_output);
+    insights_free(&in);
+    return rc;
+}
+
+int snapshot_alerts_recent_output(const Snapshot *snap, int json_output) {
+    Insights in;
+    insights_from_snapshot(&in, snap);
+    int rc = alerts_recent_output(&in, json_output);
+    insights_free(&in);
+    return rc;
+}
+
+int snapshot_correlate_attack_output(const Snapshot *snap, const char *attack, int json_output) {
+    Insights in;
+    insights_from_snapshot(&in, snap);
+    int rc = correlate_attack_output(&in, attack, json_output);
+    insights_free(&in);
+    return rc;
+}
+
+int snapshot_analyze_incident_output(const Snapshot *snap, const char *incident_id, int json_output) {
+    Insights in;
+    insights_from_snapshot(&in, snap);
+    int rc = analyze_incident_output(&in, incident_id, json_output);
+    insights_free(&in);
+    return rc;
+}
+
+int ldap_snapshot_save(const char *path, ADUser *users, int count) {
+    Insights in;
+    insights_build(&in, users, count);
+    UserStore store;
+    int rc = -1;
+    if (in.detections && user_store_build_ordered(&store, (const ADUser *const *)in.sorted, count, USER_STORE_ALL) == 0) {
+        rc = snapshot_write(path, &store, in.detections, in.time_buf);
+        user_store_free(&store);
+    } else {
+        log_error("Out of memory building snapshot: %s", path);
+    }
+    insights_free(&in);
+    return rc;
+}
+
+// Data object of one metric (throughput, accuracy or scale); NULL if unknown
+static struct json_object *metric_data(ADUser *users, int count, const ScanStats *stats, const char *metric) {
+    double scan_seconds = stats ? stats->total_seconds : 0.0;
     int classified = 0;
-    for (int i = 0; i < count; i++) {
-        if (users[i].risk > 0 || users[i].perms.isAdmin || users[i].perms.isPrivileged ||
-            users[i].perms.canResetPasswords || users[i].perms.canModifyACLs ||
-            users[i].perms.canDelegateAuth || users[i].perms.hasServiceAcct ||
-            users[i].perms.canReadSecrets || users[i].perms.canWriteSecrets) {
-            classified++;
+    UserStore store;
+    if (user_store_build(&store, users, count, 0) == 0) {
+        classified = user_store_count_classified(&store);
+        user_store_free(&store);
+    } else {
+        for (int i = 0; i < count; i++) {
+            if (users[i].risk > 0 || user_perm_bits(&users[i]) != 0) classified++;
         }
     }
-    struct json_object *root = json_object_new_object();
-
     double throughput = 0.0;
     if (scan_seconds > 0.0) {
         throughput = ((double)count / scan_seconds) * 60.0;
@@ -629,6 +724,18 @@ int ldap_metrics_output(ADUser *users, int count, double scan_seconds, const cha
         json_object_object_add(metric_obj, "unit", json_object_new_string("objects/min"));
         json_object_object_add(metric_obj, "window", json_object_new_string("scan"));
         json_object_object_add(metric_obj, "p95_ms", json_object_new_int((int)(scan_seconds * 1000.0)));
+        json_object_object_add(metric_obj, "first_result_ms", json_object_new_int(stats ? (int)(stats->first_result_seconds * 1000.0) : 0));
+        json_object_object_add(metric_obj, "wall_ms", json_object_new_int((int)(scan_seconds * 1000.0)));
+        json_object_object_add(metric_obj, "pages", json_object_new_int(stats ? stats->pages : 0));
+        long lookups = stats ? stats->group_cache_hits + stats->group_cache_misses : 0;
+        json_object_object_add(metric_obj, "group_cache_hits", json_object_new_int64(stats ? stats->group_cache_hits : 0));
+        json_object_object_add(metric_obj, "group_cache_misses", json_object_new_int64(stats ? stats->group_cache_misses : 0));
+        json_object_object_add(metric_obj, "group_cache_hit_rate",
+                               json_object_new_double(lookups > 0 ? (double)stats->group_cache_hits / (double)lookups : 0.0));
+        // Arena blocks replace one malloc each; only the chunks came from malloc
+        long avoided = stats ? stats->arena_allocations - stats->arena_chunks : 0;
+        json_object_object_add(metric_obj, "arena_bytes", json_object_new_int64(stats ? (int64_t)stats->arena_bytes : 0));
+        json_object_object_add(metric_obj, "arena_allocations_avoided", json_object_new_int64(avoided > 0 ? avoided : 0));
     } else if (strcmp(metric, "accuracy") == 0) {
         const char *acc_env = getenv("ACLGUARD_METRIC_ACCURACY");
         const char *prec_env = getenv("ACLGUARD_METRIC_PRECISION");
@@ -656,13 +763,44 @@ int ldap_metrics_output(ADUser *users, int count, double scan_seconds, const cha
         json_object_object_add(metric_obj, "domains", json_object_new_int(1));
         json_object_object_add(metric_obj, "domain_controllers", json_object_new_int(1));
         json_object_object_add(metric_obj, "users", json_object_new_int(count));
+        long descriptors = stats ? stats->security_descriptors : 0;
+        long unique = stats ? stats->unique_security_descriptors : 0;
+        json_object_object_add(metric_obj, "security_descriptors", json_object_new_int64(descriptors));
+        json_object_object_add(metric_obj, "unique_security_descriptors", json_object_new_int64(unique));
+        json_object_object_add(metric_obj, "malformed_security_descriptors",
+                               json_object_new_int64(stats ? stats->malformed_security_descriptors : 0));
+        json_object_object_add(metric_obj, "unique_sd_ratio",
+                               json_object_new_double(descriptors > 0 ? (double)unique / (double)descriptors : 0.0));
+        json_object_object_add(metric_obj, "sd_bytes", json_object_new_int64(stats ? (int64_t)stats->security_descriptor_bytes : 0));
+        json_object_object_add(metric_obj, "sd_bytes_saved",
+                               json_object_new_int64(stats ? (int64_t)stats->security_descriptor_bytes_saved : 0));
+        json_object_object_add(metric_obj, "group_nesting_edges", json_object_new_int64(stats ? stats->group_nesting_edges : 0));
+        json_object_object_add(metric_obj, "nested_groups", json_object_new_int(stats ? stats->nested_groups : 0));
+        json_object_object_add(metric_obj, "group_nesting_cycles", json_object_new_int(stats ? stats->group_nesting_cycles : 0));
+        json_object_object_add(metric_obj, "containers", json_object_new_int(stats ? stats->containers : 0));
+        json_object_object_add(metric_obj, "inheritable_aces", json_object_new_int64(stats ? stats->inheritable_aces : 0));
+        json_object_object_add(metric_obj, "inherit_chain_links", json_object_new_int(stats ? stats->inherit_chain_links : 0));
+        json_object_object_add(metric_obj, "inherit_chains_shared", json_object_new_int(stats ? stats->inherit_chains_shared : 0));
+        json_object_object_add(metric_obj, "users_inheriting", json_object_new_int(stats ? stats->users_inheriting : 0));
+        json_object_object_add(metric_obj, "sid_cache_hits", json_object_new_int64(stats ? stats->sid_cache_hits : 0));
+        json_object_object_add(metric_obj, "sid_cache_misses", json_object_new_int64(stats ? stats->sid_cache_misses : 0));
+        json_object_object_add(metric_obj, "sid_wellknown_hits", json_object_new_int64(stats ? stats->sid_wellknown_hits : 0));
+        json_object_object_add(metric_obj, "sid_lookup_batches", json_object_new_int64(stats ? stats->sid_lookup_batches : 0));
+        json_object_object_add(metric_obj, "sid_unresolved", json_object_new_int64(stats ? stats->sid_unresolved : 0));
+        json_object_object_add(metric_obj, "wellknown_hits", json_object_new_int64(stats ? stats->wellknown_hits : 0));
+        json_object_object_add(metric_obj, "wellknown_misses", json_object_new_int64(stats ? stats->wellknown_misses : 0));
     }
 
+    return metric_obj;
+}
+
+int ldap_metrics_output(ADUser *users, int count, const ScanStats *stats, const char *metric, int json_output) {
+    struct json_object *metric_obj = metric_data(users, count, stats, metric);
     if (!metric_obj) {
         fprintf(stderr, "Metric '%s' not available.\n", metric);
-        json_object_put(root);
         return 1;
     }
+    struct json_object *root = json_object_new_object();
 
     char summary[256];
     snprintf(summary, sizeof(summary), "LDAP metrics derived from scan (%d users).", count);
@@ -693,3 +831,496 @@ int ldap_metrics_output(ADUser *users, int count, double scan_seconds, const cha
     json_object_put(root);
     return 0;
 }
+
+int ldap_report_output(ADUser *users, int count, const ScanStats *stats, unsigned int sections, int json_output) {
+    Insights in;
+    insights_build(&in, users, count);
+
+    char summary[256];
+    snprintf(summary, sizeof(summary), "LDAP report from one scan (%d users). %d alerts, %d incidents, %d correlations.",
+             count, in.alert_count, in.incident_count, in.incident_count);
+
+    // JSON streams to stdout; the text layout is printed from the same
+    // document, collected in memory
+    JsonWriter w;
+    if (json_output) {
+        begin_document(&w, summary);
+    } else {
+        json_writer_init(&w, NULL, 0);
+        json_writer_begin_object(&w);
+        json_writer_key(&w, "summary");
+        json_writer_string(&w, summary);
+    }
+
+    json_writer_key(&w, "data");
+    json_writer_begin_object(&w);
+    if (sections & REPORT_STATUS) {
+        json_writer_key(&w, "status");
+        write_status_data(&w, &in);
+    }
+    if (sections & REPORT_ALERTS) {
+        json_writer_key(&w, "alerts");
+        write_alerts_data(&w, &in);
+    }
+    if (sections & REPORT_INCIDENTS) {
+        json_writer_key(&w, "latest_incident_id");
+        json_writer_string(&w, in.latest_id);
+        json_writer_key(&w, "incidents");
+        json_writer_begin_array(&w);
+        for (int i = 0; i < INCIDENT_SPECS; i++) {
+            if (in.kind_counts[incident_specs[i].kind] > 0) write_incident(&w, &in, &incident_specs[i]);
+        }
+        json_writer_end_array(&w);
+    }
+    if (sections & REPORT_CORRELATIONS) {
+        json_writer_key(&w, "correlations");
+        json_writer_begin_array(&w);
+        for (int i = 0; i < INCIDENT_SPECS; i++) {
+            if (in.kind_counts[incident_specs[i].kind] > 0) write_correlation(&w, &incident_specs[i]);
+        }
+        json_writer_end_array(&w);
+    }
+    if (sections & REPORT_METRICS) {
+        static const char *metrics[] = { "throughput", "accuracy", "scale" };
+        json_writer_key(&w, "metrics");
+        json_writer_begin_object(&w);
+        for (size_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++) {
+            struct json_object *metric = metric_data(users, count, stats, metrics[i]);
+            json_writer_key(&w, metrics[i]);
+            json_writer_json(&w, metric);
+            json_object_put(metric);
+        }
+        json_writer_end_object(&w);
+    }
+    json_writer_end_object(&w);
+
+    int rc;
+    if (json_output) {
+        rc = end_document(&w);
+    } else {
+        json_writer_end_object(&w);
+        char *text = NULL;
+        struct json_object *root = NULL;
+        if (json_writer_finish(&w, &text) == 0) root = json_tokener_parse(text);
+        free(text);
+        if (root) {
+            rc = report_print(root, 0);
+            json_object_put(root);
+        } else {
+            fprintf(stderr, "Memory allocation failed while building the report.\n");
+            rc = 1;
+        }
+    }
+    insights_free(&in);
+    return rc;
+}
+
+// Names of the PERM_* bits an ACE edge can carry, as used by rule packs
+static const struct {
+    unsigned int bit;
+    const char *name;
+} ace_right_names[] = {
+    { PERM_ADMIN, "admin" },
+    { PERM_RESET_PASSWORD, "reset_password" },
+    { PERM_MODIFY_ACL, "modify_acl" },
+    { PERM_DELEGATE_AUTH, "delegate_auth" },
+    { PERM_SERVICE_ACCT, "service_account" },
+    { PERM_PRIVILEGED, "privileged" },
+    { PERM_READ_SECRETS, "read_secrets" },
+    { PERM_WRITE_SECRETS, "write_secrets" },
+};
+
+// Nodes 0 .. count - 1 are the scanned users, count + ID the interned groups,
+// then the recorded containers and last one node standing for every user
+// (Everyone, Authenticated Users, Domain Users)
+static const char *path_node_name(const ADUser *users, int count, int node) {
+    if (node < count) return user_key(&users[node]);
+    int group_count = group_table_count();
+    if (node < count + group_count) {
+        const char *dn = group_table_name(node - count);
+        return dn ? dn : "N/A";
+    }
+    int container = node - count - group_count;
+    if (container < effective_rights_containers()) return effective_rights_container_dn(container);
+    return "(all users)";
+}
+
+typedef struct {
+    AttackGraph *graph;
+    int users;              // Nodes of the scanned users
+    int groups;             // Nodes of the groups, from node users
+    int containers;         // Nodes of the containers, from node users + groups
+    int all_users;          // Node every user is a member of
+    int all_users_used;     // Some grant names it
+} GraphBuild;
+
+// Node of an ACE trustee, -1 if it is not in the graph or is object itself
+static int trustee_node(GraphBuild *build, const char *sid, int object) {
+    Principal trustee;
+    if (!sid_resolver_lookup(sid, &trustee)) return -1;
+    if (trustee.kind == PRINCIPAL_USER && trustee.user_index >= 0) {
+        return trustee.user_index != object ? trustee.user_index : -1;
+    }
+    if (trustee.kind == PRINCIPAL_GROUP && trustee.name) {
+        int id = group_table_find(trustee.name, strlen(trustee.name));
+        return id >= 0 && id < build->groups ? build->users + id : -1;
+    }
+    if (trustee.kind == PRINCIPAL_ALL_USERS) {
+        build->all_users_used = 1;
+        return build->all_users;
+    }
+    return -1;
+}
+
+// One edge per grant over object from its trustee
+static int add_ace_edges(GraphBuild *build, int object, const AceGrant *grants, int grant_count) {
+    for (int g = 0; g < grant_count; g++) {
+        if (grants[g].perms == 0) continue;
+        int from = trustee_node(build, grants[g].trustee, object);
+        if (from >= 0 && attack_graph_add_edge(build->graph, from, object, grants[g].perms) != 0) return -1;
+    }
+    return 0;
+}
+
+// Control of a container (rewriting its DACL with an inheritable ACE, say)
+// reaches each object it directly holds, except one whose DACL is protected
+static int add_contains_edge(GraphBuild *build, int object, const char *dn, int is_protected) {
+    if (!dn || is_protected || build->containers == 0) return 0;
+    int parent = effective_rights_parent(dn, strlen(dn));
+    if (parent < 0) return 0;
+    return attack_graph_add_edge(build->graph, build->users + build->groups + parent, object, ATTACK_EDGE_CONTAINS);
+}
+
+// Membership edges (direct and group nesting), one edge per ACE grant from
+// its resolved trustee to the user, group or container carrying the
+// descriptor, and containment edges down the container tree
+static int build_attack_graph(ADUser *users, int count, AttackGraph *graph) {
+    GraphBuild build = {graph, count, group_table_count(), effective_rights_containers(), 0, 0};
+    build.all_users = count + build.groups + build.containers;
+    attack_graph_init(graph, build.all_users + 1);
+
+    for (int i = 0; i < count; i++) {
+        for (int g = 0; g < users[i].group_count; g++) {
+            if (attack_graph_add_edge(graph, i, count + users[i].group_ids[g], ATTACK_EDGE_MEMBER_OF) != 0) return -1;
+        }
+    }
+
+    const int *members = NULL;
+    const int *parents = NULL;
+    long nesting = group_graph_edges(&members, &parents);
+    for (long e = 0; e < nesting; e++) {
+        if (attack_graph_add_edge(graph, count + members[e], count + parents[e], ATTACK_EDGE_MEMBER_OF) != 0) return -1;
+    }
+
+    // Users were re-sorted after the scan; map their SIDs to the current order
+    if (sid_resolver_add_users(users, count) != 0) return -1;
+    for (int i = 0; i < count; i++) {
+        if (add_ace_edges(&build, i, users[i].acl_grants, users[i].acl_grant_count) != 0 ||
+            add_contains_edge(&build, i, users[i].dn, users[i].acl_protected) != 0) {
+            return -1;
+        }
+    }
+    for (int id = 0; id < build.groups; id++) {
+        const AceGrant *grants = NULL;
+        int grant_count = group_rights_get(id, &grants);
+        if (add_ace_edges(&build, count + id, grants, grant_count) != 0 ||
+            add_contains_edge(&build, count + id, group_table_name(id), group_rights_protected(id)) != 0) {
+            return -1;
+        }
+    }
+    for (int c = 0; c < build.containers; c++) {
+        const AceGrant *grants = NULL;
+        int grant_count = effective_rights_container_grants(c, &grants);
+        int node = count + build.groups + c;
+        if (add_ace_edges(&build, node, grants, grant_count) != 0 ||
+            add_contains_edge(&build, node, effective_rights_container_dn(c), effective_rights_container_protected(c)) != 0) {
+            return -1;
+        }
+    }
+
+    // Rights granted to Everyone and the like are held by every user
+    for (int i = 0; build.all_users_used && i < count; i++) {
+        if (attack_graph_add_edge(graph, i, build.all_users, ATTACK_EDGE_MEMBER_OF) != 0) return -1;
+    }
+    return attack_graph_finish(graph);
+}
+
+typedef struct {
+    int dist;
+    int user;
+} PathRank;
+
+static int path_rank_cmp(const void *a, const void *b) {
+    const PathRank *pa = a;
+    const PathRank *pb = b;
+    if (pa->dist != pb->dist) return pa->dist < pb->dist ? -1 : 1;
+    return (pa->user > pb->user) - (pa->user < pb->user);
+}
+
+int ldap_paths_output(ADUser *users, int count, int json_output) {
+    AttackGraph graph;
+    if (build_attack_graph(users, count, &graph) != 0) {
+        attack_graph_free(&graph);
+        fprintf(stderr, "Memory allocation failed while building the attack graph.\n");
+        return 1;
+    }
+
+    // Tier-0: every group the rules classify as administrative
+    int group_count = group_table_count();
+    int *targets = malloc((size_t)(group_count > 0 ? group_count : 1) * sizeof(int));
+    PathRank *ranks = malloc((size_t)(count > 0 ? count : 1) * sizeof(PathRank));
+    AttackPaths paths;
+    int target_count = 0;
+    for (int id = 0; targets && id < group_count; id++) {
+        GroupVerdict verdict;
+        classifier_lookup(id, &verdict);
+        if (verdict.perms & PERM_ADMIN) targets[target_count++] = count + id;
+    }
+    if (!targets || !ranks || attack_graph_paths(&graph, targets, target_count, &paths) != 0) {
+        free(targets);
+        free(ranks);
+        attack_graph_free(&graph);
+        fprintf(stderr, "Memory allocation failed while computing attack paths.\n");
+        return 1;
+    }
+
+    int reachable = 0;
+    for (int i = 0; i < count; i++) {
+        if (paths.dist[i] > 0) {
+            ranks[reachable].dist = paths.dist[i];
+            ranks[reachable].user = i;
+            reachable++;
+        }
+    }
+    qsort(ranks, (size_t)reachable, sizeof(PathRank), path_rank_cmp);
+
+    struct json_object *target_list = json_object_new_array();
+    for (int t = 0; t < target_count; t++) {
+        json_object_array_add(target_list, json_object_new_string(path_node_name(users, count, targets[t])));
+    }
+
+    struct json_object *path_list = json_object_new_array();
+    for (int r = 0; r < reachable; r++) {
+        int node = ranks[r].user;
+        struct json_object *steps = json_object_new_array();
+        for (; paths.next[node] >= 0; node = paths.next[node]) {
+            struct json_object *step = json_object_new_object();
+            json_object_object_add(step, "from", json_object_new_string(path_node_name(users, count, node)));
+            json_object_object_add(step, "to", json_object_new_string(path_node_name(users, count, paths.next[node])));
+            unsigned int label = paths.label[node];
+            const char *edge = label == ATTACK_EDGE_MEMBER_OF ? "member_of" : label == ATTACK_EDGE_CONTAINS ? "contains" : "ace";
+            json_object_object_add(step, "edge", json_object_new_string(edge));
+            if (label != ATTACK_EDGE_MEMBER_OF && label != ATTACK_EDGE_CONTAINS) {
+                struct json_object *rights = json_object_new_array();
+                for (size_t b = 0; b < sizeof(ace_right_names) / sizeof(ace_right_names[0]); b++) {
+                    if (label & ace_right_names[b].bit) {
+                        json_object_array_add(rights, json_object_new_string(ace_right_names[b].name));
+                    }
+                }
+                json_object_object_add(step, "rights", rights);
+            }
+            json_object_array_add(steps, step);
+        }
+
+        struct json_object *item = json_object_new_object();
+        json_object_object_add(item, "user", json_object_new_string(user_key(&users[ranks[r].user])));
+        json_object_object_add(item, "hops", json_object_new_int(ranks[r].dist));
+        json_object_object_add(item, "target", json_object_new_string(path_node_name(users, count, node)));
+        json_object_object_add(item, "path", steps);
+        json_object_array_add(path_list, item);
+    }
+
+    struct json_object *root = json_object_new_object();
+    char summary[256];
+    snprintf(summary, sizeof(summary), "%d of %d users can reach Tier-0 (%d target groups).",
+             reachable, count, target_count);
+    json_object_object_add(root, "summary", json_object_new_string(summary));
+
+    struct json_object *data = json_object_new_object();
+    json_object_object_add(data, "nodes", json_object_new_int(graph.node_count));
+    json_object_object_add(data, "edges", json_object_new_int64(graph.edge_count));
+    json_object_object_add(data, "targets", target_list);
+    json_object_object_add(data, "reachable_users", json_object_new_int(reachable));
+    json_object_object_add(data, "paths", path_list);
+    json_object_object_add(root, "data", data);
+
+    if (json_output) {
+        printf("%s\n", json_object_to_json_string_ext(root, JSON_C_TO_STRING_PRETTY));
+    } else {
+        printf("Attack Paths to Tier-0\n");
+        printf("Summary: %s\n", summary);
+        for (int t = 0; t < target_count; t++) {
+            printf("Target: %s\n", path_node_name(users, count, targets[t]));
+        }
+        for (int r = 0; r < reachable; r++) {
+            int node = ranks[r].user;
+            printf("- %s (%d hop%s): %s", user_key(&users[node]), ranks[r].dist, ranks[r].dist == 1 ? "" : "s",
+                   path_node_name(users, count, node));
+            for (; paths.next[node] >= 0; node = paths.next[node]) {
+                unsigned int label = paths.label[node];
+                if (label == ATTACK_EDGE_MEMBER_OF) {
+                    printf(" -[member_of]->");
+                } else if (label == ATTACK_EDGE_CONTAINS) {
+                    printf(" -[contains]->");
+                } else {
+                    printf(" -[ace:");
+                    int first = 1;
+                    for (size_t b = 0; b < sizeof(ace_right_names) / sizeof(ace_right_names[0]); b++) {
+                        if (!(label & ace_right_names[b].bit)) continue;
+                        printf("%s%s", first ? "" : ",", ace_right_names[b].name);
+                        first = 0;
+                    }
+                    printf("]->");
+                }
+                printf(" %s", path_node_name(users, count, paths.next[node]));
+            }
+            printf("\n");
+        }
+    }
+
+    json_object_put(root);
+    attack_paths_free(&paths);
+    attack_graph_free(&graph);
+    free(targets);
+    free(ranks);
+    return 0;
+}
+
+// Display name of an ACE trustee: the scanned user, the principal's DN or
+// well-known name, else the SID itself
+static const char *trustee_name(const ADUser *users, const char *sid) {
+    Principal trustee;
+    if (!sid_resolver_lookup(sid, &trustee)) return sid;
+    if (trustee.kind == PRINCIPAL_USER && trustee.user_index >= 0) return user_key(&users[trustee.user_index]);
+    return trustee.name ? trustee.name : sid;
+}
+
+static int container_dn_cmp(const void *a, const void *b) {
+    return strcasecmp(effective_rights_container_dn(*(const int *)a), effective_rights_container_dn(*(const int *)b));
+}
+
+static int group_dn_cmp(const void *a, const void *b) {
+    return strcasecmp(group_table_name(*(const int *)a), group_table_name(*(const int *)b));
+}
+
+typedef struct {
+    struct json_object *list;
+    const ADUser *users;
+    const char *principal;
+    int grants;
+    int inherited;
+    int objects;
+} RightsReport;
+
+// Add the grants over one object that match the principal filter
+static void report_object_rights(RightsReport *report, const char *object, const char *type,
+                                  const AceGrant *grants, int grant_count) {
+    int matched = 0;
+    for (int g = 0; g < grant_count; g++) {
+        const char *name = trustee_name(report->users, grants[g].trustee);
+        if (report->principal && strcasecmp(report->principal, name) != 0 &&
+            strcasecmp(report->principal, grants[g].trustee) != 0) {
+            continue;
+        }
+        struct json_object *rights = json_object_new_array();
+        for (size_t b = 0; b < sizeof(ace_right_names) / sizeof(ace_right_names[0]); b++) {
+            if (grants[g].perms & ace_right_names[b].bit) {
+                json_object_array_add(rights, json_object_new_string(ace_right_names[b].name));
+            }
+        }
+        struct json_object *item = json_object_new_object();
+        json_object_object_add(item, "object", json_object_new_string(object));
+        json_object_object_add(item, "type", json_object_new_string(type));
+        json_object_object_add(item, "trustee", json_object_new_string(name));
+        json_object_object_add(item, "sid", json_object_new_string(grants[g].trustee));
+        json_object_object_add(item, "rights", rights);
+        json_object_object_add(item, "inherited", json_object_new_boolean(grants[g].inherited ? 1 : 0));
+        json_object_array_add(report->list, item);
+        report->grants++;
+        if (grants[g].inherited) report->inherited++;
+        matched = 1;
+    }
+    report->objects += matched;
+}
+
+int ldap_rights_output(ADUser *users, int count, const char *principal, int json_output) {
+    // Users were re-sorted after the scan; map their SIDs to the current order
+    if (sid_resolver_add_users(users, count) != 0) {
+        fprintf(stderr, "Memory allocation failed while listing effective rights.\n");
+        return 1;
+    }
+
+    int containers = effective_rights_containers();
+    int groups = group_table_count();
+    int *order = malloc((size_t)(containers > groups ? containers : groups > 0 ? groups : 1) * sizeof(int));
+    if (!order) {
+        fprintf(stderr, "Memory allocation failed while listing effective rights.\n");
+        return 1;
+    }
+    for (int c = 0; c < containers; c++) order[c] = c;
+    qsort(order, (size_t)containers, sizeof(int), container_dn_cmp);
+
+    RightsReport report = {json_object_new_array(), users, principal, 0, 0, 0};
+    for (int c = 0; c < containers; c++) {
+        const AceGrant *grants = NULL;
+        int grant_count = effective_rights_container_grants(order[c], &grants);
+        report_object_rights(&report, effective_rights_container_dn(order[c]), "container", grants, grant_count);
+    }
+
+    // Groups carrying grants, by DN
+    int listed = 0;
+    for (int id = 0; id < groups; id++) {
+        const AceGrant *grants = NULL;
+        if (group_rights_get(id, &grants) > 0) order[listed++] = id;
+    }
+    qsort(order, (size_t)listed, sizeof(int), group_dn_cmp);
+    for (int k = 0; k < listed; k++) {
+        const AceGrant *grants = NULL;
+        int grant_count = group_rights_get(order[k], &grants);
+        report_object_rights(&report, group_table_name(order[k]), "group", grants, grant_count);
+    }
+
+    for (int i = 0; i < count; i++) {
+        report_object_rights(&report, user_key(&users[i]), "user", users[i].acl_grants, users[i].acl_grant_count);
+    }
+    free(order);
+
+    struct json_object *root = json_object_new_object();
+    char summary[512];
+    snprintf(summary, sizeof(summary), "%d grants over %d objects (%d containers read), %d inherited through the container tree%s%s.",
+             report.grants, report.objects, containers, report.inherited,
+             principal ? ", held by " : "", principal ? principal : "");
+    json_object_object_add(root, "summary", json_object_new_string(summary));
+
+    struct json_object *data = json_object_new_object();
+    json_object_object_add(data, "containers", json_object_new_int(containers));
+    json_object_object_add(data, "objects", json_object_new_int(report.objects));
+    json_object_object_add(data, "grants", json_object_new_int(report.grants));
+    json_object_object_add(data, "inherited", json_object_new_int(report.inherited));
+    json_object_object_add(data, "rights", report.list);
+    json_object_object_add(root, "data", data);
+
+    if (json_output) {
+        printf("%s\n", json_object_to_json_string_ext(root, JSON_C_TO_STRING_PRETTY));
+    } else {
+        printf("Effective Rights\n");
+        printf("Summary: %s\n", summary);
+        for (size_t r = 0; r < json_object_array_length(report.list); r++) {
+            struct json_object *item = json_object_array_get_idx(report.list, r);
+            struct json_object *field = NULL;
+            json_object_object_get_ex(item, "trustee", &field);
+            printf("- %s ->", json_object_get_string(field));
+            json_object_object_get_ex(item, "object", &field);
+            printf(" %s [", json_object_get_string(field));
+            json_object_object_get_ex(item, "rights", &field);
+            for (size_t b = 0; b < json_object_array_length(field); b++) {
+                printf("%s%s", b ? "," : "", json_object_get_string(json_object_array_get_idx(field, b)));
+            }
+            json_object_object_get_ex(item, "inherited", &field);
+            printf("]%s\n", json_object_get_boolean(field) ? " (inherited)" : "");
+        }
+    }
+
+    json_object_put(root);
+    return 0;
+}
@@ -2,11 +2,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
+#include <strings.h>
 #include "config.h"
 #include "aclguard_ldap.h"
+#include "classifier.h"
 #include "export.h"
+#include "group_table.h"
+#include "json_writer.h"
 #include "mock.h"
+#include "report.h"
+#include "snapshot.h"
+#include "thread_pool.h"
+#include "user_store.h"
 #include "ldap_insights.h"
 
 // Banner function
@@ -74,25 +81,48 @@ void display_user_permissions(ADUser *user) {
 static void print_usage(const char *prog) {
     printf("Usage:\n");
     printf("  %s status [--json]\n", prog);
-    printf("  %s alerts --recent [--json]\n", prog);
+    printf("  %s alerts --recent [--json|--ndjson]\n", prog);
     printf("  %s correlate --attack <name> [--json]\n", prog);
-    printf("  %s analyze --incident <latest|id> [--json]\n", prog);
+    printf("  %s analyze --incident <latest|id> [--json|--ndjson]\n", prog);
+    printf("  %s analyze --incident all --ndjson\n", prog);
     printf("  %s metrics --throughput|--accuracy|--scale [--json]\n", prog);
+    printf("  %s paths [--json]\n", prog);
+    printf("  %s rights [--principal <name|SID>] [--json]\n", prog);
+    printf("  %s report [--sections status,alerts,incidents,correlations,metrics] [--json]\n", prog);
+    printf("  (LDAP subcommands accept --delta to fetch only objects changed since the last delta run)\n");
+    printf("  (LDAP subcommands accept --rules <file> to classify groups with a site-specific rule pack)\n");
+    printf("  (LDAP subcommands accept --threads <n> to classify and run detectors on n threads)\n");
+    printf("  (LDAP subcommands accept --save-snapshot <file> to save the scan for later --snapshot runs)\n");
+    printf("  %s status|alerts|correlate|analyze ... --snapshot <file>  (read a saved scan, no LDAP)\n", prog);
     printf("  %s --mock status [--json]\n", prog);
-    printf("  %s --mock alerts --recent [--json]\n", prog);
+    printf("  %s --mock alerts --recent [--json|--ndjson]\n", prog);
     printf("  %s --mock correlate --attack <name> [--json]\n", prog);
-    printf("  %s --mock analyze --incident <latest|id> [--json]\n", prog);
+    printf("  %s --mock analyze --incident <latest|id|all> [--json|--ndjson]\n", prog);
     printf("  %s --mock metrics --throughput|--accuracy|--scale [--json]\n", prog);
+    printf("  %s --mock paths [--json]\n", prog);
+    printf("  %s --mock rights [--principal <name|SID>] [--json]\n", prog);
+    printf("  %s --mock report [--sections <list>] [--json]\n", prog);
     printf("\nLegacy (deprecated):\n");
-    printf("  %s [--export-csv [filename]] [--export-json [filename]]\n", prog);
+    printf("  %s [--export-csv [filename]] [--csv-group-rows] [--export-json [filename]] [--ndjson]\n", prog);
 }
 
-static int load_ldap_users(ADUser **users_out, int *count_out, double *scan_seconds_out) {
+static int load_ldap_users(ADUser **users_out, int *count_out, ScanStats *stats_out, int delta_scan, int threads,
+                           const char *save_snapshot) {
     Config config;
     if (load_env_config(&config) != 0) {
         fprintf(stderr, "Failed to load configuration from environment.\n");
         return 1;
     }
+    if (delta_scan) {
+        config.delta_scan = 1;
+    }
+    if (threads > 0) {
+        config.threads = threads;
+    }
+    if (save_snapshot) {
+        config.snapshot_file = (char *)save_snapshot;
+    }
+    thread_pool_init(config.threads);
 
     if (!config.ldap_uri || !config.bind_dn || !config.bind_pw || !config.base_dn ||
         strlen(config.ldap_uri) == 0 || strlen(config.bind_dn) == 0 ||
@@ -101,35 +131,32 @@ static int load_ldap_users(ADUser **users_out, int *count_out, double *scan_seco
         return 1;
     }
 
-    struct timespec start;
-    struct timespec end;
-    clock_gettime(CLOCK_MONOTONIC, &start);
-    ADUser *users = fetch_real_users(&config, count_out);
-    clock_gettime(CLOCK_MONOTONIC, &end);
+    ADUser *users = fetch_real_users(&config, count_out, stats_out);
 
     if (!users || *count_out == 0) {
         fprintf(stderr, "LDAP connection failed or no users fetched.\n");
         return 1;
     }
 
-    if (scan_seconds_out) {
-        double seconds = (double)(end.tv_sec - start.tv_sec);
-        seconds += (double)(end.tv_nsec - start.tv_nsec) / 1e9;
-        if (seconds < 0.0) seconds = 0.0;
-        *scan_seconds_out = seconds;
+    if (config.snapshot_file && config.snapshot_file[0] != '\0' &&
+        ldap_snapshot_save(config.snapshot_file, users, *count_out) != 0) {
+        release_real_users(users);
+        return 1;
     }
 
     *users_out = users;
     return 0;
 }
 
-static int handle_legacy(int argc, char *argv[]) {
+static int handle_legacy(int argc, char *argv[], int threads) {
     print_banner();
 
     int export_csv = 0;
     int export_json = 0;
+    int ndjson = 0;
+    int csv_group_rows = 0;
     char *csv_filename = "aclguard_users.csv";
-    char *json_filename = "aclguard_users.json";
+    char *json_filename = NULL;
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--export-csv") == 0) {
@@ -142,11 +169,18 @@ static int handle_legacy(int argc, char *argv[]) {
             if (i + 1 < argc && argv[i + 1][0] != '-') {
                 json_filename = argv[++i];
             }
+        } else if (strcmp(argv[i], "--ndjson") == 0) {
+            ndjson = 1;
+        } else if (strcmp(argv[i], "--csv-group-rows") == 0) {
+            csv_group_rows = 1;
         } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
             print_usage(argv[0]);
             return 0;
         }
     }
+    if (!json_filename) {
+        json_filename = ndjson ? "aclguard_users.ndjson" : "aclguard_users.json";
+    }
 
     if (export_csv || export_json) {
         fprintf(stderr, "[WARN] Legacy export flags are deprecated and will be removed in a future release.\n");
@@ -157,6 +191,10 @@ static int handle_legacy(int argc, char *argv[]) {
         fprintf(stderr, "Failed to load configuration from environment.\n");
         return 1;
     }
+    if (threads > 0) {
+        config.threads = threads;
+    }
+    thread_pool_init(config.threads);
 
     if (!config.ldap_uri || !config.bind_dn || !config.bind_pw || !config.base_dn ||
         strlen(config.ldap_uri) == 0 || strlen(config.bind_dn) == 0 ||
@@ -166,7 +204,7 @@ static int handle_legacy(int argc, char *argv[]) {
     }
 
     int user_count = 0;
-    ADUser *users = fetch_real_users(&config, &user_count);
+    ADUser *users = fetch_real_users(&config, &user_count, NULL);
 
     if (!users || user_count == 0) {
         fprintf(stderr, "LDAP connection failed or no users fetched.\n");
@@ -186,8 +224,10 @@ static int handle_legacy(int argc, char *argv[]) {
             printf("Email: %s\n", users[i].mail);
         }
 
-        if (users[i].memberOf) {
-            printf("Groups: %s\n", users[i].memberOf);
+        if (users[i].group_count > 0) {
+            printf("Groups: ");
+            group_table_write(stdout, users[i].group_ids, users[i].group_count, ",");
+            printf("\n");
         }
 
         display_user_permissions(&users[i]);
@@ -195,14 +235,23 @@ static int handle_legacy(int argc, char *argv[]) {
         printf("\n");
     }
 
+    // Summary counts are reductions over the packed permission/risk columns
     int high_risk_count = 0;
     int admin_count = 0;
     int privileged_count = 0;
 
-    for (int i = 0; i < user_count; i++) {
-        if (users[i].risk >= 60) high_risk_count++;
-        if (users[i].perms.isAdmin) admin_count++;
-        if (users[i].perms.isPrivileged) privileged_count++;
+    UserStore store;
+    if (user_store_build(&store, users, user_count, 0) == 0) {
+        high_risk_count = user_store_count_risk_at_least(&store, 60);
+        admin_count = user_store_count_any(&store, PERM_ADMIN);
+        privileged_count = user_store_count_any(&store, PERM_PRIVILEGED);
+        user_store_free(&store);
+    } else {
+        for (int i = 0; i < user_count; i++) {
+            if (users[i].risk >= 60) high_risk_count++;
+            if (users[i].perms.isAdmin) admin_count++;
+            if (users[i].perms.isPrivileged) privileged_count++;
+        }
     }
 
     printf("═══════════════════════════════════════════════════════════════════════════════════\n");
@@ -214,15 +263,19 @@ static int handle_legacy(int argc, char *argv[]) {
     printf("Privileged Users: %d\n", privileged_count);
     printf("═══════════════════════════════════════════════════════════════════════════════════\n");
 
-    if (export_csv) {
+    if (export_csv && csv_group_rows) {
+        export_to_csv_group_rows(csv_filename, users, user_count);
+    } else if (export_csv) {
         export_to_csv(csv_filename, users, user_count);
     }
 
-    if (export_json) {
+    if (export_json && ndjson) {
+        export_to_ndjson(json_filename, users, user_count);
+    } else if (export_json) {
         export_to_json(json_filename, users, user_count);
     }
 
-    free(users);
+    release_real_users(users);
     return 0;
 }
 
@@ -230,12 +283,46 @@ int main(int argc, char *argv[]) {
     int mock_mode = 0;
     int json_output = 0;
     int show_help = 0;
+    int delta_scan = 0;
+    const char *rules_path = NULL;
+    int threads = 0;
+    const char *snapshot_path = NULL;
+    const char *save_snapshot = NULL;
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--mock") == 0) {
             mock_mode = 1;
+        } else if (strcmp(argv[i], "--delta") == 0) {
+            delta_scan = 1;
+        } else if (strcmp(argv[i], "--rules") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "--rules requires a file.\n");
+                return 1;
+            }
+            rules_path = argv[++i];
+        } else if (strcmp(argv[i], "--snapshot") == 0 || strcmp(argv[i], "--save-snapshot") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "%s requires a file.\n", argv[i]);
+                return 1;
+            }
+            if (strcmp(argv[i], "--snapshot") == 0) {
+                snapshot_path = argv[++i];
+            } else {
+                save_snapshot = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            char *end = NULL;
+            long parsed = i + 1 < argc ? strtol(argv[i + 1], &end, 10) : 0;
+            if (i + 1 >= argc || !end || *end != '\0' || parsed < 1 || parsed > 1024) {
+                fprintf(stderr, "--threads requires a thread count between 1 and 1024.\n");
+                return 1;
+            }
+            threads = (int)parsed;
+            i++;
         } else if (strcmp(argv[i], "--json") == 0) {
-            json_output = 1;
+            if (json_output != OUTPUT_NDJSON) json_output = OUTPUT_JSON;
+        } else if (strcmp(argv[i], "--ndjson") == 0) {
+            json_output = OUTPUT_NDJSON;
         } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
             show_help = 1;
         }
@@ -243,6 +330,11 @@ int main(int argc, char *argv[]) {
 
     int subcmd_index = -1;
     for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rules") == 0 || strcmp(argv[i], "--threads") == 0 ||
+            strcmp(argv[i], "--snapshot") == 0 || strcmp(argv[i], "--save-snapshot") == 0) {
+            i++; // Skip the option value
+            continue;
+        }
         if (argv[i][0] != '-') {
             subcmd_index = i;
             break;
@@ -254,10 +346,15 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
+    if (rules_path && classifier_load_rules(rules_path) != 0) {
+        fprintf(stderr, "Failed to load rule pack: %s\n", rules_path);
+        return 1;
+    }
+
     if (subcmd_index == -1) {
         for (int i = 1; i < argc; i++) {
             if (strcmp(argv[i], "--export-csv") == 0 || strcmp(argv[i], "--export-json") == 0) {
-                return handle_legacy(argc, argv);
+                return handle_legacy(argc, argv, threads);
             }
         }
         print_usage(argv[0]);
@@ -266,16 +363,43 @@ int main(int argc, char *argv[]) {
 
     const char *subcmd = argv[subcmd_index];
 
+    // Record streams exist for alerts and incidents; the other subcommands
+    // print one summary document
+    if (json_output == OUTPUT_NDJSON && strcmp(subcmd, "alerts") != 0 && strcmp(subcmd, "analyze") != 0) {
+        fprintf(stderr, "--ndjson is supported by alerts, analyze and --export-json.\n");
+        return 1;
+    }
+
+    // A saved scan stands in for LDAP; it holds what the alert subcommands read
+    Snapshot snapshot;
+    if (snapshot_path) {
+        if (mock_mode || delta_scan || save_snapshot) {
+            fprintf(stderr, "--snapshot cannot be combined with --mock, --delta or --save-snapshot.\n");
+            return 1;
+        }
+        if (strcmp(subcmd, "status") != 0 && strcmp(subcmd, "alerts") != 0 && strcmp(subcmd, "correlate") != 0 &&
+            strcmp(subcmd, "analyze") != 0) {
+            fprintf(stderr, "--snapshot is supported by status, alerts, correlate and analyze.\n");
+            return 1;
+        }
+        if (snapshot_open(snapshot_path, &snapshot) != 0) return 1;
+    }
+
     if (strcmp(subcmd, "status") == 0) {
         if (mock_mode) {
             return mock_status(json_output);
         }
+        if (snapshot_path) {
+            int rc = snapshot_status_output(&snapshot, json_output);
+            snapshot_close(&snapshot);
+            return rc;
+        }
         ADUser *users = NULL;
         int count = 0;
-        double scan_seconds = 0.0;
-        if (load_ldap_users(&users, &count, &scan_seconds) != 0) return 1;
+        ScanStats stats;
+        if (load_ldap_users(&users, &count, &stats, delta_scan, threads, save_snapshot) != 0) return 1;
         int rc = ldap_status_output(users, count, json_output);
-        free(users);
+        release_real_users(users);
         return rc;
     }
 
@@ -291,12 +415,17 @@ int main(int argc, char *argv[]) {
             return 1;
         }
         if (mock_mode) return mock_alerts_recent(json_output);
+        if (snapshot_path) {
+            int rc = snapshot_alerts_recent_output(&snapshot, json_output);
+            snapshot_close(&snapshot);
+            return rc;
+        }
         ADUser *users = NULL;
         int count = 0;
-        double scan_seconds = 0.0;
-        if (load_ldap_users(&users, &count, &scan_seconds) != 0) return 1;
+        ScanStats stats;
+        if (load_ldap_users(&users, &count, &stats, delta_scan, threads, save_snapshot) != 0) return 1;
         int rc = ldap_alerts_recent_output(users, count, json_output);
-        free(users);
+        release_real_users(users);
         return rc;
     }
 
@@ -317,12 +446,17 @@ int main(int argc, char *argv[]) {
             return 1;
         }
         if (mock_mode) return mock_correlate_attack(attack, json_output);
+        if (snapshot_path) {
+            int rc = snapshot_correlate_attack_output(&snapshot, attack, json_output);
+            snapshot_close(&snapshot);
+            return rc;
+        }
         ADUser *users = NULL;
         int count = 0;
-        double scan_seconds = 0.0;
-        if (load_ldap_users(&users, &count, &scan_seconds) != 0) return 1;
+        ScanStats stats;
+        if (load_ldap_users(&users, &count, &stats, delta_scan, threads, save_snapshot) != 0) return 1;
         int rc = ldap_correlate_attack_output(users, count, attack, json_output);
-        free(users);
+        release_real_users(users);
         return rc;
     }
 
@@ -342,13 +476,22 @@ int main(int argc, char *argv[]) {
             fprintf(stderr, "analyze requires --incident <latest|id>.\n");
             return 1;
         }
+        if (strcasecmp(incident, "all") == 0 && json_output != OUTPUT_NDJSON) {
+            fprintf(stderr, "--incident all requires --ndjson.\n");
+            return 1;
+        }
         if (mock_mode) return mock_analyze_incident(incident, json_output);
+        if (snapshot_path) {
+            int rc = snapshot_analyze_incident_output(&snapshot, incident, json_output);
+            snapshot_close(&snapshot);
+            return rc;
+        }
         ADUser *users = NULL;
         int count = 0;
-        double scan_seconds = 0.0;
-        if (load_ldap_users(&users, &count, &scan_seconds) != 0) return 1;
+        ScanStats stats;
+        if (load_ldap_users(&users, &count, &stats, delta_scan, threads, save_snapshot) != 0) return 1;
         int rc = ldap_analyze_incident_output(users, count, incident, json_output);
-        free(users);
+        release_real_users(users);
         return rc;
     }
 
@@ -370,10 +513,65 @@ int main(int argc, char *argv[]) {
         if (mock_mode) return mock_metrics(metric, json_output);
         ADUser *users = NULL;
         int count = 0;
-        double scan_seconds = 0.0;
-        if (load_ldap_users(&users, &count, &scan_seconds) != 0) return 1;
-        int rc = ldap_metrics_output(users, count, scan_seconds, metric, json_output);
-        free(users);
+        ScanStats stats;
+        if (load_ldap_users(&users, &count, &stats, delta_scan, threads, save_snapshot) != 0) return 1;
+        int rc = ldap_metrics_output(users, count, &stats, metric, json_output);
+        release_real_users(users);
+        return rc;
+    }
+
+    if (strcmp(subcmd, "paths") == 0) {
+        if (mock_mode) return mock_paths(json_output);
+        ADUser *users = NULL;
+        int count = 0;
+        ScanStats stats;
+        if (load_ldap_users(&users, &count, &stats, delta_scan, threads, save_snapshot) != 0) return 1;
+        int rc = ldap_paths_output(users, count, json_output);
+        release_real_users(users);
+        return rc;
+    }
+
+    if (strcmp(subcmd, "rights") == 0) {
+        const char *principal = NULL;
+        for (int i = subcmd_index + 1; i < argc; i++) {
+            if (strcmp(argv[i], "--principal") == 0) {
+                if (i + 1 >= argc) {
+                    fprintf(stderr, "--principal requires a name or SID.\n");
+                    return 1;
+                }
+                principal = argv[i + 1];
+                break;
+            }
+        }
+        if (mock_mode) return mock_rights(principal, json_output);
+        ADUser *users = NULL;
+        int count = 0;
+        ScanStats stats;
+        if (load_ldap_users(&users, &count, &stats, delta_scan, threads, save_snapshot) != 0) return 1;
+        int rc = ldap_rights_output(users, count, principal, json_output);
+        release_real_users(users);
+        return rc;
+    }
+
+    if (strcmp(subcmd, "report") == 0) {
+        unsigned int sections = REPORT_ALL;
+        for (int i = subcmd_index + 1; i < argc; i++) {
+            if (strcmp(argv[i], "--sections") == 0) {
+                if (i + 1 >= argc) {
+                    fprintf(stderr, "--sections requires a comma-separated list.\n");
+                    return 1;
+                }
+                if (report_parse_sections(argv[i + 1], &sections) != 0) return 1;
+                break;
+            }
+        }
+        if (mock_mode) return mock_report(sections, json_output);
+        ADUser *users = NULL;
+        int count = 0;
+        ScanStats stats;
+        if (load_ldap_users(&users, &count, &stats, delta_scan, threads, save_snapshot) != 0) return 1;
+        int rc = ldap_report_output(users, count, &stats, sections, json_output);
+        release_real_users(users);
         return rc;
     }
 
@@ -5,7 +5,9 @@
 #include <string.h>
 #include <strings.h>
 #include <json-c/json.h>
+#include "json_writer.h"
 #include "mock.h"
+#include "report.h"
 
 static struct json_object *load_fixture(const char *filename) {
     char path[PATH_MAX];
@@ -24,6 +26,12 @@ static int output_json(struct json_object *obj) {
     return 0;
 }
 
+// One compact line per record
+static int output_record(struct json_object *obj) {
+    printf("%s\n", json_object_to_json_string_ext(obj, JSON_C_TO_STRING_PLAIN));
+    return 0;
+}
+
 static const char *get_string_field(struct json_object *obj, const char *key, const char *fallback) {
     struct json_object *val = NULL;
     if (json_object_object_get_ex(obj, key, &val) && json_object_is_type(val, json_type_string)) {
@@ -88,6 +96,18 @@ int mock_alerts_recent(int json_output) {
     struct json_object *root = load_fixture("alerts.json");
     if (!root) return 1;
 
+    if (json_output == OUTPUT_NDJSON) {
+        struct json_object *data = get_object_field(root, "data");
+        struct json_object *recent = data ? get_array_field(data, "recent") : NULL;
+        size_t count = recent ? json_object_array_length(recent) : 0;
+        for (size_t i = 0; i < count; i++) {
+            struct json_object *item = json_object_array_get_idx(recent, i);
+            if (item) output_record(item);
+        }
+        json_object_put(root);
+        return 0;
+    }
+
     if (json_output) {
         int rc = output_json(root);
         json_object_put(root);
@@ -202,6 +222,16 @@ int mock_analyze_incident(const char *incident_id, int json_output) {
         return 1;
     }
 
+    if (json_output == OUTPUT_NDJSON && strcasecmp(incident_id, "all") == 0) {
+        size_t count = json_object_array_length(incidents);
+        for (size_t i = 0; i < count; i++) {
+            struct json_object *entry = json_object_array_get_idx(incidents, i);
+            if (entry) output_record(entry);
+        }
+        json_object_put(root);
+        return 0;
+    }
+
     const char *target_id = incident_id;
     if (strcasecmp(incident_id, "latest") == 0) {
         target_id = get_string_field(root, "latest_incident_id", "");
@@ -230,6 +260,12 @@ int mock_analyze_incident(const char *incident_id, int json_output) {
         return 1;
     }
 
+    if (json_output == OUTPUT_NDJSON) {
+        int rc = output_record(match);
+        json_object_put(root);
+        return rc;
+    }
+
     if (json_output) {
         struct json_object *out = json_object_new_object();
         char summary[256];
@@ -322,3 +358,149 @@ int mock_metrics(const char *metric, int json_output) {
     json_object_put(root);
     return 0;
 }
+
+int mock_paths(int json_output) {
+    struct json_object *root = load_fixture("paths.json");
+    if (!root) return 1;
+
+    if (json_output) {
+        int rc = output_json(root);
+        json_object_put(root);
+        return rc;
+    }
+
+    struct json_object *data = get_object_field(root, "data");
+    printf("Attack Paths to Tier-0\n");
+    printf("Summary: %s\n", get_string_field(root, "summary", "Mock attack paths ready."));
+    if (data) {
+        struct json_object *targets = get_array_field(data, "targets");
+        for (size_t t = 0; targets && t < json_object_array_length(targets); t++) {
+            printf("Target: %s\n", json_object_get_string(json_object_array_get_idx(targets, t)));
+        }
+        struct json_object *paths = get_array_field(data, "paths");
+        for (size_t i = 0; paths && i < json_object_array_length(paths); i++) {
+            struct json_object *item = json_object_array_get_idx(paths, i);
+            struct json_object *hops = NULL;
+            json_object_object_get_ex(item, "hops", &hops);
+            int hop_count = hops ? json_object_get_int(hops) : 0;
+            const char *user = get_string_field(item, "user", "N/A");
+            printf("- %s (%d hop%s): %s", user, hop_count, hop_count == 1 ? "" : "s", user);
+
+            struct json_object *steps = get_array_field(item, "path");
+            for (size_t s = 0; steps && s < json_object_array_length(steps); s++) {
+                struct json_object *step = json_object_array_get_idx(steps, s);
+                const char *edge = get_string_field(step, "edge", "member_of");
+                struct json_object *rights = get_array_field(step, "rights");
+                if (rights) {
+                    printf(" -[%s:", edge);
+                    for (size_t r = 0; r < json_object_array_length(rights); r++) {
+                        printf("%s%s", r ? "," : "", json_object_get_string(json_object_array_get_idx(rights, r)));
+                    }
+                    printf("]->");
+                } else {
+                    printf(" -[%s]->", edge);
+                }
+                printf(" %s", get_string_field(step, "to", "N/A"));
+            }
+            printf("\n");
+        }
+    }
+
+    json_object_put(root);
+    return 0;
+}
+
+int mock_rights(const char *principal, int json_output) {
+    struct json_object *root = load_fixture("rights.json");
+    if (!root) return 1;
+
+    // Keep only the grants held by the principal, matched by name or SID
+    struct json_object *data = get_object_field(root, "data");
+    struct json_object *rights = data ? get_array_field(data, "rights") : NULL;
+    if (principal && rights) {
+        struct json_object *held = json_object_new_array();
+        for (size_t i = 0; i < json_object_array_length(rights); i++) {
+            struct json_object *item = json_object_array_get_idx(rights, i);
+            if (strcasecmp(get_string_field(item, "trustee", ""), principal) == 0 ||
+                strcasecmp(get_string_field(item, "sid", ""), principal) == 0) {
+                json_object_array_add(held, json_object_get(item));
+            }
+        }
+        json_object_object_add(data, "rights", held);
+        rights = held;
+    }
+
+    if (json_output) {
+        int rc = output_json(root);
+        json_object_put(root);
+        return rc;
+    }
+
+    printf("Effective Rights\n");
+    printf("Summary: %s\n", get_string_field(root, "summary", "Mock effective rights ready."));
+    for (size_t i = 0; rights && i < json_object_array_length(rights); i++) {
+        struct json_object *item = json_object_array_get_idx(rights, i);
+        printf("- %s -> %s [", get_string_field(item, "trustee", "N/A"), get_string_field(item, "object", "N/A"));
+        struct json_object *names = get_array_field(item, "rights");
+        for (size_t r = 0; names && r < json_object_array_length(names); r++) {
+            printf("%s%s", r ? "," : "", json_object_get_string(json_object_array_get_idx(names, r)));
+        }
+        struct json_object *inherited = NULL;
+        json_object_object_get_ex(item, "inherited", &inherited);
+        printf("]%s\n", inherited && json_object_get_boolean(inherited) ? " (inherited)" : "");
+    }
+
+    json_object_put(root);
+    return 0;
+}
+
+int mock_report(unsigned int sections, int json_output) {
+    struct json_object *status = load_fixture("status.json");
+    struct json_object *alerts = load_fixture("alerts.json");
+    struct json_object *incidents = load_fixture("incidents.json");
+    struct json_object *metrics = load_fixture("metrics.json");
+    int rc = 1;
+    if (!status || !alerts || !incidents || !metrics) goto done;
+
+    // The sections are the data objects of the per-subcommand fixtures
+    struct json_object *alerts_data = get_object_field(alerts, "data");
+    struct json_object *incidents_data = get_object_field(incidents, "data");
+    struct json_object *recent = alerts_data ? get_array_field(alerts_data, "recent") : NULL;
+    struct json_object *open = incidents_data ? get_array_field(incidents_data, "incidents") : NULL;
+    struct json_object *correlations = incidents_data ? get_array_field(incidents_data, "correlations") : NULL;
+    if (!recent || !open || !correlations) {
+        fprintf(stderr, "Mock report data missing.\n");
+        goto done;
+    }
+
+    struct json_object *data = json_object_new_object();
+    if (sections & REPORT_STATUS) {
+        json_object_object_add(data, "status", json_object_get(get_object_field(status, "data")));
+    }
+    if (sections & REPORT_ALERTS) json_object_object_add(data, "alerts", json_object_get(alerts_data));
+    if (sections & REPORT_INCIDENTS) {
+        json_object_object_add(data, "latest_incident_id",
+                               json_object_new_string(get_string_field(incidents, "latest_incident_id", "")));
+        json_object_object_add(data, "incidents", json_object_get(open));
+    }
+    if (sections & REPORT_CORRELATIONS) json_object_object_add(data, "correlations", json_object_get(correlations));
+    if (sections & REPORT_METRICS) {
+        json_object_object_add(data, "metrics", json_object_get(get_object_field(metrics, "data")));
+    }
+
+    struct json_object *root = json_object_new_object();
+    char summary[256];
+    snprintf(summary, sizeof(summary), "Mock report. %zu alerts, %zu incidents, %zu correlations.",
+             json_object_array_length(recent), json_object_array_length(open), json_object_array_length(correlations));
+    json_object_object_add(root, "summary", json_object_new_string(summary));
+    json_object_object_add(root, "data", data);
+    rc = report_print(root, json_output);
+    json_object_put(root);
+
+done:
+    json_object_put(status);
+    json_object_put(alerts);
+    json_object_put(incidents);
+    json_object_put(metrics);
+    return rc;
+}
@@ -0,0 +1,209 @@
+#include "pattern_matcher.h"
+#include "ci_search.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ALPHABET 256
+
+struct PatternMatcher {
+    // Patterns
+    char **patterns;
+    size_t *lengths;
+    unsigned int *flags;
+    int *next_at_node;   // Next pattern ending at the same node, -1 terminated
+    int pattern_count;
+    int pattern_cap;
+
+    // Automaton: delta[node * ALPHABET + folded byte] -> node
+    int *delta;
+    int *fail;
+    int *first_pattern; // First pattern ending at the node, -1 if none
+    int *output_link;   // Nearest proper suffix node that ends a pattern, -1 if none
+    int node_count;
+    int node_cap;
+    int compiled;
+};
+
+static int new_node(PatternMatcher *m) {
+    if (m->node_count + 1 > m->node_cap) {
+        int new_cap = m->node_cap == 0 ? 64 : m->node_cap * 2;
+        int *delta = realloc(m->delta, (size_t)new_cap * ALPHABET * sizeof(int));
+        if (!delta) return -1;
+        m->delta = delta;
+        int *fail = realloc(m->fail, (size_t)new_cap * sizeof(int));
+        if (!fail) return -1;
+        m->fail = fail;
+        int *first = realloc(m->first_pattern, (size_t)new_cap * sizeof(int));
+        if (!first) return -1;
+        m->first_pattern = first;
+        int *out = realloc(m->output_link, (size_t)new_cap * sizeof(int));
+        if (!out) return -1;
+        m->output_link = out;
+        m->node_cap = new_cap;
+    }
+    int node = m->node_count++;
+    for (int c = 0; c < ALPHABET; c++) {
+        m->delta[(size_t)node * ALPHABET + c] = -1;
+    }
+    m->fail[node] = 0;
+    m->first_pattern[node] = -1;
+    m->output_link[node] = -1;
+    return node;
+}
+
+PatternMatcher *pattern_matcher_new(void) {
+    PatternMatcher *m = calloc(1, sizeof(PatternMatcher));
+    if (!m) return NULL;
+    if (new_node(m) != 0) {
+        pattern_matcher_free(m);
+        return NULL;
+    }
+    return m;
+}
+
+void pattern_matcher_free(PatternMatcher *m) {
+    if (!m) return;
+    for (int i = 0; i < m->pattern_count; i++) {
+        free(m->patterns[i]);
+    }
+    free(m->patterns);
+    free(m->lengths);
+    free(m->flags);
+    free(m->next_at_node);
+    free(m->delta);
+    free(m->fail);
+    free(m->first_pattern);
+    free(m->output_link);
+    free(m);
+}
+
+int pattern_matcher_add(PatternMatcher *m, const char *pattern, unsigned int flags) {
+    if (!m || m->compiled || !pattern || pattern[0] == '\0') return -1;
+    size_t len = strlen(pattern);
+
+    for (int i = 0; i < m->pattern_count; i++) {
+        if (m->flags[i] == flags && m->lengths[i] == len && memcmp(m->patterns[i], pattern, len) == 0) {
+            return i;
+        }
+    }
+
+    if (m->pattern_count + 1 > m->pattern_cap) {
+        int new_cap = m->pattern_cap == 0 ? 32 : m->pattern_cap * 2;
+        char **patterns = realloc(m->patterns, (size_t)new_cap * sizeof(char *));
+        if (!patterns) return -1;
+        m->patterns = patterns;
+        size_t *lengths = realloc(m->lengths, (size_t)new_cap * sizeof(size_t));
+        if (!lengths) return -1;
+        m->lengths = lengths;
+        unsigned int *pflags = realloc(m->flags, (size_t)new_cap * sizeof(unsigned int));
+        if (!pflags) return -1;
+        m->flags = pflags;
+        int *next = realloc(m->next_at_node, (size_t)new_cap * sizeof(int));
+        if (!next) return -1;
+        m->next_at_node = next;
+        m->pattern_cap = new_cap;
+    }
+
+    // Walk/extend the trie on folded bytes; case-sensitive patterns are verified on hit
+    int node = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = ci_fold_table[(unsigned char)pattern[i]];
+        int next = m->delta[(size_t)node * ALPHABET + c];
+        if (next < 0) {
+            next = new_node(m);
+            if (next < 0) return -1;
+            m->delta[(size_t)node * ALPHABET + c] = next;
+        }
+        node = next;
+    }
+
+    char *copy = strdup(pattern);
+    if (!copy) return -1;
+
+    int id = m->pattern_count++;
+    m->patterns[id] = copy;
+    m->lengths[id] = len;
+    m->flags[id] = flags;
+    m->next_at_node[id] = m->first_pattern[node];
+    m->first_pattern[node] = id;
+    return id;
+}
+
+int pattern_matcher_compile(PatternMatcher *m) {
+    if (!m) return -1;
+    if (m->compiled) return 0;
+
+    int *queue = malloc((size_t)m->node_count * sizeof(int));
+    if (!queue) return -1;
+    int head = 0;
+    int tail = 0;
+
+    // Depth-1 nodes fail to the root; missing root edges loop back to the root
+    for (int c = 0; c < ALPHABET; c++) {
+        int child = m->delta[c];
+        if (child < 0) {
+            m->delta[c] = 0;
+        } else {
+            m->fail[child] = 0;
+            queue[tail++] = child;
+        }
+    }
+
+    // Breadth-first: fill failure links, output links and the full DFA table
+    while (head < tail) {
+        int node = queue[head++];
+        int fail = m->fail[node];
+        m->output_link[node] = m->first_pattern[fail] >= 0 ? fail : m->output_link[fail];
+
+        for (int c = 0; c < ALPHABET; c++) {
+            size_t edge = (size_t)node * ALPHABET + c;
+            int child = m->delta[edge];
+            if (child < 0) {
+                m->delta[edge] = m->delta[(size_t)fail * ALPHABET + c];
+            } else {
+                m->fail[child] = m->delta[(size_t)fail * ALPHABET + c];
+                queue[tail++] = child;
+            }
+        }
+    }
+
+    free(queue);
+    m->compiled = 1;
+    return 0;
+}
+
+int pattern_matcher_count(const PatternMatcher *m) {
+    return m ? m->pattern_count : 0;
+}
+
+size_t pattern_matcher_words(const PatternMatcher *m) {
+    int count = pattern_matcher_count(m);
+    return count > 0 ? ((size_t)count + 63) / 64 : 1;
+}
+
+static void report_node(const PatternMatcher *m, int node, const char *text, size_t end, uint64_t *hits) {
+    for (int id = m->first_pattern[node]; id >= 0; id = m->next_at_node[id]) {
+        if (hits[id >> 6] & (1ULL << (id & 63))) continue;
+        if (!(m->flags[id] & PATTERN_NOCASE) &&
+            memcmp(text + end + 1 - m->lengths[id], m->patterns[id], m->lengths[id]) != 0) {
+            continue;
+        }
+        hits[id >> 6] |= 1ULL << (id & 63);
+    }
+}
+
+void pattern_matcher_scan(const PatternMatcher *m, const char *text, size_t len, uint64_t *hits) {
+    memset(hits, 0, pattern_matcher_words(m) * sizeof(uint64_t));
+    if (!m || !m->compiled || !text) return;
+
+    const int *delta = m->delta;
+    int state = 0;
+    for (size_t i = 0; i < len; i++) {
+        state = delta[(size_t)state * ALPHABET + ci_fold_table[(unsigned char)text[i]]];
+        int node = m->first_pattern[state] >= 0 ? state : m->output_link[state];
+        while (node > 0) {
+            report_node(m, node, text, i, hits);
+            node = m->output_link[node];
+        }
+    }
+}
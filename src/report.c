@@ -0,0 +1,138 @@
+#include "report.h"
+#include <json-c/json.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+static const struct {
+    const char *name;
+    unsigned int bit;
+} section_names[] = {
+    { "status", REPORT_STATUS },
+    { "alerts", REPORT_ALERTS },
+    { "incidents", REPORT_INCIDENTS },
+    { "correlations", REPORT_CORRELATIONS },
+    { "metrics", REPORT_METRICS },
+};
+
+int report_parse_sections(const char *list, unsigned int *sections) {
+    *sections = 0;
+    const char *p = list;
+    while (*p) {
+        size_t len = strcspn(p, ",");
+        int found = 0;
+        for (size_t i = 0; i < sizeof(section_names) / sizeof(section_names[0]); i++) {
+            if (strlen(section_names[i].name) == len && strncasecmp(p, section_names[i].name, len) == 0) {
+                *sections |= section_names[i].bit;
+                found = 1;
+                break;
+            }
+        }
+        if (!found && len > 0) {
+            fprintf(stderr, "Unknown report section '%.*s' (expected status, alerts, incidents, correlations, metrics).\n",
+                    (int)len, p);
+            return -1;
+        }
+        p += len;
+        if (*p == ',') p++;
+    }
+    if (*sections == 0) {
+        fprintf(stderr, "--sections requires at least one section.\n");
+        return -1;
+    }
+    return 0;
+}
+
+static const char *field_string(struct json_object *obj, const char *key) {
+    struct json_object *val = NULL;
+    if (obj && json_object_object_get_ex(obj, key, &val) && json_object_is_type(val, json_type_string)) {
+        return json_object_get_string(val);
+    }
+    return "N/A";
+}
+
+static struct json_object *field(struct json_object *obj, const char *key, enum json_type type) {
+    struct json_object *val = NULL;
+    if (obj && json_object_object_get_ex(obj, key, &val) && json_object_is_type(val, type)) return val;
+    return NULL;
+}
+
+static void print_fields(struct json_object *obj) {
+    json_object_object_foreach(obj, key, val) {
+        if (json_object_is_type(val, json_type_string)) {
+            printf("%s: %s\n", key, json_object_get_string(val));
+        } else if (json_object_is_type(val, json_type_double)) {
+            printf("%s: %.2f\n", key, json_object_get_double(val));
+        } else if (json_object_is_type(val, json_type_int)) {
+            printf("%s: %lld\n", key, (long long)json_object_get_int64(val));
+        } else if (json_object_is_type(val, json_type_boolean)) {
+            printf("%s: %s\n", key, json_object_get_boolean(val) ? "true" : "false");
+        }
+    }
+}
+
+static void print_text(struct json_object *report) {
+    struct json_object *data = field(report, "data", json_type_object);
+    printf("Report\n");
+    printf("Summary: %s\n", field_string(report, "summary"));
+
+    struct json_object *status = field(data, "status", json_type_object);
+    if (status) {
+        printf("\nStatus\n");
+        print_fields(status);
+    }
+
+    struct json_object *alerts = field(data, "alerts", json_type_object);
+    if (alerts) {
+        struct json_object *recent = field(alerts, "recent", json_type_array);
+        size_t count = recent ? json_object_array_length(recent) : 0;
+        printf("\nRecent Alerts\n");
+        printf("Count: %zu\n", count);
+        for (size_t i = 0; i < count; i++) {
+            struct json_object *item = json_object_array_get_idx(recent, i);
+            printf("- %s [%s] %s (%s) user=%s\n", field_string(item, "id"), field_string(item, "severity"),
+                   field_string(item, "type"), field_string(item, "time"), field_string(item, "user"));
+        }
+    }
+
+    struct json_object *incidents = field(data, "incidents", json_type_array);
+    if (incidents) {
+        printf("\nIncidents\n");
+        if (field(data, "latest_incident_id", json_type_string)) {
+            printf("Latest: %s\n", field_string(data, "latest_incident_id"));
+        }
+        for (size_t i = 0; i < json_object_array_length(incidents); i++) {
+            struct json_object *item = json_object_array_get_idx(incidents, i);
+            printf("- %s [%s] %s (%s)\n", field_string(item, "id"), field_string(item, "severity"),
+                   field_string(item, "title"), field_string(item, "status"));
+        }
+    }
+
+    struct json_object *correlations = field(data, "correlations", json_type_array);
+    if (correlations) {
+        printf("\nCorrelations\n");
+        for (size_t i = 0; i < json_object_array_length(correlations); i++) {
+            struct json_object *item = json_object_array_get_idx(correlations, i);
+            struct json_object *confidence = field(item, "confidence", json_type_double);
+            printf("- %s -> %s (confidence %.2f)\n", field_string(item, "attack"), field_string(item, "incident_id"),
+                   confidence ? json_object_get_double(confidence) : 0.0);
+        }
+    }
+
+    struct json_object *metrics = field(data, "metrics", json_type_object);
+    if (metrics) {
+        json_object_object_foreach(metrics, metric, values) {
+            printf("\nMetric: %s\n", metric);
+            if (json_object_is_type(values, json_type_object)) print_fields(values);
+        }
+    }
+}
+
+int report_print(struct json_object *report, int json_output) {
+    if (json_output) {
+        printf("%s\n", json_object_to_json_string_ext(report, JSON_C_TO_STRING_PRETTY));
+    } else {
+        print_text(report);
+    }
+    return 0;
+}
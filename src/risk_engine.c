@@ -1,8 +1,191 @@
 #include "risk_engine.h"
-#include <stdio.h>
+#include "ci_search.h"
+#include "classifier.h"
+#include "error_handler.h"
+#include "group_graph.h"
+#include "thread_pool.h"
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
 
-int evaluate_risk(const char *username) {
-    // Placeholder: real risk logic will go here
-    printf("[INFO] Risk engine evaluated user: %s\n", username);
-    return 0; // 0 = low risk
-}
\ No newline at end of file
+void risk_model_default(RiskModel *model) {
+    model->group_weight = 1.0;
+    model->service_name_weight = 0;
+    model->group_volume_threshold = 10;
+    model->group_volume_weight = 0;
+    model->acl_rights_weight = 25;
+    model->cap = 100;
+}
+
+static void env_int(const char *name, int *value) {
+    const char *text = getenv(name);
+    if (!text || text[0] == '\0') return;
+    char *end = NULL;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if (errno != 0 || *end != '\0' || parsed < 0 || parsed > INT_MAX) {
+        log_error("Ignoring invalid %s=%s", name, text);
+        return;
+    }
+    *value = (int)parsed;
+}
+
+static void env_double(const char *name, double *value) {
+    const char *text = getenv(name);
+    if (!text || text[0] == '\0') return;
+    char *end = NULL;
+    errno = 0;
+    double parsed = strtod(text, &end);
+    if (errno != 0 || *end != '\0' || parsed < 0.0) {
+        log_error("Ignoring invalid %s=%s", name, text);
+        return;
+    }
+    *value = parsed;
+}
+
+static RiskModel active_model;
+static pthread_once_t active_once = PTHREAD_ONCE_INIT;
+
+static void init_active_model(void) {
+    risk_model_default(&active_model);
+    env_double("ACLGUARD_RISK_GROUP_WEIGHT", &active_model.group_weight);
+    env_int("ACLGUARD_RISK_SERVICE_NAME_WEIGHT", &active_model.service_name_weight);
+    env_int("ACLGUARD_RISK_GROUP_VOLUME_THRESHOLD", &active_model.group_volume_threshold);
+    env_int("ACLGUARD_RISK_GROUP_VOLUME_WEIGHT", &active_model.group_volume_weight);
+    env_int("ACLGUARD_RISK_ACL_RIGHTS_WEIGHT", &active_model.acl_rights_weight);
+    env_int("ACLGUARD_RISK_CAP", &active_model.cap);
+}
+
+const RiskModel *risk_model_active(void) {
+    pthread_once(&active_once, init_active_model);
+    return &active_model;
+}
+
+unsigned int risk_user_factors(const ADUser *user, const RiskModel *model) {
+    unsigned int factors = 0;
+    if (user->username &&
+        (ci_starts_with(user->username, "svc") || ci_contains(user->username, "service"))) {
+        factors |= RISK_FACTOR_SERVICE_NAME;
+    }
+    if (user->group_count >= model->group_volume_threshold) {
+        factors |= RISK_FACTOR_GROUP_VOLUME;
+    }
+    if (user->acl_perms) {
+        factors |= RISK_FACTOR_ACL_RIGHTS;
+    }
+    return factors;
+}
+
+// Combine the OR/sum of a user's group verdicts with the other weighted factors
+static void finish_user(ADUser *user, const RiskModel *model, unsigned int perms, int group_risk) {
+    apply_perm_bits(user, perms | user->acl_perms);
+
+    double score = (double)group_risk * model->group_weight;
+    unsigned int factors = risk_user_factors(user, model);
+    if (factors & RISK_FACTOR_SERVICE_NAME) score += model->service_name_weight;
+    if (factors & RISK_FACTOR_GROUP_VOLUME) score += model->group_volume_weight;
+    if (factors & RISK_FACTOR_ACL_RIGHTS) score += model->acl_rights_weight;
+
+    int risk = (int)(score + 0.5);
+    user->risk = risk > model->cap ? model->cap : risk;
+}
+
+int risk_score_user(ADUser *user, const RiskModel *model) {
+    GroupGraphScratch scratch;
+    if (group_graph_scratch_init(&scratch) != 0) return -1;
+
+    unsigned int perms = 0;
+    int risk = 0;
+    for (int g = 0; g < user->group_count; g++) {
+        GroupVerdict verdict;
+        classifier_lookup(user->group_ids[g], &verdict);
+        perms |= verdict.perms;
+        risk += verdict.risk;
+    }
+
+    // Groups reached through nesting count like direct memberships
+    int nested = group_graph_nested(user->group_ids, user->group_count, &scratch);
+    for (int k = 0; k < nested; k++) {
+        GroupVerdict verdict;
+        classifier_lookup(scratch.groups[k], &verdict);
+        perms |= verdict.perms;
+        risk += verdict.risk;
+    }
+    group_graph_scratch_free(&scratch);
+    finish_user(user, model ? model : risk_model_active(), perms, risk);
+    return 0;
+}
+
+typedef struct {
+    ADUser *users;
+    const RiskModel *model;
+    const GroupVerdict *verdicts;
+    int verdict_count;
+    long memberships;
+    int failed;                // Set when a chunk could not allocate its scratch
+} BatchContext;
+
+static void score_range(void *arg, int begin, int end) {
+    BatchContext *batch = arg;
+    long memberships = 0;
+    // One scratch per chunk for the groups reached through nesting
+    GroupGraphScratch scratch;
+    if (group_graph_scratch_init(&scratch) != 0) {
+        __atomic_store_n(&batch->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    for (int i = begin; i < end; i++) {
+        ADUser *user = &batch->users[i];
+        unsigned int perms = 0;
+        int risk = 0;
+        for (int g = 0; g < user->group_count; g++) {
+            int id = user->group_ids[g];
+            if (id < 0 || id >= batch->verdict_count) continue;
+            perms |= batch->verdicts[id].perms;
+            risk += batch->verdicts[id].risk;
+        }
+        memberships += user->group_count;
+
+        int nested = group_graph_nested(user->group_ids, user->group_count, &scratch);
+        memberships += nested;
+        for (int k = 0; k < nested; k++) {
+            int id = scratch.groups[k];
+            if (id < 0 || id >= batch->verdict_count) continue;
+            perms |= batch->verdicts[id].perms;
+            risk += batch->verdicts[id].risk;
+        }
+        finish_user(user, batch->model, perms, risk);
+    }
+    group_graph_scratch_free(&scratch);
+    __atomic_fetch_add(&batch->memberships, memberships, __ATOMIC_RELAXED);
+}
+
+int risk_score_batch(ADUser *users, int count, const RiskModel *model) {
+    if (count <= 0) return 0;
+    if (!model) model = risk_model_active();
+
+    long misses_before = 0;
+    long misses_after = 0;
+    classifier_cache_stats(NULL, &misses_before);
+    int verdict_count = 0;
+    GroupVerdict *verdicts = classifier_verdict_table(&verdict_count);
+    if (!verdicts) return -1;
+    classifier_cache_stats(NULL, &misses_after);
+
+    // Each user is written by exactly one chunk, so the result does not depend
+    // on how chunks are spread over the pool
+    BatchContext batch = {users, model, verdicts, verdict_count, 0, 0};
+    parallel_for(count, PARALLEL_CHUNK, score_range, &batch);
+    if (batch.failed) {
+        free(verdicts);
+        return -1;
+    }
+
+    // Memberships of groups classified just now were misses, the rest hits
+    long hits = batch.memberships - (misses_after - misses_before);
+    classifier_record_hits(hits > 0 ? hits : 0);
+    free(verdicts);
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include "rule_pack.h"
+#include "classifier.h"
+#include "error_handler.h"
+#include "pattern_matcher.h"
+#include <json-c/json.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define RULE_PACK_VERSION 1
+
+static const struct {
+    const char *name;
+    unsigned int bit;
+} perm_names[] = {
+    { "admin", PERM_ADMIN },
+    { "reset_password", PERM_RESET_PASSWORD },
+    { "modify_acl", PERM_MODIFY_ACL },
+    { "delegate_auth", PERM_DELEGATE_AUTH },
+    { "service_account", PERM_SERVICE_ACCT },
+    { "privileged", PERM_PRIVILEGED },
+    { "read_secrets", PERM_READ_SECRETS },
+    { "write_secrets", PERM_WRITE_SECRETS },
+};
+
+static int parse_perm(const char *name, unsigned int *bit) {
+    for (size_t i = 0; i < sizeof(perm_names) / sizeof(perm_names[0]); i++) {
+        if (strcasecmp(name, perm_names[i].name) == 0) {
+            *bit = perm_names[i].bit;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int parse_match(const char *mode, unsigned int *flags) {
+    if (strcmp(mode, "contains") == 0) {
+        *flags = 0;
+    } else if (strcmp(mode, "contains_ci") == 0) {
+        *flags = PATTERN_NOCASE;
+    } else if (strcmp(mode, "cn") == 0) {
+        *flags = RULE_MATCH_CN;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Copy a string array field; a missing field yields an empty list
+static int parse_patterns(struct json_object *rule, const char *key, const char ***out, int *count_out) {
+    struct json_object *list = NULL;
+    *out = NULL;
+    *count_out = 0;
+    if (!json_object_object_get_ex(rule, key, &list)) return 0;
+    if (!json_object_is_type(list, json_type_array)) return -1;
+
+    size_t n = json_object_array_length(list);
+    if (n == 0) return 0;
+    *out = calloc(n, sizeof(char *));
+    if (!*out) return -1;
+    for (size_t i = 0; i < n; i++) {
+        struct json_object *item = json_object_array_get_idx(list, i);
+        if (!json_object_is_type(item, json_type_string) || json_object_get_string_len(item) == 0) {
+            return -1;
+        }
+        char *copy = strdup(json_object_get_string(item));
+        if (!copy) return -1;
+        (*out)[(*count_out)++] = copy;
+    }
+    return 0;
+}
+
+static int parse_rule(struct json_object *item, RuleSpec *rule, const char *path, size_t index) {
+    struct json_object *val = NULL;
+
+    if (!json_object_is_type(item, json_type_object)) {
+        log_error("%s: rule %zu is not an object", path, index);
+        return -1;
+    }
+
+    if (json_object_object_get_ex(item, "name", &val) && json_object_is_type(val, json_type_string)) {
+        rule->name = strdup(json_object_get_string(val));
+    } else {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "rule-%zu", index);
+        rule->name = strdup(buf);
+    }
+    if (!rule->name) return -1;
+
+    rule->match_flags = 0;
+    if (json_object_object_get_ex(item, "match", &val)) {
+        if (!json_object_is_type(val, json_type_string) ||
+            parse_match(json_object_get_string(val), &rule->match_flags) != 0) {
+            log_error("%s: rule '%s' has unknown match mode (expected contains, contains_ci or cn)", path, rule->name);
+            return -1;
+        }
+    }
+
+    if (parse_patterns(item, "any", &rule->any_of, &rule->any_count) != 0 ||
+        parse_patterns(item, "all", &rule->all_of, &rule->all_count) != 0) {
+        log_error("%s: rule '%s' patterns must be arrays of non-empty strings", path, rule->name);
+        return -1;
+    }
+    if (rule->any_count == 0 && rule->all_count == 0) {
+        log_error("%s: rule '%s' has no patterns", path, rule->name);
+        return -1;
+    }
+
+    rule->perms = 0;
+    if (json_object_object_get_ex(item, "flags", &val)) {
+        if (!json_object_is_type(val, json_type_array)) {
+            log_error("%s: rule '%s' flags must be an array", path, rule->name);
+            return -1;
+        }
+        for (size_t i = 0; i < json_object_array_length(val); i++) {
+            struct json_object *flag = json_object_array_get_idx(val, i);
+            unsigned int bit = 0;
+            if (!json_object_is_type(flag, json_type_string) ||
+                parse_perm(json_object_get_string(flag), &bit) != 0) {
+                log_error("%s: rule '%s' has unknown flag '%s'", path, rule->name,
+                          json_object_get_string(flag));
+                return -1;
+            }
+            rule->perms |= bit;
+        }
+    }
+
+    rule->risk = 0;
+    if (json_object_object_get_ex(item, "risk", &val)) {
+        if (!json_object_is_type(val, json_type_int) || json_object_get_int(val) < 0) {
+            log_error("%s: rule '%s' risk must be a non-negative integer", path, rule->name);
+            return -1;
+        }
+        rule->risk = json_object_get_int(val);
+    }
+    return 0;
+}
+
+int rule_pack_load(const char *path, RulePack *pack) {
+    memset(pack, 0, sizeof(*pack));
+
+    struct json_object *root = json_object_from_file(path);
+    if (!root) {
+        log_error("Failed to read rule pack: %s", path);
+        return -1;
+    }
+
+    struct json_object *version = NULL;
+    struct json_object *rules = NULL;
+    if (!json_object_object_get_ex(root, "version", &version) ||
+        json_object_get_int(version) != RULE_PACK_VERSION ||
+        !json_object_object_get_ex(root, "rules", &rules) ||
+        !json_object_is_type(rules, json_type_array)) {
+        log_error("%s: expected {\"version\": %d, \"rules\": [...]}", path, RULE_PACK_VERSION);
+        json_object_put(root);
+        return -1;
+    }
+
+    size_t count = json_object_array_length(rules);
+    pack->rules = calloc(count > 0 ? count : 1, sizeof(RuleSpec));
+    if (!pack->rules) {
+        json_object_put(root);
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        RuleSpec *rule = &pack->rules[pack->count++];
+        if (parse_rule(json_object_array_get_idx(rules, i), rule, path, i) != 0) {
+            json_object_put(root);
+            rule_pack_free(pack);
+            return -1;
+        }
+    }
+
+    json_object_put(root);
+    return 0;
+}
+
+static void free_patterns(const char **patterns, int count) {
+    for (int i = 0; i < count; i++) {
+        free((char *)patterns[i]);
+    }
+    free(patterns);
+}
+
+void rule_pack_free(RulePack *pack) {
+    for (int i = 0; i < pack->count; i++) {
+        RuleSpec *rule = &pack->rules[i];
+        free((char *)rule->name);
+        free_patterns(rule->any_of, rule->any_count);
+        free_patterns(rule->all_of, rule->all_count);
+    }
+    free(pack->rules);
+    pack->rules = NULL;
+    pack->count = 0;
+}
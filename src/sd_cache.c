@@ -0,0 +1,177 @@
+#include "sd_cache.h"
+#include "arena.h"
+#include "security_descriptor.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint64_t hash;
+    const uint8_t *data;   // Copy of the descriptor, kept for the byte compare
+    size_t len;
+    AceGrant *grants;      // Evaluated once, shared by every object
+    int grant_count;       // SD_MALFORMED for a malformed descriptor
+    int protected_dacl;    // SE_DACL_PROTECTED: parent ACEs are not inherited
+    size_t grant_bytes;    // Grant array plus trustee strings
+} SdEntry;
+
+typedef struct {
+    SdEntry *entries;
+    int count;
+    int cap;
+    int *slots;            // Open-addressing index: entry + 1, 0 = empty
+    size_t slot_cap;       // Power of two
+    Arena arena;           // Descriptor copies and grants
+    SdCacheStats stats;
+} SdCache;
+
+static SdCache cache;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t mix_word(uint64_t w) {
+    w *= 0x87c37b91114253d5ULL;
+    w = rotl64(w, 31);
+    return w * 0x4cf5ad432745937fULL;
+}
+
+// 64-bit fingerprint over 8-byte words (MurmurHash3-style mixing)
+static uint64_t hash_descriptor(const uint8_t *p, size_t len) {
+    uint64_t hash = 0x9e3779b97f4a7c15ULL ^ (len * 0xff51afd7ed558ccdULL);
+    while (len >= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        hash ^= mix_word(w);
+        hash = rotl64(hash, 27) * 5 + 0x52dce729;
+        p += 8;
+        len -= 8;
+    }
+    if (len > 0) {
+        uint64_t w = 0;
+        memcpy(&w, p, len);
+        hash ^= mix_word(w);
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    return hash ^ (hash >> 33);
+}
+
+static int grow_slots(void) {
+    size_t new_cap = cache.slot_cap == 0 ? 1024 : cache.slot_cap * 2;
+    int *slots = calloc(new_cap, sizeof(int));
+    if (!slots) return -1;
+    for (int i = 0; i < cache.count; i++) {
+        size_t pos = cache.entries[i].hash & (new_cap - 1);
+        while (slots[pos] != 0) pos = (pos + 1) & (new_cap - 1);
+        slots[pos] = i + 1;
+    }
+    free(cache.slots);
+    cache.slots = slots;
+    cache.slot_cap = new_cap;
+    return 0;
+}
+
+// Parse and evaluate a new descriptor into the entry at slot pos. Returns
+// NULL, leaving the table unchanged, if memory ran out.
+static SdEntry *insert_entry(size_t pos, uint64_t hash, const uint8_t *data, size_t len) {
+    if (cache.count == cache.cap) {
+        int new_cap = cache.cap == 0 ? 256 : cache.cap * 2;
+        SdEntry *entries = realloc(cache.entries, (size_t)new_cap * sizeof(SdEntry));
+        if (!entries) return NULL;
+        cache.entries = entries;
+        cache.cap = new_cap;
+    }
+
+    uint8_t *copy = arena_alloc(&cache.arena, len);
+    if (!copy) return NULL;
+    memcpy(copy, data, len);
+
+    AceGrant *grants = NULL;
+    int grant_count = sd_collect_grants(copy, len, &cache.arena, &grants);
+    if (grant_count == SD_NO_MEMORY) return NULL;
+    // Header only; the flag is shared like the grants
+    SecurityDescriptor sd;
+    int protected_dacl = sd_parse(copy, len, &sd) == 0 && sd.protected_dacl;
+
+    SdEntry *entry = &cache.entries[cache.count];
+    entry->hash = hash;
+    entry->data = copy;
+    entry->len = len;
+    entry->grants = grants;
+    entry->grant_count = grant_count;
+    entry->protected_dacl = protected_dacl;
+    entry->grant_bytes = 0;
+    for (int g = 0; g < entry->grant_count; g++) {
+        entry->grant_bytes += sizeof(AceGrant) + strlen(entry->grants[g].trustee) + 1;
+    }
+
+    cache.slots[pos] = ++cache.count;
+    cache.stats.unique++;
+    cache.stats.unique_bytes += len;
+    return entry;
+}
+
+int sd_cache_intern(const void *data, size_t len, AceGrant **grants_out, int *protected_out) {
+    uint64_t hash = hash_descriptor(data, len);
+    SdEntry *entry = NULL;
+
+    *grants_out = NULL;
+    *protected_out = 0;
+    pthread_mutex_lock(&cache_lock);
+    if (cache.slot_cap == 0) {
+        arena_init(&cache.arena);
+    }
+
+    // Keep the load factor under one half
+    if ((size_t)(cache.count + 1) * 2 > cache.slot_cap && grow_slots() != 0) {
+        pthread_mutex_unlock(&cache_lock);
+        return SD_NO_MEMORY;
+    }
+
+    size_t pos = hash & (cache.slot_cap - 1);
+    while (cache.slots[pos] != 0) {
+        SdEntry *candidate = &cache.entries[cache.slots[pos] - 1];
+        if (candidate->hash == hash && candidate->len == len && memcmp(candidate->data, data, len) == 0) {
+            entry = candidate;
+            cache.stats.bytes_saved += len + entry->grant_bytes;
+            break;
+        }
+        pos = (pos + 1) & (cache.slot_cap - 1);
+    }
+    if (!entry) {
+        entry = insert_entry(pos, hash, data, len);
+    }
+
+    int grant_count = SD_NO_MEMORY;
+    if (entry) {
+        cache.stats.lookups++;
+        cache.stats.bytes += len;
+        if (entry->grant_count == SD_MALFORMED) cache.stats.malformed++;
+        *grants_out = entry->grants;
+        *protected_out = entry->protected_dacl;
+        grant_count = entry->grant_count;
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return grant_count;
+}
+
+void sd_cache_stats(SdCacheStats *stats) {
+    pthread_mutex_lock(&cache_lock);
+    *stats = cache.stats;
+    pthread_mutex_unlock(&cache_lock);
+}
+
+void sd_cache_reset(void) {
+    pthread_mutex_lock(&cache_lock);
+    free(cache.entries);
+    free(cache.slots);
+    arena_destroy(&cache.arena);
+    memset(&cache, 0, sizeof(cache));
+    pthread_mutex_unlock(&cache_lock);
+}
@@ -0,0 +1,405 @@
+#include "security_descriptor.h"
+#include "classifier.h"
+#include "effective_rights.h"
+#include "group_graph.h"
+#include "group_rights.h"
+#include "group_table.h"
+#include "sid_resolver.h"
+#include "wellknown.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SE_DACL_PRESENT   0x0004
+#define SE_DACL_PROTECTED 0x1000
+#define SE_SELF_RELATIVE  0x8000
+
+#define ACE_OBJECT_TYPE_PRESENT           0x1
+#define ACE_INHERITED_OBJECT_TYPE_PRESENT 0x2
+
+// Access mask bits (ADS_RIGHT_*)
+#define RIGHT_DS_WRITE_PROP     0x00000020u
+#define RIGHT_DS_CONTROL_ACCESS 0x00000100u
+#define RIGHT_WRITE_DAC         0x00040000u
+#define RIGHT_WRITE_OWNER       0x00080000u
+#define RIGHT_GENERIC_WRITE     0x40000000u
+#define RIGHT_GENERIC_ALL       0x10000000u
+
+static uint16_t le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t sid_length(const uint8_t *sid, size_t avail) {
+    if (!sid || avail < 8 || sid[0] != 1 || sid[1] > 15) return 0;
+    size_t len = 8 + (size_t)sid[1] * 4;
+    return len <= avail ? len : 0;
+}
+
+int sd_parse(const void *data, size_t len, SecurityDescriptor *sd) {
+    const uint8_t *base = data;
+    memset(sd, 0, sizeof(*sd));
+    if (!base || len < 20 || base[0] != 1) return -1;
+
+    // Offsets are only meaningful in the self-relative form LDAP returns
+    uint16_t control = le16(base + 2);
+    if (!(control & SE_SELF_RELATIVE)) return -1;
+    sd->protected_dacl = (control & SE_DACL_PROTECTED) != 0;
+
+    uint32_t owner_off = le32(base + 4);
+    if (owner_off != 0) {
+        if (owner_off >= len) return -1;
+        sd->owner_len = sid_length(base + owner_off, len - owner_off);
+        if (sd->owner_len == 0) return -1;
+        sd->owner = base + owner_off;
+    }
+
+    // A present DACL at offset 0 is a NULL DACL; it is reported as absent
+    uint32_t dacl_off = le32(base + 16);
+    if ((control & SE_DACL_PRESENT) && dacl_off != 0) {
+        if ((size_t)dacl_off + 8 > len) return -1;
+        const uint8_t *acl = base + dacl_off;
+        uint16_t acl_size = le16(acl + 2);
+        if (acl_size < 8 || (size_t)dacl_off + acl_size > len) return -1;
+        sd->dacl = acl + 8;
+        sd->dacl_end = acl + acl_size;
+        sd->ace_count = le16(acl + 4);
+    }
+    return 0;
+}
+
+void sd_aces(const SecurityDescriptor *sd, AceIterator *it) {
+    it->next = sd->dacl;
+    it->end = sd->dacl_end;
+    it->remaining = sd->dacl ? sd->ace_count : 0;
+}
+
+int sd_next_ace(AceIterator *it, AceView *ace) {
+    if (it->remaining <= 0) return 0;
+    if (it->end - it->next < 4) return -1;
+
+    const uint8_t *p = it->next;
+    uint16_t size = le16(p + 2);
+    if (size < 8 || size > it->end - p) return -1;
+    const uint8_t *end = p + size;
+
+    memset(ace, 0, sizeof(*ace));
+    ace->type = p[0];
+    ace->flags = p[1];
+    ace->mask = le32(p + 4);
+    const uint8_t *body = p + 8;
+
+    if (ace->type == ACE_ACCESS_ALLOWED_OBJECT || ace->type == ACE_ACCESS_DENIED_OBJECT) {
+        if (end - body < 4) return -1;
+        uint32_t object_flags = le32(body);
+        body += 4;
+        if (object_flags & ACE_OBJECT_TYPE_PRESENT) {
+            if (end - body < 16) return -1;
+            ace->object_type = body;
+            body += 16;
+        }
+        if (object_flags & ACE_INHERITED_OBJECT_TYPE_PRESENT) {
+            if (end - body < 16) return -1;
+            ace->inherited_object_type = body;
+            body += 16;
+        }
+    }
+
+    // Other ACE types (audit, callback) are walked past without a trustee
+    if (ace->type == ACE_ACCESS_ALLOWED || ace->type == ACE_ACCESS_DENIED ||
+        ace->type == ACE_ACCESS_ALLOWED_OBJECT || ace->type == ACE_ACCESS_DENIED_OBJECT) {
+        ace->sid_len = sid_length(body, (size_t)(end - body));
+        if (ace->sid_len == 0) return -1;
+        ace->sid = body;
+    }
+
+    it->next = end;
+    it->remaining--;
+    return 1;
+}
+
+int sid_to_string(const uint8_t *sid, size_t len, char *buf, size_t size) {
+    if (sid_length(sid, len) == 0) return -1;
+
+    uint64_t authority = 0;
+    for (int i = 2; i < 8; i++) {
+        authority = (authority << 8) | sid[i];
+    }
+    int n = authority >> 32
+        ? snprintf(buf, size, "S-1-0x%012llx", (unsigned long long)authority)
+        : snprintf(buf, size, "S-1-%llu", (unsigned long long)authority);
+    for (int i = 0; i < sid[1] && n >= 0 && (size_t)n < size; i++) {
+        n += snprintf(buf + n, size - (size_t)n, "-%u", le32(sid + 8 + i * 4));
+    }
+    return n >= 0 && (size_t)n < size ? n : -1;
+}
+
+#define RIGHTS_OF_INTEREST (RIGHT_DS_WRITE_PROP | RIGHT_DS_CONTROL_ACCESS | RIGHT_WRITE_DAC | \
+                            RIGHT_WRITE_OWNER | RIGHT_GENERIC_WRITE | RIGHT_GENERIC_ALL)
+
+// Whether ace_perms() can return anything for this ACE
+static int ace_may_grant(const AceView *ace) {
+    if (ace->type != ACE_ACCESS_ALLOWED && ace->type != ACE_ACCESS_ALLOWED_OBJECT) return 0;
+    // Inherit-only ACEs apply to children, not to the object itself
+    if (ace->flags & ACE_INHERIT_ONLY) return 0;
+    return (ace->mask & RIGHTS_OF_INTEREST) != 0;
+}
+
+int sid_from_string(const char *text, uint8_t *out, size_t size) {
+    if (strncmp(text, "S-1-", 4) != 0 || size < 8) return -1;
+
+    char *end = NULL;
+    const char *p = text + 4;
+    if (!isdigit((unsigned char)*p)) return -1;
+    unsigned long long authority = strtoull(p, &end, 0);
+    if (end == p || authority > 0xffffffffffffULL) return -1;
+
+    out[0] = 1;
+    out[1] = 0;
+    for (int i = 0; i < 6; i++) {
+        out[2 + i] = (uint8_t)(authority >> (8 * (5 - i)));
+    }
+    size_t len = 8;
+    for (p = end; *p == '-'; p = end) {
+        if (out[1] == 15 || len + 4 > size || !isdigit((unsigned char)p[1])) return -1;
+        unsigned long sub = strtoul(p + 1, &end, 10);
+        if (sub > 0xffffffffUL) return -1;
+        for (int i = 0; i < 4; i++) {
+            out[len + i] = (uint8_t)(sub >> (8 * i));
+        }
+        len += 4;
+        out[1]++;
+    }
+    return *p == '\0' ? (int)len : -1;
+}
+
+unsigned int ace_perms(const AceView *ace) {
+    if (!ace_may_grant(ace)) return 0;
+
+    uint32_t mask = ace->mask;
+    const uint8_t *object_type = ace->object_type;
+    unsigned int perms = 0;
+
+    // GenericAll holds every right below, with no object type restriction
+    if (mask & RIGHT_GENERIC_ALL) {
+        mask |= RIGHT_WRITE_DAC | RIGHT_WRITE_OWNER | RIGHT_DS_CONTROL_ACCESS | RIGHT_DS_WRITE_PROP;
+        object_type = NULL;
+    }
+    if (mask & RIGHT_GENERIC_WRITE) {
+        mask |= RIGHT_DS_WRITE_PROP;
+        object_type = NULL;
+    }
+
+    if (mask & (RIGHT_WRITE_DAC | RIGHT_WRITE_OWNER)) {
+        perms |= PERM_MODIFY_ACL;
+    }
+
+    // Object-specific rights map through the well-known GUID table
+    const WellKnownEntry *right = object_type ? wellknown_guid(object_type) : NULL;
+
+    if (mask & RIGHT_DS_CONTROL_ACCESS) {
+        if (!object_type) {
+            perms |= PERM_RESET_PASSWORD | PERM_READ_SECRETS; // All extended rights
+        } else if (right && right->kind == WELLKNOWN_EXTENDED_RIGHT) {
+            perms |= right->perms;
+        }
+    }
+
+    if (mask & RIGHT_DS_WRITE_PROP) {
+        if (!object_type) {
+            perms |= PERM_WRITE_SECRETS | PERM_DELEGATE_AUTH; // Every attribute
+        } else if (right && right->kind == WELLKNOWN_ATTRIBUTE) {
+            perms |= right->perms;
+        }
+    }
+    return perms;
+}
+
+// Principals that can hold rights: NT AUTHORITY SIDs (domain principals,
+// BUILTIN groups, Authenticated Users, ...) and Everyone. Creator Owner and
+// the other placeholder authorities name no one.
+int sid_is_principal(const uint8_t *sid, size_t len) {
+    if (sid_length(sid, len) == 0) return 0;
+    static const uint8_t nt_authority[6] = {0, 0, 0, 0, 0, 5};
+    static const uint8_t world_authority[6] = {0, 0, 0, 0, 0, 1};
+    if (memcmp(sid + 2, nt_authority, 6) == 0) return sid[1] >= 1;
+    return memcmp(sid + 2, world_authority, 6) == 0 && sid[1] == 1 && le32(sid + 8) == 0;
+}
+
+// Add perms for trustee to grants, merging with an earlier ACE for the same
+// trustee and origin (explicit or inherited)
+static int add_grant(AceGrant *grants, int count, const uint8_t *sid, size_t len,
+                     unsigned int perms, unsigned int inherited, Arena *arena) {
+    char text[SID_STRING_MAX];
+    int text_len = sid_to_string(sid, len, text, sizeof(text));
+    // Some well-known principals (Domain Admins, krbtgt, ...) are expected to hold these rights
+    if (text_len < 0 || wellknown_expected_holder(text)) return count;
+    for (int i = 0; i < count; i++) {
+        if (grants[i].inherited == inherited && strcmp(grants[i].trustee, text) == 0) {
+            grants[i].perms |= perms;
+            return count;
+        }
+    }
+    grants[count].trustee = arena_strndup(arena, text, (size_t)text_len);
+    if (!grants[count].trustee) return -1;
+    grants[count].perms = perms;
+    grants[count].inherited = inherited;
+    return count + 1;
+}
+
+int sd_collect_grants(const void *data, size_t len, Arena *arena, AceGrant **grants_out) {
+    SecurityDescriptor sd;
+    AceIterator it;
+    AceView ace;
+    int rc;
+
+    *grants_out = NULL;
+    if (sd_parse(data, len, &sd) != 0) return SD_MALFORMED;
+
+    // Bound the grant array first (without the GUID lookups) so objects
+    // granting nothing cost no memory
+    int candidates = sd.owner && sid_is_principal(sd.owner, sd.owner_len) ? 1 : 0;
+    sd_aces(&sd, &it);
+    while ((rc = sd_next_ace(&it, &ace)) > 0) {
+        if (ace_may_grant(&ace) && sid_is_principal(ace.sid, ace.sid_len)) candidates++;
+    }
+    if (rc < 0) return SD_MALFORMED;
+    if (candidates == 0) return 0;
+
+    AceGrant *grants = arena_alloc(arena, (size_t)candidates * sizeof(AceGrant));
+    if (!grants) return SD_NO_MEMORY;
+
+    // The owner can always rewrite the DACL
+    int count = 0;
+    if (sd.owner && sid_is_principal(sd.owner, sd.owner_len)) {
+        count = add_grant(grants, count, sd.owner, sd.owner_len, PERM_MODIFY_ACL, 0, arena);
+    }
+    sd_aces(&sd, &it);
+    while (count >= 0 && sd_next_ace(&it, &ace) > 0) {
+        if (!ace_may_grant(&ace) || !sid_is_principal(ace.sid, ace.sid_len)) continue;
+        unsigned int perms = ace_perms(&ace);
+        if (perms) {
+            count = add_grant(grants, count, ace.sid, ace.sid_len, perms,
+                              (ace.flags & ACE_INHERITED) != 0, arena);
+        }
+    }
+    if (count < 0) return SD_NO_MEMORY;
+
+    *grants_out = count > 0 ? grants : NULL;
+    return count;
+}
+
+// Rights collected per trustee before they are handed to users
+typedef struct {
+    unsigned int *group_perms;  // Per group ID
+    int group_count;
+    int group_grants;           // Grants credited to groups
+    unsigned int all_perms;     // Granted to principals every user belongs to
+    int all_object[PERM_COUNT]; // Per PERM bit of all_perms: the one user object it
+                                // was granted over, -1 for several, a container or a group
+} GrantTotals;
+
+// Credit one grant over object (a user index, -1 for a container or group) to its
+// trustee: a scanned user directly, a group through group_perms, Everyone
+// and the like through all_perms
+static void credit_grant(ADUser *users, int object, const AceGrant *grant, GrantTotals *totals) {
+    Principal trustee;
+    if (!sid_resolver_lookup(grant->trustee, &trustee)) return;
+    // Rights a user holds over its own object grant nothing new
+    if (trustee.kind == PRINCIPAL_USER && trustee.user_index >= 0 && trustee.user_index != object) {
+        users[trustee.user_index].acl_perms |= grant->perms;
+    } else if (trustee.kind == PRINCIPAL_GROUP && trustee.name) {
+        int id = group_table_find(trustee.name, strlen(trustee.name));
+        if (id >= 0 && id < totals->group_count) {
+            totals->group_perms[id] |= grant->perms;
+            totals->group_grants++;
+        }
+    } else if (trustee.kind == PRINCIPAL_ALL_USERS) {
+        for (int bit = 0; bit < PERM_COUNT; bit++) {
+            if (!(grant->perms & (1u << bit))) continue;
+            if (!(totals->all_perms & (1u << bit))) {
+                totals->all_object[bit] = object;
+            } else if (totals->all_object[bit] != object) {
+                totals->all_object[bit] = -1;
+            }
+        }
+        totals->all_perms |= grant->perms;
+    }
+}
+
+int sd_resolve_grants(ADUser *users, int count) {
+    for (int i = 0; i < count; i++) {
+        users[i].acl_perms = 0;
+    }
+    if (sid_resolver_add_users(users, count) != 0) return -1;
+
+    // Rights held by groups are collected per group ID, then handed to members
+    GrantTotals totals;
+    memset(&totals, 0, sizeof(totals));
+    totals.group_count = group_table_count();
+    totals.group_perms = calloc((size_t)(totals.group_count > 0 ? totals.group_count : 1), sizeof(unsigned int));
+    if (!totals.group_perms) return -1;
+
+    for (int i = 0; i < count; i++) {
+        for (int g = 0; g < users[i].acl_grant_count; g++) {
+            credit_grant(users, i, &users[i].acl_grants[g], &totals);
+        }
+    }
+    // Rights over a container (WriteDACL on an OU, say) or a group count like
+    // rights over an object
+    int containers = effective_rights_containers();
+    for (int c = 0; c < containers; c++) {
+        const AceGrant *grants = NULL;
+        int grant_count = effective_rights_container_grants(c, &grants);
+        for (int g = 0; g < grant_count; g++) {
+            credit_grant(users, -1, &grants[g], &totals);
+        }
+    }
+    int groups = group_rights_bound();
+    for (int id = 0; id < groups; id++) {
+        const AceGrant *grants = NULL;
+        int grant_count = group_rights_get(id, &grants);
+        for (int g = 0; g < grant_count; g++) {
+            credit_grant(users, -1, &grants[g], &totals);
+        }
+    }
+
+    // Every user holds what Everyone, Authenticated Users or Domain Users
+    // (the primary group, absent from memberOf) were granted, except over
+    // its own object
+    for (int i = 0; totals.all_perms && i < count; i++) {
+        for (int bit = 0; bit < PERM_COUNT; bit++) {
+            if ((totals.all_perms & (1u << bit)) && totals.all_object[bit] != i) users[i].acl_perms |= 1u << bit;
+        }
+    }
+
+    // Members of a group receive its rights, including through nested groups
+    GroupGraphScratch scratch;
+    if (group_graph_scratch_init(&scratch) != 0) {
+        free(totals.group_perms);
+        return -1;
+    }
+    for (int i = 0; totals.group_grants > 0 && i < count; i++) {
+        for (int g = 0; g < users[i].group_count; g++) {
+            int id = users[i].group_ids[g];
+            if (id >= 0 && id < totals.group_count) users[i].acl_perms |= totals.group_perms[id];
+        }
+        int nested = group_graph_nested(users[i].group_ids, users[i].group_count, &scratch);
+        for (int k = 0; k < nested; k++) {
+            int id = scratch.groups[k];
+            if (id >= 0 && id < totals.group_count) users[i].acl_perms |= totals.group_perms[id];
+        }
+    }
+    group_graph_scratch_free(&scratch);
+    free(totals.group_perms);
+
+    int holders = 0;
+    for (int i = 0; i < count; i++) {
+        if (users[i].acl_perms) holders++;
+    }
+    return holders;
+}
@@ -0,0 +1,212 @@
+#include "sid_resolver.h"
+#include "arena.h"
+#include "effective_rights.h"
+#include "group_rights.h"
+#include "wellknown.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *sid;
+    const char *name;
+    PrincipalKind kind;
+    int user_index;
+    uint32_t hash;
+} SidEntry;
+
+typedef struct {
+    SidEntry *entries;
+    int count;
+    int cap;
+    int *slots;            // Open-addressing index: entry + 1, 0 = empty
+    size_t slot_cap;       // Power of two
+    Arena arena;           // SID and name strings
+    SidResolverStats stats;
+} SidResolver;
+
+static SidResolver resolver;
+
+static uint32_t hash_sid(const char *s) {
+    uint32_t hash = 2166136261u;
+    for (; *s; s++) {
+        hash ^= (unsigned char)*s;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int grow_slots(void) {
+    size_t new_cap = resolver.slot_cap == 0 ? 1024 : resolver.slot_cap * 2;
+    int *slots = calloc(new_cap, sizeof(int));
+    if (!slots) return -1;
+    for (int i = 0; i < resolver.count; i++) {
+        size_t pos = resolver.entries[i].hash & (new_cap - 1);
+        while (slots[pos] != 0) pos = (pos + 1) & (new_cap - 1);
+        slots[pos] = i + 1;
+    }
+    free(resolver.slots);
+    resolver.slots = slots;
+    resolver.slot_cap = new_cap;
+    return 0;
+}
+
+// Entry for sid, or NULL; *pos_out receives its slot or the free slot to use
+static SidEntry *find_entry(const char *sid, uint32_t hash, size_t *pos_out) {
+    if (resolver.slot_cap == 0) return NULL;
+    size_t pos = hash & (resolver.slot_cap - 1);
+    while (resolver.slots[pos] != 0) {
+        SidEntry *entry = &resolver.entries[resolver.slots[pos] - 1];
+        if (entry->hash == hash && strcmp(entry->sid, sid) == 0) {
+            *pos_out = pos;
+            return entry;
+        }
+        pos = (pos + 1) & (resolver.slot_cap - 1);
+    }
+    *pos_out = pos;
+    return NULL;
+}
+
+void sid_resolver_reset(void) {
+    free(resolver.entries);
+    free(resolver.slots);
+    arena_destroy(&resolver.arena);
+    memset(&resolver, 0, sizeof(resolver));
+}
+
+int sid_resolver_add(const char *sid, const char *name, PrincipalKind kind, int user_index) {
+    if (resolver.slot_cap == 0) {
+        arena_init(&resolver.arena);
+    }
+    // Keep the load factor under one half
+    if ((size_t)(resolver.count + 1) * 2 > resolver.slot_cap && grow_slots() != 0) return -1;
+
+    uint32_t hash = hash_sid(sid);
+    size_t pos = 0;
+    SidEntry *entry = find_entry(sid, hash, &pos);
+    if (!entry) {
+        if (resolver.count == resolver.cap) {
+            int new_cap = resolver.cap == 0 ? 256 : resolver.cap * 2;
+            SidEntry *entries = realloc(resolver.entries, (size_t)new_cap * sizeof(SidEntry));
+            if (!entries) return -1;
+            resolver.entries = entries;
+            resolver.cap = new_cap;
+        }
+        const char *copy = arena_strdup(&resolver.arena, sid);
+        if (!copy) return -1;
+        entry = &resolver.entries[resolver.count];
+        entry->sid = copy;
+        entry->hash = hash;
+        resolver.slots[pos] = ++resolver.count;
+    }
+
+    entry->name = name ? arena_strdup(&resolver.arena, name) : NULL;
+    entry->kind = kind;
+    entry->user_index = user_index;
+    return 0;
+}
+
+int sid_resolver_add_users(const ADUser *users, int count) {
+    for (int i = 0; i < count; i++) {
+        if (users[i].sid && sid_resolver_add(users[i].sid, users[i].dn, PRINCIPAL_USER, i) != 0) return -1;
+    }
+    return 0;
+}
+
+// Append the trustees of grants that are not mapped to the pending list. Of
+// the well-known principals, only ordinary ones (BUILTIN and domain groups
+// such as Account Operators or Domain Computers) are looked up: their members
+// can be found through their DN. Returns 0, -1 on allocation failure
+static int add_pending(const AceGrant *grants, int grant_count, const char ***pending, int *pending_count,
+                       int *pending_cap) {
+    for (int g = 0; g < grant_count; g++) {
+        const char *sid = grants[g].trustee;
+        size_t pos;
+        if (find_entry(sid, hash_sid(sid), &pos)) continue;
+        const WellKnownEntry *known = wellknown_sid(sid);
+        if (known && known->holder != WELLKNOWN_HOLDER_NONE) continue;
+
+        // Placeholder entry so the SID is listed once; answers replace it
+        if (sid_resolver_add(sid, NULL, PRINCIPAL_UNKNOWN, -1) != 0) return -1;
+        if (*pending_count == *pending_cap) {
+            *pending_cap = *pending_cap == 0 ? 64 : *pending_cap * 2;
+            const char **next = realloc(*pending, (size_t)*pending_cap * sizeof(char *));
+            if (!next) return -1;
+            *pending = next;
+        }
+        (*pending)[(*pending_count)++] = sid;
+    }
+    return 0;
+}
+
+int sid_resolver_pending(const ADUser *users, int count, const char ***sids_out) {
+    const char **pending = NULL;
+    int pending_count = 0;
+    int pending_cap = 0;
+
+    *sids_out = NULL;
+    for (int i = 0; i < count; i++) {
+        if (add_pending(users[i].acl_grants, users[i].acl_grant_count, &pending, &pending_count, &pending_cap) != 0) {
+            free(pending);
+            return -1;
+        }
+    }
+    // Rights over containers (effective_rights.h) name trustees of their own
+    int containers = effective_rights_containers();
+    for (int c = 0; c < containers; c++) {
+        const AceGrant *grants = NULL;
+        int grant_count = effective_rights_container_grants(c, &grants);
+        if (add_pending(grants, grant_count, &pending, &pending_count, &pending_cap) != 0) {
+            free(pending);
+            return -1;
+        }
+    }
+    // So do rights over groups (group_rights.h)
+    int groups = group_rights_bound();
+    for (int id = 0; id < groups; id++) {
+        const AceGrant *grants = NULL;
+        int grant_count = group_rights_get(id, &grants);
+        if (add_pending(grants, grant_count, &pending, &pending_count, &pending_cap) != 0) {
+            free(pending);
+            return -1;
+        }
+    }
+
+    resolver.stats.misses += pending_count;
+    *sids_out = pending;
+    return pending_count;
+}
+
+void sid_resolver_record_batch(void) {
+    resolver.stats.batches++;
+}
+
+int sid_resolver_lookup(const char *sid, Principal *out) {
+    size_t pos;
+    SidEntry *entry = find_entry(sid, hash_sid(sid), &pos);
+    if (entry && entry->kind != PRINCIPAL_UNKNOWN) {
+        resolver.stats.hits++;
+        out->name = entry->name;
+        out->kind = entry->kind;
+        out->user_index = entry->user_index;
+        return 1;
+    }
+
+    // Well-known principals the directory did not return (Anonymous Logon,
+    // say) keep their table name
+    const WellKnownEntry *known = wellknown_sid(sid);
+    if (known) {
+        resolver.stats.wellknown_hits++;
+        out->name = known->name;
+        out->kind = known->holder == WELLKNOWN_HOLDER_ALL_USERS ? PRINCIPAL_ALL_USERS : PRINCIPAL_WELLKNOWN;
+        out->user_index = -1;
+        return 1;
+    }
+
+    resolver.stats.unresolved++;
+    return 0;
+}
+
+void sid_resolver_stats(SidResolverStats *stats) {
+    *stats = resolver.stats;
+}
@@ -0,0 +1,299 @@
+#include "snapshot.h"
+#include "classifier.h"
+#include "error_handler.h"
+#include "group_table.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SNAPSHOT_MAGIC "ACLGSNAP"
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+enum {
+    BLOCK_PERM_BITS,
+    BLOCK_RISK,
+    BLOCK_PERM_PLANES,
+    BLOCK_DETECTIONS,
+    BLOCK_STRINGS,          // USER_COL_COUNT columns back to back
+    BLOCK_STRING_HEAP,
+    BLOCK_GROUP_START,
+    BLOCK_GROUP_HEAP,
+    BLOCK_GROUP_NAMES,
+    BLOCK_GROUP_NAME_HEAP,
+    SNAPSHOT_BLOCKS
+};
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t string_columns;   // USER_COL_COUNT of the writer
+    uint32_t perm_count;       // PERM_COUNT of the writer
+    uint32_t user_count;
+    uint32_t group_count;
+    uint64_t membership_count;
+    char scan_time[32];
+    struct {
+        uint64_t offset;
+        uint64_t size;
+    } blocks[SNAPSHOT_BLOCKS];
+} SnapshotHeader;
+
+static uint64_t align8(uint64_t n) {
+    return (n + 7) & ~(uint64_t)7;
+}
+
+static size_t plane_words(uint64_t count) {
+    return (size_t)(((count > 0 ? count : 1) + 63) / 64);
+}
+
+// Block sizes implied by the header's counts, string and group name heaps aside
+static void expected_sizes(const SnapshotHeader *h, uint64_t sizes[SNAPSHOT_BLOCKS]) {
+    uint64_t n = h->user_count;
+    sizes[BLOCK_PERM_BITS] = n;
+    sizes[BLOCK_RISK] = n;
+    sizes[BLOCK_PERM_PLANES] = (uint64_t)PERM_COUNT * plane_words(n) * sizeof(uint64_t);
+    sizes[BLOCK_DETECTIONS] = n;
+    sizes[BLOCK_STRINGS] = (uint64_t)USER_COL_COUNT * n * sizeof(uint32_t);
+    sizes[BLOCK_GROUP_START] = (n + 1) * sizeof(uint32_t);
+    sizes[BLOCK_GROUP_HEAP] = h->membership_count * sizeof(int);
+    sizes[BLOCK_GROUP_NAMES] = (uint64_t)h->group_count * sizeof(uint32_t);
+}
+
+static int write_padded(FILE *fp, uint64_t *pos, uint64_t offset, const void *data, size_t size) {
+    static const char zeros[8];
+    if (offset - *pos > 0 && fwrite(zeros, 1, (size_t)(offset - *pos), fp) != offset - *pos) return -1;
+    if (size > 0 && fwrite(data, 1, size, fp) != size) return -1;
+    *pos = offset + size;
+    return 0;
+}
+
+static int write_blocks(FILE *fp, const SnapshotHeader *h, const UserStore *store, const uint8_t *detections,
+                        char *const *names, const size_t *lengths, const uint32_t *name_offsets) {
+    uint64_t pos = 0;
+    int count = store->count;
+    if (write_padded(fp, &pos, 0, h, sizeof(*h)) != 0) return -1;
+    const void *columns[SNAPSHOT_BLOCKS] = {
+        [BLOCK_PERM_BITS] = store->perm_bits,
+        [BLOCK_RISK] = store->risk,
+        [BLOCK_PERM_PLANES] = store->perm_planes,
+        [BLOCK_DETECTIONS] = detections,
+        [BLOCK_STRING_HEAP] = store->string_heap,
+        [BLOCK_GROUP_START] = store->group_start,
+        [BLOCK_GROUP_HEAP] = store->group_heap,
+        [BLOCK_GROUP_NAMES] = name_offsets,
+    };
+    for (int b = 0; b < SNAPSHOT_BLOCKS; b++) {
+        uint64_t offset = h->blocks[b].offset;
+        if (b == BLOCK_STRINGS) {
+            for (int c = 0; c < USER_COL_COUNT; c++) {
+                uint64_t column = offset + (uint64_t)c * (uint64_t)count * sizeof(uint32_t);
+                if (write_padded(fp, &pos, column, store->strings[c], (size_t)count * sizeof(uint32_t)) != 0) return -1;
+            }
+        } else if (b == BLOCK_GROUP_NAME_HEAP) {
+            for (int g = 0; g < (int)h->group_count; g++) {
+                if (write_padded(fp, &pos, g == 0 ? offset : pos, names[g], lengths[g]) != 0 ||
+                    fputc('\0', fp) == EOF) {
+                    return -1;
+                }
+                pos++;
+            }
+        } else if (write_padded(fp, &pos, offset, columns[b], (size_t)h->blocks[b].size) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int snapshot_write(const char *path, const UserStore *store, const uint8_t *detections, const char *scan_time) {
+    if (store->parts != USER_STORE_ALL) return -1;
+
+    char *const *names = NULL;
+    const size_t *lengths = NULL;
+    int group_count = group_table_names(&names, &lengths);
+    uint32_t *name_offsets = malloc((group_count > 0 ? (size_t)group_count : 1) * sizeof(uint32_t));
+    if (!name_offsets) return -1;
+    uint64_t name_bytes = 0;
+    for (int g = 0; g < group_count; g++) {
+        name_offsets[g] = (uint32_t)name_bytes;
+        name_bytes += lengths[g] + 1;
+    }
+    if (name_bytes >= UINT32_MAX) {
+        free(name_offsets);
+        return -1;
+    }
+
+    SnapshotHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic));
+    h.version = SNAPSHOT_VERSION;
+    h.byte_order = SNAPSHOT_BYTE_ORDER;
+    h.string_columns = USER_COL_COUNT;
+    h.perm_count = PERM_COUNT;
+    h.user_count = (uint32_t)store->count;
+    h.group_count = (uint32_t)group_count;
+    h.membership_count = store->group_start[store->count];
+    snprintf(h.scan_time, sizeof(h.scan_time), "%s", scan_time ? scan_time : "");
+
+    uint64_t sizes[SNAPSHOT_BLOCKS];
+    expected_sizes(&h, sizes);
+    sizes[BLOCK_STRING_HEAP] = store->string_bytes;
+    sizes[BLOCK_GROUP_NAME_HEAP] = name_bytes;
+    uint64_t pos = sizeof(h);
+    for (int b = 0; b < SNAPSHOT_BLOCKS; b++) {
+        h.blocks[b].offset = align8(pos);
+        h.blocks[b].size = sizes[b];
+        pos = h.blocks[b].offset + sizes[b];
+    }
+
+    // Write to a temporary file first so an interrupted run never leaves a torn snapshot
+    size_t tmp_len = strlen(path) + 5;
+    char *tmp_path = malloc(tmp_len);
+    if (!tmp_path) {
+        free(name_offsets);
+        return -1;
+    }
+    snprintf(tmp_path, tmp_len, "%s.tmp", path);
+
+    int rc = -1;
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp) {
+        rc = write_blocks(fp, &h, store, detections, names, lengths, name_offsets);
+        if (fclose(fp) != 0) rc = -1;
+        if (rc == 0 && rename(tmp_path, path) != 0) rc = -1;
+    }
+    if (rc != 0) {
+        log_error("Failed to write snapshot file: %s", path);
+        remove(tmp_path);
+    }
+
+    free(tmp_path);
+    free(name_offsets);
+    return rc;
+}
+
+// Why a mapped file is not a usable snapshot, or NULL if it is
+static const char *check_snapshot(const unsigned char *base, size_t size) {
+    if (size < sizeof(SnapshotHeader)) return "truncated header";
+    const SnapshotHeader *h = (const SnapshotHeader *)base;
+    if (memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic)) != 0) return "not a snapshot";
+    if (h->version != SNAPSHOT_VERSION) return "unsupported version";
+    if (h->byte_order != SNAPSHOT_BYTE_ORDER) return "written with another byte order";
+    if (h->string_columns != USER_COL_COUNT || h->perm_count != PERM_COUNT) return "unsupported column layout";
+    if (h->user_count > INT_MAX || h->group_count > INT_MAX || h->membership_count >= UINT32_MAX) {
+        return "counts out of range";
+    }
+
+    uint64_t sizes[SNAPSHOT_BLOCKS];
+    expected_sizes(h, sizes);
+    sizes[BLOCK_STRING_HEAP] = h->blocks[BLOCK_STRING_HEAP].size;
+    sizes[BLOCK_GROUP_NAME_HEAP] = h->blocks[BLOCK_GROUP_NAME_HEAP].size;
+    for (int b = 0; b < SNAPSHOT_BLOCKS; b++) {
+        uint64_t offset = h->blocks[b].offset;
+        if (h->blocks[b].size != sizes[b] || offset % 8 != 0 || offset < sizeof(*h) || offset > size ||
+            sizes[b] > size - offset) {
+            return "block out of bounds";
+        }
+    }
+
+    // Offsets are trusted once checked, so every one is checked here; the
+    // heaps end in NUL, so each string ends inside its heap
+    const uint64_t string_bytes = sizes[BLOCK_STRING_HEAP];
+    const uint64_t name_bytes = sizes[BLOCK_GROUP_NAME_HEAP];
+    if ((string_bytes > 0 && base[h->blocks[BLOCK_STRING_HEAP].offset + string_bytes - 1] != '\0') ||
+        (name_bytes > 0 && base[h->blocks[BLOCK_GROUP_NAME_HEAP].offset + name_bytes - 1] != '\0')) {
+        return "unterminated string heap";
+    }
+    const uint32_t *strings = (const uint32_t *)(base + h->blocks[BLOCK_STRINGS].offset);
+    for (uint64_t i = 0; i < (uint64_t)USER_COL_COUNT * h->user_count; i++) {
+        if (strings[i] != USER_STORE_NO_STRING && strings[i] >= string_bytes) return "string offset out of range";
+    }
+    const uint32_t *names = (const uint32_t *)(base + h->blocks[BLOCK_GROUP_NAMES].offset);
+    for (uint32_t g = 0; g < h->group_count; g++) {
+        if (names[g] >= name_bytes) return "group name offset out of range";
+    }
+    const uint32_t *start = (const uint32_t *)(base + h->blocks[BLOCK_GROUP_START].offset);
+    if (start[0] != 0 || start[h->user_count] != h->membership_count) return "membership index out of range";
+    for (uint32_t i = 0; i < h->user_count; i++) {
+        if (start[i] > start[i + 1]) return "membership index out of range";
+    }
+    const int *groups = (const int *)(base + h->blocks[BLOCK_GROUP_HEAP].offset);
+    for (uint64_t m = 0; m < h->membership_count; m++) {
+        if (groups[m] < 0 || (uint32_t)groups[m] >= h->group_count) return "group ID out of range";
+    }
+    return NULL;
+}
+
+int snapshot_open(const char *path, Snapshot *snap) {
+    memset(snap, 0, sizeof(*snap));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        log_error("Failed to open snapshot file: %s (%s)", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SnapshotHeader)) {
+        log_error("Invalid snapshot file: %s (truncated header)", path);
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        log_error("Failed to map snapshot file: %s (%s)", path, strerror(errno));
+        return -1;
+    }
+
+    unsigned char *base = map;
+    const char *problem = check_snapshot(base, size);
+    if (problem) {
+        log_error("Invalid snapshot file: %s (%s)", path, problem);
+        munmap(map, size);
+        return -1;
+    }
+
+    // Point the store's columns at the mapping; nothing is copied or decoded
+    const SnapshotHeader *h = map;
+    UserStore *store = &snap->store;
+    store->count = (int)h->user_count;
+    store->words = plane_words(h->user_count);
+    store->perm_bits = (uint8_t *)(base + h->blocks[BLOCK_PERM_BITS].offset);
+    store->risk = (uint8_t *)(base + h->blocks[BLOCK_RISK].offset);
+    store->perm_planes = (uint64_t *)(base + h->blocks[BLOCK_PERM_PLANES].offset);
+    store->parts = USER_STORE_ALL;
+    for (int c = 0; c < USER_COL_COUNT; c++) {
+        store->strings[c] = (uint32_t *)(base + h->blocks[BLOCK_STRINGS].offset) + (size_t)c * h->user_count;
+    }
+    store->string_heap = (char *)(base + h->blocks[BLOCK_STRING_HEAP].offset);
+    store->string_bytes = (size_t)h->blocks[BLOCK_STRING_HEAP].size;
+    store->group_start = (uint32_t *)(base + h->blocks[BLOCK_GROUP_START].offset);
+    store->group_heap = (int *)(base + h->blocks[BLOCK_GROUP_HEAP].offset);
+
+    snap->detections = base + h->blocks[BLOCK_DETECTIONS].offset;
+    snap->group_count = (int)h->group_count;
+    snap->group_names = (const uint32_t *)(base + h->blocks[BLOCK_GROUP_NAMES].offset);
+    snap->group_heap = (const char *)(base + h->blocks[BLOCK_GROUP_NAME_HEAP].offset);
+    snap->group_bytes = (size_t)h->blocks[BLOCK_GROUP_NAME_HEAP].size;
+    memcpy(snap->scan_time, h->scan_time, sizeof(snap->scan_time) - 1);
+    snap->scan_time[sizeof(snap->scan_time) - 1] = '\0';
+    snap->map = map;
+    snap->map_size = size;
+    return 0;
+}
+
+void snapshot_close(Snapshot *snap) {
+    if (snap->map) munmap(snap->map, snap->map_size);
+    memset(snap, 0, sizeof(*snap));
+}
+
+const char *snapshot_group_name(const Snapshot *snap, int id) {
+    if (id < 0 || id >= snap->group_count) return NULL;
+    return snap->group_heap + snap->group_names[id];
+}
@@ -0,0 +1,212 @@
+#include "thread_pool.h"
+#include "error_handler.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+// Chunk indices [lo, hi) still queued for one thread. The owner takes from lo,
+// thieves take from hi, so they only meet on the last chunk.
+typedef struct {
+    pthread_mutex_t lock;
+    int lo;
+    int hi;
+} ChunkDeque;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    pthread_mutex_t job_lock;   // One parallel_for at a time
+
+    pthread_t *workers;
+    int worker_count;           // Threads besides the caller
+    int shutdown;
+
+    // Current job
+    unsigned long generation;
+    unsigned long start_generation; // Generation workers were started at
+    ParallelBody body;
+    void *ctx;
+    int count;
+    int chunk_size;
+    ChunkDeque *deques;         // worker_count + 1; slot 0 is the caller
+    int running;                // Workers still busy with the current job
+    long steals;
+} ThreadPool;
+
+static ThreadPool pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work_ready = PTHREAD_COND_INITIALIZER,
+    .work_done = PTHREAD_COND_INITIALIZER,
+    .job_lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static __thread int in_parallel_body;
+
+static int take_chunk(int self, int slots) {
+    ChunkDeque *own = &pool.deques[self];
+    pthread_mutex_lock(&own->lock);
+    int chunk = own->lo < own->hi ? own->lo++ : -1;
+    pthread_mutex_unlock(&own->lock);
+    if (chunk >= 0) return chunk;
+
+    // Own deque is empty: steal from the back of the next non-empty one
+    for (int i = 1; i < slots; i++) {
+        ChunkDeque *victim = &pool.deques[(self + i) % slots];
+        pthread_mutex_lock(&victim->lock);
+        chunk = victim->lo < victim->hi ? --victim->hi : -1;
+        pthread_mutex_unlock(&victim->lock);
+        if (chunk >= 0) {
+            __atomic_fetch_add(&pool.steals, 1, __ATOMIC_RELAXED);
+            return chunk;
+        }
+    }
+    return -1;
+}
+
+static void run_chunks(int self) {
+    int slots = pool.worker_count + 1;
+    in_parallel_body = 1;
+    for (;;) {
+        int chunk = take_chunk(self, slots);
+        if (chunk < 0) break;
+        int begin = chunk * pool.chunk_size;
+        int end = begin + pool.chunk_size;
+        if (end > pool.count) end = pool.count;
+        pool.body(pool.ctx, begin, end);
+    }
+    in_parallel_body = 0;
+}
+
+static void *worker_main(void *arg) {
+    int self = (int)(long)arg;
+
+    // Not pool.generation: a job may already have been posted before this
+    // thread got to run, and it must still take part in it
+    pthread_mutex_lock(&pool.lock);
+    unsigned long seen = pool.start_generation;
+    for (;;) {
+        while (!pool.shutdown && pool.generation == seen) {
+            pthread_cond_wait(&pool.work_ready, &pool.lock);
+        }
+        if (pool.shutdown) break;
+        seen = pool.generation;
+        pthread_mutex_unlock(&pool.lock);
+
+        run_chunks(self);
+
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.running == 0) {
+            pthread_cond_signal(&pool.work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+int thread_pool_init(int threads) {
+    thread_pool_shutdown();
+    if (threads <= 1) return 0;
+
+    int worker_count = threads - 1;
+    pool.workers = calloc((size_t)worker_count, sizeof(pthread_t));
+    pool.deques = calloc((size_t)threads, sizeof(ChunkDeque));
+    if (!pool.workers || !pool.deques) {
+        free(pool.workers);
+        free(pool.deques);
+        pool.workers = NULL;
+        pool.deques = NULL;
+        log_error("Failed to allocate a %d-thread pool; running single-threaded.", threads);
+        return -1;
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_mutex_init(&pool.deques[i].lock, NULL);
+    }
+
+    pool.shutdown = 0;
+    pool.start_generation = pool.generation;
+    for (int i = 0; i < worker_count; i++) {
+        if (pthread_create(&pool.workers[i], NULL, worker_main, (void *)(long)(i + 1)) != 0) {
+            log_error("Started %d of %d pool threads.", i + 1, threads);
+            break;
+        }
+        pool.worker_count++;
+    }
+
+    static int registered;
+    if (!registered) {
+        atexit(thread_pool_shutdown);
+        registered = 1;
+    }
+    return 0;
+}
+
+int thread_pool_size(void) {
+    return pool.worker_count + 1;
+}
+
+void thread_pool_shutdown(void) {
+    if (!pool.workers) return;
+
+    pthread_mutex_lock(&pool.lock);
+    pool.shutdown = 1;
+    pthread_cond_broadcast(&pool.work_ready);
+    pthread_mutex_unlock(&pool.lock);
+    for (int i = 0; i < pool.worker_count; i++) {
+        pthread_join(pool.workers[i], NULL);
+    }
+
+    if (pool.deques) {
+        for (int i = 0; i <= pool.worker_count; i++) {
+            pthread_mutex_destroy(&pool.deques[i].lock);
+        }
+    }
+    free(pool.workers);
+    free(pool.deques);
+    pool.workers = NULL;
+    pool.deques = NULL;
+    pool.worker_count = 0;
+}
+
+void parallel_for(int count, int chunk_size, ParallelBody body, void *ctx) {
+    if (count <= 0) return;
+    if (chunk_size <= 0) chunk_size = PARALLEL_CHUNK;
+
+    int chunks = (count + chunk_size - 1) / chunk_size;
+    if (pool.worker_count == 0 || chunks == 1 || in_parallel_body) {
+        body(ctx, 0, count);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.job_lock);
+
+    // Deal contiguous runs of chunks to each thread
+    int slots = pool.worker_count + 1;
+    for (int i = 0; i < slots; i++) {
+        pool.deques[i].lo = (int)((long)chunks * i / slots);
+        pool.deques[i].hi = (int)((long)chunks * (i + 1) / slots);
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.body = body;
+    pool.ctx = ctx;
+    pool.count = count;
+    pool.chunk_size = chunk_size;
+    pool.running = pool.worker_count;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.work_ready);
+    pthread_mutex_unlock(&pool.lock);
+
+    run_chunks(0);
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.running > 0) {
+        pthread_cond_wait(&pool.work_done, &pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+
+    pthread_mutex_unlock(&pool.job_lock);
+}
+
+long thread_pool_steals(void) {
+    return __atomic_load_n(&pool.steals, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,191 @@
+#include "user_store.h"
+#include "classifier.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *column_value(const ADUser *user, UserColumn column) {
+    switch (column) {
+        case USER_COL_USERNAME: return user->username;
+        case USER_COL_CN: return user->cn;
+        case USER_COL_DN: return user->dn;
+        case USER_COL_GUID: return user->guid;
+        case USER_COL_MAIL: return user->mail;
+        default: return NULL;
+    }
+}
+
+// User i of a build: users[i], or order[i] when building in a given order
+static const ADUser *user_at(const ADUser *users, const ADUser *const *order, int i) {
+    return order ? order[i] : &users[i];
+}
+
+static int build_strings(UserStore *store, const ADUser *users, const ADUser *const *order, int count) {
+    // Size the heap up front so it is a single allocation
+    size_t string_bytes = 0;
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < USER_COL_COUNT; c++) {
+            const char *value = column_value(user_at(users, order, i), (UserColumn)c);
+            if (value) string_bytes += strlen(value) + 1;
+        }
+    }
+    if (string_bytes >= USER_STORE_NO_STRING) return -1;
+
+    size_t n = count > 0 ? (size_t)count : 1;
+    store->string_heap = malloc(string_bytes > 0 ? string_bytes : 1);
+    if (!store->string_heap) return -1;
+    for (int c = 0; c < USER_COL_COUNT; c++) {
+        store->strings[c] = malloc(n * sizeof(uint32_t));
+        if (!store->strings[c]) return -1;
+    }
+
+    size_t pos = 0;
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < USER_COL_COUNT; c++) {
+            const char *value = column_value(user_at(users, order, i), (UserColumn)c);
+            if (!value) {
+                store->strings[c][i] = USER_STORE_NO_STRING;
+                continue;
+            }
+            size_t len = strlen(value) + 1;
+            memcpy(store->string_heap + pos, value, len);
+            store->strings[c][i] = (uint32_t)pos;
+            pos += len;
+        }
+    }
+    store->string_bytes = pos;
+    return 0;
+}
+
+static int build_groups(UserStore *store, const ADUser *users, const ADUser *const *order, int count) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += (size_t)user_at(users, order, i)->group_count;
+    }
+    if (total >= UINT32_MAX) return -1;
+
+    store->group_start = malloc(((size_t)count + 1) * sizeof(uint32_t));
+    store->group_heap = malloc((total > 0 ? total : 1) * sizeof(int));
+    if (!store->group_start || !store->group_heap) return -1;
+
+    size_t pos = 0;
+    for (int i = 0; i < count; i++) {
+        const ADUser *user = user_at(users, order, i);
+        store->group_start[i] = (uint32_t)pos;
+        if (user->group_count > 0) {
+            memcpy(store->group_heap + pos, user->group_ids, (size_t)user->group_count * sizeof(int));
+            pos += (size_t)user->group_count;
+        }
+    }
+    store->group_start[count] = (uint32_t)pos;
+    return 0;
+}
+
+static int build_store(UserStore *store, const ADUser *users, const ADUser *const *order, int count,
+                       unsigned int parts) {
+    memset(store, 0, sizeof(*store));
+    if (count < 0) return -1;
+
+    size_t n = count > 0 ? (size_t)count : 1;
+    store->count = count;
+    store->words = (n + 63) / 64;
+    store->perm_bits = calloc(n, sizeof(uint8_t));
+    store->risk = calloc(n, sizeof(uint8_t));
+    store->perm_planes = calloc((size_t)PERM_COUNT * store->words, sizeof(uint64_t));
+    if (!store->perm_bits || !store->risk || !store->perm_planes) goto fail;
+
+    for (int i = 0; i < count; i++) {
+        const ADUser *user = user_at(users, order, i);
+        unsigned int bits = user_perm_bits(user);
+        int risk = user->risk;
+        store->perm_bits[i] = (uint8_t)bits;
+        store->risk[i] = (uint8_t)(risk < 0 ? 0 : risk > 100 ? 100 : risk);
+        for (int p = 0; p < PERM_COUNT; p++) {
+            if (bits & (1u << p)) {
+                store->perm_planes[(size_t)p * store->words + ((size_t)i >> 6)] |= 1ULL << (i & 63);
+            }
+        }
+    }
+
+    if ((parts & USER_STORE_STRINGS) && build_strings(store, users, order, count) != 0) goto fail;
+    if ((parts & USER_STORE_GROUPS) && build_groups(store, users, order, count) != 0) goto fail;
+    store->parts = parts;
+    return 0;
+
+fail:
+    user_store_free(store);
+    return -1;
+}
+
+int user_store_build(UserStore *store, const ADUser *users, int count, unsigned int parts) {
+    return build_store(store, users, NULL, count, parts);
+}
+
+int user_store_build_ordered(UserStore *store, const ADUser *const *users, int count, unsigned int parts) {
+    return build_store(store, NULL, users, count, parts);
+}
+
+void user_store_free(UserStore *store) {
+    free(store->perm_bits);
+    free(store->risk);
+    free(store->perm_planes);
+    for (int c = 0; c < USER_COL_COUNT; c++) {
+        free(store->strings[c]);
+    }
+    free(store->string_heap);
+    free(store->group_start);
+    free(store->group_heap);
+    memset(store, 0, sizeof(*store));
+}
+
+const char *user_store_string(const UserStore *store, UserColumn column, int i) {
+    if (!(store->parts & USER_STORE_STRINGS)) return NULL;
+    uint32_t offset = store->strings[column][i];
+    return offset == USER_STORE_NO_STRING ? NULL : store->string_heap + offset;
+}
+
+void user_store_view(const UserStore *store, int i, ADUser *out) {
+    memset(out, 0, sizeof(*out));
+    out->username = (char *)user_store_string(store, USER_COL_USERNAME, i);
+    out->cn = (char *)user_store_string(store, USER_COL_CN, i);
+    out->dn = (char *)user_store_string(store, USER_COL_DN, i);
+    out->guid = (char *)user_store_string(store, USER_COL_GUID, i);
+    out->mail = (char *)user_store_string(store, USER_COL_MAIL, i);
+    if (store->parts & USER_STORE_GROUPS) {
+        out->group_count = (int)(store->group_start[i + 1] - store->group_start[i]);
+        out->group_ids = out->group_count > 0 ? store->group_heap + store->group_start[i] : NULL;
+    }
+    apply_perm_bits(out, store->perm_bits[i]);
+    out->risk = store->risk[i];
+}
+
+int user_store_count_any(const UserStore *store, unsigned int mask) {
+    long total = 0;
+    for (size_t w = 0; w < store->words; w++) {
+        uint64_t bits = 0;
+        for (int p = 0; p < PERM_COUNT; p++) {
+            if (mask & (1u << p)) bits |= store->perm_planes[(size_t)p * store->words + w];
+        }
+        total += __builtin_popcountll(bits);
+    }
+    return (int)total;
+}
+
+int user_store_count_risk_at_least(const UserStore *store, int threshold) {
+    if (threshold <= 0) return store->count;
+    if (threshold > 255) return 0;
+    // Branch-free byte compare; the compiler vectorizes this reduction
+    const uint8_t limit = (uint8_t)threshold;
+    int total = 0;
+    for (int i = 0; i < store->count; i++) {
+        total += store->risk[i] >= limit;
+    }
+    return total;
+}
+
+int user_store_count_classified(const UserStore *store) {
+    int total = 0;
+    for (int i = 0; i < store->count; i++) {
+        total += (store->perm_bits[i] | store->risk[i]) != 0;
+    }
+    return total;
+}
@@ -0,0 +1,60 @@
+#include "wellknown.h"
+#include <stdio.h>
+#include <string.h>
+
+static long lookup_hits;
+static long lookup_misses;
+
+const WellKnownEntry *wellknown_lookup(const char *key) {
+    size_t len = strlen(key);
+    uint32_t slot = wellknown_hash(key, len, wellknown_seed) & (wellknown_slots - 1);
+    const WellKnownEntry *entry = &wellknown_table[slot];
+    return entry->key && strcmp(entry->key, key) == 0 ? entry : NULL;
+}
+
+static const WellKnownEntry *count_lookup(const WellKnownEntry *entry) {
+    __atomic_fetch_add(entry ? &lookup_hits : &lookup_misses, 1, __ATOMIC_RELAXED);
+    return entry;
+}
+
+const WellKnownEntry *wellknown_sid(const char *sid) {
+    const WellKnownEntry *entry = wellknown_lookup(sid);
+    if (entry) return count_lookup(entry);
+
+    // S-1-5-21-<a>-<b>-<c>-<rid>: domain principals are well known by RID
+    if (strncmp(sid, "S-1-5-21-", 9) == 0) {
+        const char *rid = strrchr(sid, '-');
+        int dashes = 0;
+        for (const char *p = sid; *p; p++) {
+            if (*p == '-') dashes++;
+        }
+        if (dashes == 7) {
+            char key[32];
+            snprintf(key, sizeof(key), "DOMAIN%s", rid);
+            entry = wellknown_lookup(key);
+        }
+    }
+    return count_lookup(entry);
+}
+
+int wellknown_expected_holder(const char *sid) {
+    const WellKnownEntry *entry = wellknown_sid(sid);
+    return entry && entry->holder == WELLKNOWN_HOLDER_EXPECTED;
+}
+
+void guid_format(const uint8_t *g, char out[37]) {
+    snprintf(out, 37, "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+             g[3], g[2], g[1], g[0], g[5], g[4], g[7], g[6],
+             g[8], g[9], g[10], g[11], g[12], g[13], g[14], g[15]);
+}
+
+const WellKnownEntry *wellknown_guid(const uint8_t *guid) {
+    char key[37];
+    guid_format(guid, key);
+    return count_lookup(wellknown_lookup(key));
+}
+
+void wellknown_stats(long *hits, long *misses) {
+    if (hits) *hits = __atomic_load_n(&lookup_hits, __ATOMIC_RELAXED);
+    if (misses) *misses = __atomic_load_n(&lookup_misses, __ATOMIC_RELAXED);
+}
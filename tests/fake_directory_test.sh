@@ -0,0 +1,218 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# LDAP checks against tests/fake_ldap.py serving tests/fixtures/directory.json
+# - delta scans pick up group membership changes (memberOf is a back-link)
+# - a delta state recorded on another domain controller is re-seeded
+# - the legacy CSV export keeps each user on one 12-field row
+# - ACE rights in nTSecurityDescriptor reach the CSV flags and rights --json
+# - OU ACEs are inherited by the objects beneath them as Active Directory would
+# - membership nested through several groups is privileged; nesting cycles end
+# - attack paths run through ACEs on groups and through control of OUs
+# - malformed security descriptors are counted and logged once
+
+if ! command -v python3 > /dev/null; then
+  echo "[SKIP] python3 not found; the fake directory needs it." >&2
+  exit 0
+fi
+
+echo "[*] Building..."
+make
+
+WORK="$(mktemp -d)"
+SERVER_PID=""
+cleanup() {
+  if [[ -n "$SERVER_PID" ]]; then kill "$SERVER_PID" 2> /dev/null || true; fi
+  rm -rf "$WORK"
+}
+trap cleanup EXIT
+
+cp tests/fixtures/directory.json "$WORK/directory.json"
+python3 tests/fake_ldap.py "$WORK/directory.json" "$WORK/port" &
+SERVER_PID=$!
+for _ in $(seq 50); do
+  [[ -f "$WORK/port" ]] && break
+  sleep 0.1
+done
+
+export ACLGUARD_LDAP_URI="ldap://127.0.0.1:$(cat "$WORK/port")"
+export ACLGUARD_BIND_DN="cn=admin" ACLGUARD_BIND_PW="x" ACLGUARD_BASE_DN="DC=example,DC=local"
+export ACLGUARD_STATE_DIR="$WORK/state"
+
+# Apply a Python statement to the fixture, bound as d
+edit_directory() {
+  python3 - "$WORK/directory.json" "$1" <<'PY'
+import json, sys
+d = json.load(open(sys.argv[1]))
+exec(sys.argv[2])
+json.dump(d, open(sys.argv[1], 'w'))
+PY
+}
+
+privileged() {
+  grep -q "\"type\":\"Privileged Group Change\".*\"user\":\"$1\"" <<< "$OUT"
+}
+
+# set -e does not apply to a negated command, so report and exit explicitly
+fail() {
+  echo "[!] $1" >&2
+  exit 1
+}
+
+echo "[*] Exporting CSV..."
+(cd "$WORK" && "$OLDPWD/aclguard" --export-csv > /dev/null)
+python3 - "$WORK/aclguard_users.csv" <<'PY'
+import csv, sys
+rows = list(csv.reader(open(sys.argv[1], newline='')))
+assert len(rows) == 28, rows
+assert all(len(row) == 12 for row in rows), rows
+groups = {row[0]: row[3] for row in rows[1:]}
+assert groups['carol'] == 'CN=Staff,OU=Groups,DC=example,DC=local;CN=Remote Desktop Users,CN=Builtin,DC=example,DC=local', groups
+# CanResetPass, CanModifyACL, CanDelegate, CanReadSecrets, CanWriteSecrets from
+# victor's descriptor, the OU=Corp tree and Server Admins' descriptor; carol's
+# ModifyACL comes from her group, not the deny ACE
+flags = {row[0]: ''.join(row[i] for i in (5, 6, 7, 9, 10)) for row in rows[1:]}
+expected = {'alice': '00000', 'bob': '00000', 'carol': '01000', 'victor': '00000',
+            'erin': '11111', 'frank': '01000', 'gina': '01000', 'heidi': '10000', 'ivan': '00010',
+            'judy': '00001', 'mallory': '00001', 'oscar': '00100', 'peggy': '11111',
+            'quinn': '00010', 'rita': '10000', 'sam': '01000', 'tina': '11111', 'uma': '01000',
+            'xena': '10000', 'zed': '00000', 'yuri': '00000', 'walt': '00000', 'wendy': '00000',
+            'pat': '00000', 'nina': '00000', 'lou': '00000', 'dave': '00000'}
+assert flags == expected, flags
+PY
+grep -qF ',"CN=Staff,OU=Groups,DC=example,DC=local;CN=Remote Desktop Users,CN=Builtin,DC=example,DC=local",' \
+  "$WORK/aclguard_users.csv"
+
+echo "[*] Listing ACE rights..."
+./aclguard rights --json > "$WORK/rights.json"
+python3 - "$WORK/rights.json" <<'PY'
+import json, sys
+data = json.load(open(sys.argv[1]))['data']
+grants = {(r['object'], r['trustee']): (r['type'], r['rights'], r['inherited']) for r in data['rights']
+          if r['object'] == 'victor'}
+assert grants == {
+    ('victor', 'gina'): ('user', ['modify_acl'], False),
+    ('victor', 'erin'): ('user', ['reset_password', 'modify_acl', 'delegate_auth', 'read_secrets', 'write_secrets'], False),
+    ('victor', 'frank'): ('user', ['modify_acl'], False),
+    ('victor', 'heidi'): ('user', ['reset_password'], False),
+    ('victor', 'ivan'): ('user', ['read_secrets'], False),
+    ('victor', 'judy'): ('user', ['write_secrets'], False),
+    ('victor', 'mallory'): ('user', ['write_secrets'], False),
+    ('victor', 'oscar'): ('user', ['delegate_auth'], False),
+    ('victor', 'CN=Helpdesk,OU=Groups,DC=example,DC=local'): ('user', ['reset_password'], False),
+}, grants
+helpdesk = [r for r in data['rights'] if r['trustee'].startswith('CN=Helpdesk')][0]
+assert helpdesk['sid'] == 'S-1-5-21-1004336348-1177238915-682003330-1120', helpdesk
+PY
+
+echo "[*] Inheriting ACE rights from OUs..."
+python3 - "$WORK/rights.json" <<'PY'
+import json, sys
+data = json.load(open(sys.argv[1]))['data']
+grants = {(r['object'], r['trustee']): (r['type'], r['rights'], r['inherited']) for r in data['rights']
+          if r['object'] != 'victor'}
+everything = ['reset_password', 'modify_acl', 'delegate_auth', 'read_secrets', 'write_secrets']
+# Inherit-only ACEs grant nothing over the OU itself; sam's ACE is limited to
+# groups, tina's stops at direct children, OU=Vault and pat block inheritance,
+# and the stale inherited ACE for zed on yuri is replaced by the tree's grants
+assert grants == {
+    ('DC=example,DC=local', 'quinn'): ('container', ['read_secrets'], False),
+    ('OU=Corp,DC=example,DC=local', 'uma'): ('container', ['modify_acl'], False),
+    ('OU=Staff,OU=Corp,DC=example,DC=local', 'tina'): ('container', everything, True),
+    ('CN=Server Admins,OU=Groups,DC=example,DC=local', 'CN=Helpdesk,OU=Groups,DC=example,DC=local'): ('group', everything, False),
+    ('yuri', 'sam'): ('user', ['modify_acl'], False),
+    ('yuri', 'rita'): ('user', ['reset_password'], True),
+    ('yuri', 'tina'): ('user', everything, True),
+    ('walt', 'rita'): ('user', ['reset_password'], True),
+    ('dave', 'rita'): ('user', ['reset_password'], True),
+    ('wendy', 'xena'): ('user', ['reset_password'], True),
+}, grants
+assert data['containers'] == 4 and data['inherited'] == 6, data
+PY
+./aclguard rights --principal rita --json > "$WORK/rights.json"
+./aclguard rights --principal S-1-5-21-1004336348-1177238915-682003330-1122 --json > "$WORK/rights_sid.json"
+python3 - "$WORK/rights.json" "$WORK/rights_sid.json" <<'PY'
+import json, sys
+for path in sys.argv[1:]:
+    rights = json.load(open(path))['data']['rights']
+    assert sorted((r['object'], r['trustee'], r['inherited']) for r in rights) == [
+        ('dave', 'rita', True), ('walt', 'rita', True), ('yuri', 'rita', True)], rights
+PY
+
+echo "[*] Nesting groups into Domain Admins..."
+# nina is in Tier1 Ops, nested three levels into Domain Admins; lou is in a
+# Loop A / Loop B cycle that leads nowhere
+OUT="$(./aclguard alerts --recent --ndjson 2> "$WORK/err")"
+privileged nina
+if privileged lou; then fail "lou is only in a nesting cycle"; fi
+OUT="$(./aclguard metrics --scale --json 2> "$WORK/err")"
+grep -q '"group_nesting_cycles":1' <<< "$OUT"
+
+echo "[*] Finding attack paths..."
+./aclguard paths --json > "$WORK/paths.json"
+python3 - "$WORK/paths.json" <<'PY'
+import json, sys
+data = json.load(open(sys.argv[1]))['data']
+paths = {p['user']: [(s['edge'], s['to'].split(',')[0]) for s in p['path']] for p in data['paths']}
+# Helpdesk holds GenericAll over Server Admins, nested into Domain Admins
+assert paths['peggy'] == [('member_of', 'CN=Helpdesk'), ('ace', 'CN=Server Admins'),
+                          ('member_of', 'CN=Infra Admins'), ('member_of', 'CN=Domain Admins')], paths['peggy']
+# WriteDACL on OU=Corp reaches dave beneath OU=Staff; pat, directly in OU=Corp,
+# is closer but protects its DACL
+assert paths['uma'] == [('ace', 'OU=Corp'), ('contains', 'OU=Staff'), ('contains', 'dave'),
+                        ('member_of', 'CN=Domain Admins')], paths['uma']
+assert paths['tina'] == [('ace', 'OU=Staff'), ('contains', 'dave'),
+                         ('member_of', 'CN=Domain Admins')], paths['tina']
+assert 'lou' not in paths and 'sam' not in paths, paths
+PY
+
+echo "[*] Seeding delta state..."
+OUT="$(./aclguard alerts --recent --ndjson --delta 2> "$WORK/err")"
+privileged alice
+if privileged bob; then fail "bob is not in Domain Admins yet"; fi
+
+echo "[*] Adding a member to Domain Admins..."
+# Only the group's uSNChanged moves; the user's memberOf follows without one
+edit_directory '
+e = {x["dn"].split(",")[0]: x for x in d["entries"]}
+e["CN=Domain Admins"]["attrs"]["member"].append(e["CN=Bob Builder"]["dn"])
+e["CN=Domain Admins"]["attrs"]["uSNChanged"] = "2001"
+e["CN=Bob Builder"]["attrs"]["memberOf"].append(e["CN=Domain Admins"]["dn"])
+d["rootdse"]["highestCommittedUSN"] = "2001"
+'
+OUT="$(./aclguard alerts --recent --ndjson --delta 2> "$WORK/err")"
+if grep -q "full scan" "$WORK/err"; then fail "delta scan fell back to a full scan"; fi
+privileged alice
+privileged bob
+
+echo "[*] Removing a member from Domain Admins..."
+edit_directory '
+e = {x["dn"].split(",")[0]: x for x in d["entries"]}
+e["CN=Domain Admins"]["attrs"]["member"].remove(e["CN=Alice Admin"]["dn"])
+e["CN=Domain Admins"]["attrs"]["uSNChanged"] = "2002"
+e["CN=Alice Admin"]["attrs"]["memberOf"] = []
+d["rootdse"]["highestCommittedUSN"] = "2002"
+'
+OUT="$(./aclguard alerts --recent --ndjson --delta 2> "$WORK/err")"
+if grep -q "full scan" "$WORK/err"; then fail "delta scan fell back to a full scan"; fi
+if privileged alice; then fail "alice left Domain Admins"; fi
+privileged bob
+
+echo "[*] Switching domain controller..."
+edit_directory 'd["rootdse"]["dsServiceName"] = d["rootdse"]["dsServiceName"].replace("DC01", "DC02")'
+OUT="$(./aclguard alerts --recent --ndjson --delta 2> "$WORK/err")"
+grep -q "re-seed" "$WORK/err"
+grep -q "DC02" "$WORK/state"/*.json
+privileged bob
+
+echo "[*] Reading malformed security descriptors..."
+edit_directory '
+e = {x["dn"].split(",")[0]: x for x in d["entries"]}
+e["CN=Bob Builder"]["attrs"]["nTSecurityDescriptor"] = {"hex": "0100048c"}
+e["CN=Carol Clerk"]["attrs"]["nTSecurityDescriptor"] = {"hex": "0100048c14000000"}
+'
+OUT="$(./aclguard metrics --scale --json 2> "$WORK/err")"
+grep -q '"malformed_security_descriptors":2' <<< "$OUT"
+[[ "$(grep -c "malformed nTSecurityDescriptor" "$WORK/err")" == 1 ]] || fail "malformed descriptors not logged once"
+
+exit 0
@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+"""Minimal LDAPv3 server over a JSON fixture, for tests that need a directory.
+
+Usage: fake_ldap.py <fixture.json> <port-file>
+
+Listens on an ephemeral localhost port and writes it to port-file. Supports
+simple bind, search (base/one/subtree scope, and/or/not/equality/ordering/
+presence/substring filters, paged results) and unbind. The fixture is read
+again for every connection, so a test can edit it between runs.
+
+Fixture layout: {"rootdse": {attr: value}, "entries": [{"dn": ...,
+"objectClass": [...], "attrs": {attr: value | [values]}}]}. Binary values
+are written {"hex": ...} or {"base64": ...}; objectClass defaults to a user.
+"""
+import base64
+import json
+import os
+import socketserver
+import sys
+
+PAGED_RESULTS_OID = '1.2.840.113556.1.4.319'
+
+
+def enc_len(n):
+    if n < 0x80:
+        return bytes([n])
+    b = n.to_bytes((n.bit_length() + 7) // 8, 'big')
+    return bytes([0x80 | len(b)]) + b
+
+
+def tlv(tag, body):
+    return bytes([tag]) + enc_len(len(body)) + body
+
+
+def enc_int(v, tag=0x02):
+    n = max(1, (v.bit_length() + 8) // 8)
+    return tlv(tag, v.to_bytes(n, 'big', signed=True))
+
+
+def octets(s, tag=0x04):
+    return tlv(tag, s.encode() if isinstance(s, str) else s)
+
+
+def seq(*items, tag=0x30):
+    return tlv(tag, b''.join(items))
+
+
+def dec(buf, pos=0):
+    tag = buf[pos]
+    length = buf[pos + 1]
+    pos += 2
+    if length & 0x80:
+        nb = length & 0x7f
+        length = int.from_bytes(buf[pos:pos + nb], 'big')
+        pos += nb
+    return tag, buf[pos:pos + length], pos + length
+
+
+def dec_all(body):
+    out, pos = [], 0
+    while pos < len(body):
+        t, v, pos = dec(body, pos)
+        out.append((t, v))
+    return out
+
+
+def parse_filter(t, v):
+    if t in (0xa0, 0xa1):
+        return ('and' if t == 0xa0 else 'or', [parse_filter(a, b) for a, b in dec_all(v)])
+    if t == 0xa2:
+        a, b, _ = dec(v)
+        return ('not', parse_filter(a, b))
+    if t in (0xa3, 0xa5, 0xa6, 0xa8):
+        (_, attr), (_, val) = dec_all(v)
+        return ({0xa3: 'eq', 0xa5: 'ge', 0xa6: 'le', 0xa8: 'eq'}[t], attr.decode().lower(), val.decode('latin1'))
+    if t == 0x87:
+        return ('present', v.decode().lower())
+    if t == 0xa4:
+        (_, attr), (_, subs) = dec_all(v)
+        return ('sub', attr.decode().lower(), [(st, sv.decode('latin1').lower()) for st, sv in dec_all(subs)])
+    return ('true',)
+
+
+def value_bytes(v):
+    if isinstance(v, dict):
+        return base64.b64decode(v['base64']) if 'base64' in v else bytes.fromhex(v['hex'])
+    return str(v).encode()
+
+
+def entry_attrs(entry):
+    attrs = dict(entry['attrs'])
+    if 'dn' in entry and entry['dn'] and not any(k.lower() == 'objectclass' for k in attrs):
+        attrs['objectClass'] = entry.get('objectClass', ['top', 'person', 'user'])
+    return attrs
+
+
+def attr_vals(entry, name):
+    for key, vals in entry_attrs(entry).items():
+        if key.lower() == name:
+            vals = vals if isinstance(vals, list) else [vals]
+            return [value_bytes(v).decode('latin1') for v in vals]
+    return []
+
+
+def compare(a, b):
+    try:
+        return int(a) - int(b)
+    except ValueError:
+        return (a.lower() > b.lower()) - (a.lower() < b.lower())
+
+
+def substring_match(value, parts):
+    pos = 0
+    for st, sv in parts:
+        if st == 0x80:
+            if not value.startswith(sv):
+                return False
+            pos = len(sv)
+        elif st == 0x81:
+            i = value.find(sv, pos)
+            if i < 0:
+                return False
+            pos = i + len(sv)
+        elif not value.endswith(sv) or len(value) - len(sv) < pos:
+            return False
+    return True
+
+
+def match(f, entry):
+    kind = f[0]
+    if kind == 'true':
+        return True
+    if kind == 'and':
+        return all(match(x, entry) for x in f[1])
+    if kind == 'or':
+        return any(match(x, entry) for x in f[1])
+    if kind == 'not':
+        return not match(f[1], entry)
+    vals = attr_vals(entry, f[1])
+    if kind == 'present':
+        return bool(vals)
+    if kind == 'eq':
+        return any(x.lower() == f[2].lower() for x in vals)
+    if kind == 'ge':
+        return any(compare(x, f[2]) >= 0 for x in vals)
+    if kind == 'le':
+        return any(compare(x, f[2]) <= 0 for x in vals)
+    return any(substring_match(x.lower(), f[2]) for x in vals)
+
+
+def in_scope(dn, base, scope):
+    dn, base = dn.lower(), base.lower()
+    if scope == 0:
+        return dn == base
+    if base and not (dn == base or dn.endswith(',' + base)):
+        return False
+    if scope == 1:
+        return dn != base and dn[:len(dn) - len(base) - 1].count(',') == 0
+    return True
+
+
+class Handler(socketserver.BaseRequestHandler):
+    def handle(self):
+        with open(self.server.fixture) as fp:
+            self.data = json.load(fp)
+        buf = b''
+        while True:
+            try:
+                chunk = self.request.recv(65536)
+            except ConnectionResetError:
+                return
+            if not chunk:
+                return
+            buf += chunk
+            while len(buf) >= 2:
+                try:
+                    _, body, end = dec(buf)
+                except IndexError:
+                    break
+                if end > len(buf):
+                    break
+                buf = buf[end:]
+                parts = dec_all(body)
+                mid = int.from_bytes(parts[0][1], 'big', signed=True)
+                op, op_body = parts[1]
+                controls = {}
+                if len(parts) > 2 and parts[2][0] == 0xa0:
+                    for _, control in dec_all(parts[2][1]):
+                        fields = dec_all(control)
+                        controls[fields[0][1].decode()] = next((v for t, v in fields[1:] if t == 0x04), None)
+                if op == 0x60:
+                    self.send(mid, seq(enc_int(0, 0x0a), octets(''), octets(''), tag=0x61))
+                elif op == 0x42:
+                    return
+                elif op == 0x63:
+                    self.search(mid, op_body, controls)
+
+    def send(self, mid, op, controls=b''):
+        self.request.sendall(seq(enc_int(mid), op, controls))
+
+    def done(self, mid, code=0, message='', controls=b''):
+        self.send(mid, seq(enc_int(code, 0x0a), octets(''), octets(message), tag=0x65), controls)
+
+    def search(self, mid, body, controls):
+        p = dec_all(body)
+        base, scope = p[0][1].decode(), p[1][1][0]
+        filt = parse_filter(p[6][0], p[6][1])
+        want = [v.decode().lower() for _, v in dec_all(p[7][1])]
+        if base == '' and scope == 0:
+            entries = [{'dn': '', 'attrs': self.data.get('rootdse', {})}]
+        else:
+            known = [e for e in self.data['entries'] if in_scope(e['dn'], base, 2)]
+            if not known:
+                self.done(mid, 32, 'no such object')
+                return
+            entries = [e for e in known if in_scope(e['dn'], base, scope) and match(filt, e)]
+
+        response_controls = b''
+        if PAGED_RESULTS_OID in controls:
+            size, cookie = [v for _, v in dec_all(dec(controls[PAGED_RESULTS_OID])[1])]
+            size = int.from_bytes(size, 'big') or len(entries)
+            start = int(cookie.decode()) if cookie else 0
+            following = str(start + size).encode() if start + size < len(entries) else b''
+            entries = entries[start:start + size]
+            response_controls = tlv(0xa0, seq(octets(PAGED_RESULTS_OID),
+                                               octets(seq(enc_int(len(entries)), octets(following)))))
+        for entry in entries:
+            self.send_entry(mid, entry, want)
+        self.done(mid, controls=response_controls)
+
+    def send_entry(self, mid, entry, want):
+        attrs = b''
+        for key, vals in entry_attrs(entry).items():
+            if want and '*' not in want and key.lower() not in want:
+                continue
+            vals = vals if isinstance(vals, list) else [vals]
+            encoded = [octets(value_bytes(v)) for v in vals]
+            attrs += seq(octets(key), tlv(0x31, b''.join(encoded)))
+        self.send(mid, seq(octets(entry['dn']), seq(attrs), tag=0x64))
+
+
+class Server(socketserver.ThreadingTCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+
+if __name__ == '__main__':
+    server = Server(('127.0.0.1', 0), Handler)
+    server.fixture = sys.argv[1]
+    with open(sys.argv[2] + '.tmp', 'w') as fp:
+        fp.write('%d\n' % server.server_address[1])
+    # Publish the port only once it is complete
+    os.rename(sys.argv[2] + '.tmp', sys.argv[2])
+    server.serve_forever()
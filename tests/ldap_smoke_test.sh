@@ -14,14 +14,35 @@ echo "[*] Running LDAP status..."
 
 echo "[*] Running LDAP alerts..."
 ./aclguard alerts --recent --json | grep -q '"summary"'
+OUT="$(./aclguard alerts --recent --ndjson)"
+[[ "$OUT" == '{"id":"AL-LDAP-'* ]]
 
 echo "[*] Running LDAP correlate..."
 ./aclguard correlate --attack kerberoasting --json | grep -q '"summary"'
 
 echo "[*] Running LDAP analyze..."
 ./aclguard analyze --incident latest --json | grep -q '"summary"'
+OUT="$(./aclguard analyze --incident all --ndjson)"
+[[ "$OUT" == '{"id":"INC-LDAP-'* ]]
 
 echo "[*] Running LDAP metrics..."
 ./aclguard metrics --throughput --json | grep -q '"summary"'
 
+echo "[*] Running LDAP paths..."
+./aclguard paths --json | grep -q '"summary"'
+
+echo "[*] Running LDAP rights..."
+./aclguard rights --json | grep -q '"rights"'
+
+echo "[*] Running LDAP report..."
+./aclguard report --json | grep -q '"correlations"'
+
+echo "[*] Running LDAP snapshot..."
+SNAPSHOT="$(mktemp)"
+trap 'rm -f "$SNAPSHOT"' EXIT
+./aclguard status --json --save-snapshot "$SNAPSHOT" > /dev/null
+diff <(./aclguard alerts --recent --json) <(./aclguard alerts --recent --json --snapshot "$SNAPSHOT")
+diff <(./aclguard correlate --attack kerberoasting --json) <(./aclguard correlate --attack kerberoasting --json --snapshot "$SNAPSHOT")
+./aclguard status --json --snapshot "$SNAPSHOT" | grep -q '"summary"'
+
 exit 0
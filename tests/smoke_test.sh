@@ -19,6 +19,14 @@ OUT="$(./aclguard --mock alerts --recent --json)"
 echo "$OUT" | grep -q "\"summary\""
 echo "$OUT" | grep -q "\"recent\""
 
+echo "[*] Running mock alerts (NDJSON)..."
+OUT="$(./aclguard --mock alerts --recent --ndjson)"
+[ "$(echo "$OUT" | wc -l)" -gt 1 ]
+if echo "$OUT" | grep -qv '^{"id":'; then
+  echo "[!] NDJSON line is not one alert record" >&2
+  exit 1
+fi
+
 echo "[*] Running mock correlate..."
 OUT="$(./aclguard --mock correlate --attack kerberoasting --json)"
 echo "$OUT" | grep -q "\"summary\""
@@ -29,11 +37,33 @@ OUT="$(./aclguard --mock analyze --incident latest --json)"
 echo "$OUT" | grep -q "\"summary\""
 echo "$OUT" | grep -q "\"title\""
 
+OUT="$(./aclguard --mock analyze --incident all --ndjson)"
+[[ "$OUT" == '{"id":'* ]]
+
 echo "[*] Running mock metrics..."
 OUT="$(./aclguard --mock metrics --throughput --json)"
 echo "$OUT" | grep -q "\"summary\""
 echo "$OUT" | grep -q "\"metric\""
 
+echo "[*] Running mock paths..."
+OUT="$(./aclguard --mock paths --json)"
+echo "$OUT" | grep -q "\"summary\""
+echo "$OUT" | grep -q "\"paths\""
+
+echo "[*] Running mock rights..."
+OUT="$(./aclguard --mock rights --principal helpdesk.bob --json)"
+echo "$OUT" | grep -q "\"rights\""
+echo "$OUT" | grep -q "carol.sales"
+
+echo "[*] Running mock report..."
+OUT="$(./aclguard --mock report --sections status,correlations --json)"
+echo "$OUT" | grep -q "\"correlations\""
+echo "$OUT" | grep -q "\"alerts_total\""
+if echo "$OUT" | grep -q "\"recent\""; then
+  echo "[!] report included an unselected section" >&2
+  exit 1
+fi
+
 echo "[*] Running simulation script..."
 python3 scripts/simulate_kerberoasting.py >/dev/null
 OUT="$(./aclguard --mock alerts --recent --json)"
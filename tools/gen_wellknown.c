@@ -0,0 +1,198 @@
+// Build-time generator for src/wellknown_table.c: reads data/wellknown.tsv and
+// searches for a seed under which wellknown_hash() gives every key its own
+// slot, then writes the table in slot order.
+//
+//   tools/gen_wellknown data/wellknown.tsv > src/wellknown_table.c
+#include "wellknown.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_ENTRIES 1024
+#define MAX_SEED 10000000u
+
+typedef struct {
+    char *key;
+    char *name;
+    const char *kind;
+    char perms[160];
+    const char *holder;
+} Row;
+
+static const struct {
+    const char *column;
+    const char *kind;
+} kinds[] = {
+    {"sid", "WELLKNOWN_SID"},
+    {"domain_rid", "WELLKNOWN_DOMAIN_RID"},
+    {"extended_right", "WELLKNOWN_EXTENDED_RIGHT"},
+    {"attribute", "WELLKNOWN_ATTRIBUTE"},
+    {"class", "WELLKNOWN_CLASS"},
+};
+
+static const struct {
+    const char *column;
+    const char *holder;
+} holders[] = {
+    {"-", "WELLKNOWN_HOLDER_NONE"},
+    {"expected", "WELLKNOWN_HOLDER_EXPECTED"},
+    {"all_users", "WELLKNOWN_HOLDER_ALL_USERS"},
+};
+
+static const struct {
+    const char *name;
+    const char *macro;
+} flags[] = {
+    {"admin", "PERM_ADMIN"},
+    {"reset_password", "PERM_RESET_PASSWORD"},
+    {"modify_acl", "PERM_MODIFY_ACL"},
+    {"delegate_auth", "PERM_DELEGATE_AUTH"},
+    {"service_account", "PERM_SERVICE_ACCT"},
+    {"privileged", "PERM_PRIVILEGED"},
+    {"read_secrets", "PERM_READ_SECRETS"},
+    {"write_secrets", "PERM_WRITE_SECRETS"},
+};
+
+static Row rows[MAX_ENTRIES];
+static int row_count;
+
+// Turn "a,b" into "PERM_A | PERM_B"; returns -1 for an unknown flag
+static int perms_expr(const char *list, char *out, size_t size) {
+    out[0] = '\0';
+    if (strcmp(list, "-") == 0) {
+        snprintf(out, size, "0");
+        return 0;
+    }
+    char buf[160];
+    snprintf(buf, sizeof(buf), "%s", list);
+    for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+        const char *macro = NULL;
+        for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+            if (strcmp(tok, flags[i].name) == 0) macro = flags[i].macro;
+        }
+        if (!macro) return -1;
+        size_t used = strlen(out);
+        snprintf(out + used, size - used, "%s%s", used ? " | " : "", macro);
+    }
+    return 0;
+}
+
+static int load(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "gen_wellknown: cannot open %s\n", path);
+        return -1;
+    }
+
+    char line[512];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        line_no++;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+
+        char *cols[5];
+        int n = 0;
+        for (char *p = line; n < 5; n++) {
+            cols[n] = p;
+            char *tab = strchr(p, '\t');
+            if (!tab) {
+                n++;
+                break;
+            }
+            *tab = '\0';
+            p = tab + 1;
+        }
+        if (n != 5 || row_count == MAX_ENTRIES) {
+            fprintf(stderr, "gen_wellknown: %s:%d: expected kind, key, name, perms, holder\n", path, line_no);
+            fclose(fp);
+            return -1;
+        }
+
+        Row *row = &rows[row_count];
+        row->kind = NULL;
+        for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+            if (strcmp(cols[0], kinds[i].column) == 0) row->kind = kinds[i].kind;
+        }
+        row->holder = NULL;
+        for (size_t i = 0; i < sizeof(holders) / sizeof(holders[0]); i++) {
+            if (strcmp(cols[4], holders[i].column) == 0) row->holder = holders[i].holder;
+        }
+        if (!row->kind || !row->holder || perms_expr(cols[3], row->perms, sizeof(row->perms)) != 0) {
+            fprintf(stderr, "gen_wellknown: %s:%d: unknown kind, flag or holder\n", path, line_no);
+            fclose(fp);
+            return -1;
+        }
+
+        size_t key_len = strlen(cols[1]) + 8;
+        row->key = malloc(key_len);
+        row->name = strdup(cols[2]);
+        if (!row->key || !row->name) {
+            fclose(fp);
+            return -1;
+        }
+        if (strcmp(cols[0], "domain_rid") == 0) {
+            snprintf(row->key, key_len, "DOMAIN-%s", cols[1]);
+        } else {
+            snprintf(row->key, key_len, "%s", cols[1]);
+        }
+        for (int j = 0; j < row_count; j++) {
+            if (strcmp(rows[j].key, row->key) == 0) {
+                fprintf(stderr, "gen_wellknown: %s:%d: duplicate key %s\n", path, line_no, row->key);
+                fclose(fp);
+                return -1;
+            }
+        }
+        row_count++;
+    }
+    fclose(fp);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <wellknown.tsv>\n", argv[0]);
+        return 2;
+    }
+    if (load(argv[1]) != 0) return 1;
+
+    // At a load factor of one quarter a collision-free seed turns up within a
+    // few thousand tries; at one half it would take billions
+    uint32_t slots = 1;
+    while (slots < (uint32_t)row_count * 4) slots <<= 1;
+
+    int *slot_row = malloc(slots * sizeof(int));
+    if (!slot_row) return 1;
+
+    uint32_t seed;
+    for (seed = 0; seed < MAX_SEED; seed++) {
+        memset(slot_row, -1, slots * sizeof(int));
+        int ok = 1;
+        for (int i = 0; i < row_count && ok; i++) {
+            uint32_t slot = wellknown_hash(rows[i].key, strlen(rows[i].key), seed) & (slots - 1);
+            if (slot_row[slot] >= 0) ok = 0;
+            slot_row[slot] = i;
+        }
+        if (ok) break;
+    }
+    if (seed == MAX_SEED) {
+        fprintf(stderr, "gen_wellknown: no collision-free seed for %d keys in %u slots\n", row_count, slots);
+        return 1;
+    }
+
+    printf("// Generated by tools/gen_wellknown from data/wellknown.tsv; do not edit.\n");
+    printf("#include \"wellknown.h\"\n#include \"classifier.h\"\n\n");
+    printf("const uint32_t wellknown_seed = %uu;\n", seed);
+    printf("const uint32_t wellknown_slots = %uu;\n\n", slots);
+    printf("const WellKnownEntry wellknown_table[%u] = {\n", slots);
+    for (uint32_t s = 0; s < slots; s++) {
+        if (slot_row[s] < 0) continue;
+        Row *row = &rows[slot_row[s]];
+        printf("    [%u] = {\"%s\", \"%s\", %s, %s, %s},\n", s, row->key, row->name, row->kind, row->perms,
+               row->holder);
+    }
+    printf("};\n");
+
+    free(slot_row);
+    return 0;
+}